@@ -35,6 +35,10 @@ WZ_DECL_NONNULL(1) bool loadFile(const char *pFileName, char **ppFileData, UDWOR
 /** Save the data in the buffer into the given file */
 WZ_DECL_NONNULL(1) bool saveFile(const char *pFileName, const char *pFileData, UDWORD fileSize);
 
+/** Save the data in the buffer into a temporary file next to the given file, then rename it into place,
+ *  so readers never see a partially written file. Fails quietly (returns false) instead of asserting. */
+WZ_DECL_NONNULL(1) bool saveFileAtomic(const char *pFileName, const char *pFileData, UDWORD fileSize);
+
 /** Load a file from disk into a fixed memory buffer. */
 WZ_DECL_NONNULL(1, 2) bool loadFileToBuffer(const char *pFileName, char *pFileBuffer, UDWORD bufferSize, UDWORD *pSize);
 
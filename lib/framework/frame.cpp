@@ -35,7 +35,10 @@
 #include "input.h"
 #include "file_ext.h"
 
+#include <atomic>
 #include <limits>
+#include <string>
+#include <thread>
 
 /************************************************************************************
  *
@@ -309,6 +312,93 @@ bool saveFile(const char *pFileName, const char *pFileData, UDWORD fileSize)
 	return true;
 }
 
+static std::string realWritePath(const std::string &fileName)
+{
+	std::string path = PHYSFS_getWriteDir();
+	const char *separator = PHYSFS_getDirSeparator();
+	if (path.empty() || path.compare(path.size() - strlen(separator), std::string::npos, separator) != 0)
+	{
+		path += separator;
+	}
+	for (char c : fileName)
+	{
+		if (c == '/')
+		{
+			path += separator;
+		}
+		else
+		{
+			path += c;
+		}
+	}
+	return path;
+}
+
+static bool replaceRealFile(const std::string &fromPath, const std::string &toPath)
+{
+#if defined(WZ_OS_WIN)
+	auto toWide = [](const std::string &utf8) -> std::vector<wchar_t> {
+		int wstr_len = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, NULL, 0);
+		if (wstr_len <= 0)
+		{
+			return {};
+		}
+		std::vector<wchar_t> wstr(wstr_len, 0);
+		if (MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, &wstr[0], wstr_len) == 0)
+		{
+			return {};
+		}
+		return wstr;
+	};
+	std::vector<wchar_t> wFrom = toWide(fromPath);
+	std::vector<wchar_t> wTo = toWide(toPath);
+	if (wFrom.empty() || wTo.empty())
+	{
+		return false;
+	}
+	return MoveFileExW(wFrom.data(), wTo.data(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return std::rename(fromPath.c_str(), toPath.c_str()) == 0;
+#endif
+}
+
+bool saveFileAtomic(const char *pFileName, const char *pFileData, UDWORD fileSize)
+{
+	static std::atomic<uint32_t> tempFileCounter{0};
+	ASSERT_OR_RETURN(false, PHYSFS_getWriteDir() != nullptr, "No write dir");
+
+	// Keep the extension last, so left-over temporary files are still found by WZ_PHYSFS_cleanupOldFilesInFolder
+	std::string fileName = pFileName;
+	std::string tempSuffix = ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000) + "_" + std::to_string(tempFileCounter.fetch_add(1));
+	size_t slash = fileName.rfind('/');
+	size_t dot = fileName.rfind('.');
+	std::string tempFileName = (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		? fileName.substr(0, dot) + tempSuffix + fileName.substr(dot)
+		: fileName + tempSuffix;
+
+	PHYSFS_file *pfile = PHYSFS_openWrite(tempFileName.c_str());
+	if (!pfile)
+	{
+		debug(LOG_WARNING, "Couldn't open %s for writing: %s", tempFileName.c_str(), WZ_PHYSFS_getLastError());
+		return false;
+	}
+	bool written = WZ_PHYSFS_writeBytes(pfile, pFileData, fileSize) == fileSize;
+	if (!PHYSFS_close(pfile) || !written)
+	{
+		debug(LOG_WARNING, "Couldn't write %s: %s", tempFileName.c_str(), WZ_PHYSFS_getLastError());
+		PHYSFS_delete(tempFileName.c_str());
+		return false;
+	}
+
+	if (!replaceRealFile(realWritePath(tempFileName), realWritePath(fileName)))
+	{
+		debug(LOG_WARNING, "Couldn't move %s into place", tempFileName.c_str());
+		PHYSFS_delete(tempFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
 bool loadFile(const char *pFileName, char **ppFileData, UDWORD *pFileSize, bool hard_fail /*= true*/)
 {
 	return loadFile2(pFileName, ppFileData, pFileSize, true, hard_fail);
@@ -26,35 +26,258 @@
 #include "wzconfig.h"
 #include <physfs.h>
 #include "file.h"
-#include <sstream>
+#include <atomic>
+#include <istream>
 #include <limits>
+#include <stdexcept>
+#include <zlib.h>
 #include "physfs_ext.h"
+#include "wzapp.h"
+
+#if defined(__clang__)
+#  pragma clang diagnostic push
+#  pragma clang diagnostic ignored "-Wcast-align"
+#elif defined(__GNUC__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wcast-align"
+#endif
+
+#include <3rdparty/readerwriterqueue/readerwriterqueue.h>
+
+#if defined(__clang__)
+#  pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#  pragma GCC diagnostic pop
+#endif
+
+// Binary document layout:
+// | magic "WZBJ" (uint32 BE) | format version (uint32 BE) | CBOR size (uint32 BE) | zlib-compressed CBOR |
+static const uint32_t binaryDocumentMagic = 0x575A424A; // "WZBJ"
+static const uint32_t currentBinaryDocumentVersion = 1;
+static const size_t binaryDocumentHeaderSize = 3 * sizeof(uint32_t);
+
+struct WzConfigWriteJob
+{
+	std::string filename;
+	nlohmann::json document;
+	WzConfigFormat format = WzConfigFormat::JSON;
+	WZ_SEMAPHORE *pFlushed = nullptr; // if set, this is a flush marker: post once reached
+	bool quit = false;
+};
+
+static moodycamel::BlockingReaderWriterQueue<WzConfigWriteJob> backgroundWriteQueue(64);
+static WZ_THREAD *backgroundWriteThread = nullptr;
+static std::atomic<bool> backgroundWriteFailed(false);
+static optional<WzConfigFormat> backgroundWriteFormat;
+
+static void appendUBE32(std::vector<uint8_t> &output, uint32_t value)
+{
+	output.push_back(static_cast<uint8_t>(value >> 24));
+	output.push_back(static_cast<uint8_t>(value >> 16));
+	output.push_back(static_cast<uint8_t>(value >> 8));
+	output.push_back(static_cast<uint8_t>(value));
+}
+
+static uint32_t readUBE32(const uint8_t *data)
+{
+	return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+// Serialise a document - may be called from the background write thread (throws on failure)
+static std::vector<uint8_t> serialiseJsonDocument(const nlohmann::json &document, WzConfigFormat format)
+{
+	std::vector<uint8_t> output;
+	switch (format)
+	{
+		case WzConfigFormat::JSON:
+		{
+			std::string jsonString = document.dump(4);
+			output.reserve(jsonString.size() + 1);
+			output.assign(jsonString.begin(), jsonString.end());
+			output.push_back('\n');
+			break;
+		}
+		case WzConfigFormat::Binary:
+		{
+			std::vector<uint8_t> cbor = nlohmann::json::to_cbor(document);
+			if (cbor.size() > static_cast<size_t>(std::numeric_limits<uint32_t>::max()))
+			{
+				throw std::length_error("document too large");
+			}
+			uLongf compressedSize = compressBound(static_cast<uLong>(cbor.size()));
+			output.resize(binaryDocumentHeaderSize + compressedSize);
+			if (compress2(&output[binaryDocumentHeaderSize], &compressedSize, cbor.data(), static_cast<uLong>(cbor.size()), Z_DEFAULT_COMPRESSION) != Z_OK)
+			{
+				throw std::runtime_error("zlib compression failed");
+			}
+			output.resize(binaryDocumentHeaderSize + compressedSize);
+			std::vector<uint8_t> header;
+			appendUBE32(header, binaryDocumentMagic);
+			appendUBE32(header, currentBinaryDocumentVersion);
+			appendUBE32(header, static_cast<uint32_t>(cbor.size()));
+			std::copy(header.begin(), header.end(), output.begin());
+			break;
+		}
+	}
+	return output;
+}
+
+// May be called from the background write thread
+static bool writeDocumentFile(const std::string &filename, const nlohmann::json &document, WzConfigFormat format)
+{
+	std::vector<uint8_t> data;
+	try {
+		data = serialiseJsonDocument(document, format);
+	}
+	catch (const std::exception &e) {
+		debug(LOG_ERROR, "Failed to serialise %s: %s", filename.c_str(), e.what());
+		return false;
+	}
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(filename.c_str());
+	if (fileHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open %s for writing: %s", filename.c_str(), WZ_PHYSFS_getLastError());
+		return false;
+	}
+	bool success = WZ_PHYSFS_writeBytes(fileHandle, data.data(), static_cast<PHYSFS_uint32>(data.size())) == static_cast<PHYSFS_sint64>(data.size());
+	if (!success)
+	{
+		debug(LOG_ERROR, "%s could not write: %s", filename.c_str(), WZ_PHYSFS_getLastError());
+	}
+	if (!PHYSFS_close(fileHandle))
+	{
+		debug(LOG_ERROR, "Error closing %s: %s", filename.c_str(), WZ_PHYSFS_getLastError());
+		success = false;
+	}
+	return success;
+}
+
+// This function is run in its own thread! Do not call any non-threadsafe functions!
+static int backgroundWriteThreadFunc(void *)
+{
+	WzConfigWriteJob job;
+	while (true)
+	{
+		backgroundWriteQueue.wait_dequeue(job);
+		if (job.quit)
+		{
+			break;
+		}
+		if (job.pFlushed)
+		{
+			wzSemaphorePost(job.pFlushed);
+			continue;
+		}
+		if (!writeDocumentFile(job.filename, job.document, job.format))
+		{
+			backgroundWriteFailed.store(true);
+		}
+		job.document = nlohmann::json(); // free memory before waiting for the next job
+	}
+	return 0;
+}
+
+nlohmann::json wzParseJsonDocument(const char *data, size_t size)
+{
+	const uint8_t *pBytes = reinterpret_cast<const uint8_t *>(data);
+	if (size < binaryDocumentHeaderSize || readUBE32(pBytes) != binaryDocumentMagic)
+	{
+		return nlohmann::json::parse(data, data + size);
+	}
+	uint32_t version = readUBE32(pBytes + 4);
+	if (version > currentBinaryDocumentVersion)
+	{
+		throw std::runtime_error("unsupported binary document version " + std::to_string(version));
+	}
+	std::vector<uint8_t> cbor(readUBE32(pBytes + 8));
+	uLongf cborSize = static_cast<uLongf>(cbor.size());
+	if (uncompress(cbor.data(), &cborSize, pBytes + binaryDocumentHeaderSize, static_cast<uLong>(size - binaryDocumentHeaderSize)) != Z_OK || cborSize != cbor.size())
+	{
+		throw std::runtime_error("corrupt binary document");
+	}
+	return nlohmann::json::from_cbor(cbor);
+}
+
+bool wzSaveJsonDocument(const std::string &filename, nlohmann::json &&document)
+{
+	if (!backgroundWriteFormat.has_value())
+	{
+		bool result = writeDocumentFile(filename, document, WzConfigFormat::JSON);
+		ASSERT(result, "Failed to save %s", filename.c_str());
+		return result;
+	}
+	if (backgroundWriteThread == nullptr)
+	{
+		backgroundWriteThread = wzThreadCreate(backgroundWriteThreadFunc, nullptr, "wzConfigWriteThread");
+		wzThreadStart(backgroundWriteThread);
+	}
+	WzConfigWriteJob job;
+	job.filename = filename;
+	job.document = std::move(document);
+	job.format = backgroundWriteFormat.value();
+	backgroundWriteQueue.enqueue(std::move(job));
+	return true;
+}
+
+void wzConfigBeginBackgroundWrites(WzConfigFormat format)
+{
+	ASSERT(!backgroundWriteFormat.has_value(), "Background writes section already started");
+	backgroundWriteFormat = format;
+}
+
+void wzConfigEndBackgroundWrites()
+{
+	backgroundWriteFormat.reset();
+}
+
+bool wzConfigWaitForBackgroundWrites()
+{
+	if (backgroundWriteThread != nullptr)
+	{
+		WZ_SEMAPHORE *pFlushed = wzSemaphoreCreate(0);
+		WzConfigWriteJob marker;
+		marker.pFlushed = pFlushed;
+		backgroundWriteQueue.enqueue(std::move(marker));
+		wzSemaphoreWait(pFlushed);
+		wzSemaphoreDestroy(pFlushed);
+	}
+	bool failed = backgroundWriteFailed.exchange(false);
+	return !failed;
+}
+
+void wzConfigShutdownBackgroundWrites()
+{
+	if (backgroundWriteThread == nullptr)
+	{
+		return;
+	}
+	WzConfigWriteJob quitJob;
+	quitJob.quit = true;
+	backgroundWriteQueue.enqueue(std::move(quitJob));
+	wzThreadJoin(backgroundWriteThread);
+	backgroundWriteThread = nullptr;
+}
 
 WzConfig::~WzConfig()
 {
 	if (mWarning == ReadAndWrite)
 	{
 		ASSERT(mObjStack.empty(), "Some json groups have not been closed, stack size %zu.", mObjStack.size());
-		std::ostringstream stream;
-		stream << mRoot.dump(4) << std::endl;
-		std::string jsonString = stream.str();
-#if SIZE_MAX >= UDWORD_MAX
-		ASSERT(jsonString.size() <= static_cast<size_t>(std::numeric_limits<UDWORD>::max()), "jsonString.size (%zu) exceeds UDWORD::max", jsonString.size());
-#endif
-		saveFile(mFilename.toUtf8().c_str(), jsonString.c_str(), static_cast<UDWORD>(jsonString.size()));
+		wzSaveJsonDocument(mFilename.toUtf8(), std::move(mRoot));
 	}
 	debug(LOG_SAVE, "%s %s", mWarning == ReadAndWrite? "Saving" : "Closing", mFilename.toUtf8().c_str());
 }
 
-static nlohmann::json jsonMerge(nlohmann::json original, const nlohmann::json& override)
+// Merges override into original (in place, so the - possibly huge - original document is never copied)
+static void jsonMerge(nlohmann::json &original, const nlohmann::json& override)
 {
 	for (auto it_override = override.begin(); it_override != override.end(); ++it_override)
 	{
-		auto key = it_override.key();
+		const auto &key = it_override.key();
 		auto it_original = original.find(key);
-		if (it_override.value().is_object() && (it_original != original.end()))
+		if (it_override.value().is_object() && (it_original != original.end()) && it_original.value().is_object())
 		{
-			original[key] = jsonMerge(it_original.value(), it_override.value());
+			jsonMerge(it_original.value(), it_override.value());
 		}
 		else if (it_override.value().is_null())
 		{
@@ -65,15 +288,86 @@ static nlohmann::json jsonMerge(nlohmann::json original, const nlohmann::json& o
 			original[key] = it_override.value();
 		}
 	}
-	return original;
+}
+
+// Feeds a PhysFS file to the JSON parser in fixed-size blocks, so a document never has to be loaded into memory in full
+class PhysFSInputStreamBuf : public std::streambuf
+{
+public:
+	PhysFSInputStreamBuf(PHYSFS_file *fileHandle)
+	: fileHandle(fileHandle)
+	{ }
+
+protected:
+	int_type underflow() override
+	{
+		if (gptr() < egptr())
+		{
+			return traits_type::to_int_type(*gptr());
+		}
+		PHYSFS_sint64 length = WZ_PHYSFS_readBytes(fileHandle, buffer, sizeof(buffer));
+		if (length <= 0)
+		{
+			return traits_type::eof();
+		}
+		setg(buffer, buffer, buffer + length);
+		return traits_type::to_int_type(*gptr());
+	}
+
+private:
+	PHYSFS_file *fileHandle;
+	char buffer[64 * 1024];
+};
+
+// Parses a document (in either format) directly from a file. Throws on invalid data, like nlohmann::json::parse.
+static nlohmann::json parseJsonDocumentFile(const char *filename)
+{
+	PHYSFS_file *fileHandle = PHYSFS_openRead(filename);
+	if (fileHandle == nullptr)
+	{
+		throw std::runtime_error(std::string("could not open file: ") + WZ_PHYSFS_getLastError());
+	}
+	PHYSFS_uint32 magic = 0;
+	bool isBinary = PHYSFS_readUBE32(fileHandle, &magic) != 0 && magic == binaryDocumentMagic;
+	PHYSFS_seek(fileHandle, 0);
+	if (isBinary)
+	{
+		// binary documents are compressed as a whole, so simply load them in full
+		PHYSFS_close(fileHandle);
+		UDWORD size = 0;
+		char *data = nullptr;
+		if (!loadFile(filename, &data, &size, false))
+		{
+			throw std::runtime_error("could not read file");
+		}
+		nlohmann::json result;
+		try {
+			result = wzParseJsonDocument(data, size);
+		}
+		catch (...) {
+			free(data);
+			throw;
+		}
+		free(data);
+		return result;
+	}
+	PhysFSInputStreamBuf streamBuf(fileHandle);
+	std::istream stream(&streamBuf);
+	nlohmann::json result;
+	try {
+		result = nlohmann::json::parse(stream);
+	}
+	catch (...) {
+		PHYSFS_close(fileHandle);
+		throw;
+	}
+	PHYSFS_close(fileHandle);
+	return result;
 }
 
 WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 : mArray(nlohmann::json::array())
 {
-	UDWORD size = 0;
-	char *data = nullptr;
-
 	mFilename = name;
 	mStatus = true;
 	mWarning = warning;
@@ -96,16 +390,8 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 			return;
 		}
 	}
-	if (!loadFile(name.toUtf8().c_str(), &data, &size))
-	{
-		mStatus = false;
-		debug(LOG_FATAL, "Could not open \"%s\"", name.toUtf8().c_str());
-		return;
-	}
-	ASSERT_OR_RETURN(, data != nullptr, "Null data?");
-
 	try {
-		mRoot = nlohmann::json::parse(data, data + size);
+		mRoot = parseJsonDocumentFile(name.toUtf8().c_str());
 	}
 	catch (const std::exception &e) {
 		ASSERT(false, "JSON document from %s is invalid: %s", name.toUtf8().c_str(), e.what());
@@ -117,13 +403,11 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 	ASSERT(!mRoot.is_null(), "JSON document from %s is null", name.toUtf8().c_str());
 	if (!mRoot.is_object())
 	{
-		ASSERT(mRoot.is_object(), "JSON document from %s is not an object. Read: \n%s", name.toUtf8().c_str(), data);
+		ASSERT(mRoot.is_object(), "JSON document from %s is not an object", name.toUtf8().c_str());
 		mRoot = nlohmann::json::object();
 		mStatus = false;
-		free(data);
 		return;
 	}
-	free(data);
 	WZ_PHYSFS_enumerateFolders("diffs", [&](const char *i) -> bool {
 		std::string str(std::string("diffs/") + i + std::string("/") + name.toUtf8().c_str());
 		if (!PHYSFS_exists(str.c_str()))
@@ -149,7 +433,7 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 		ASSERT(!tmpJson.is_null(), "JSON diff from %s is null", name.toUtf8().c_str());
 		if (tmpJson.is_object())
 		{
-			mRoot = jsonMerge(mRoot, tmpJson);
+			jsonMerge(mRoot, tmpJson);
 		}
 		else
 		{
@@ -264,7 +548,7 @@ Vector3f WzConfig::vector3f(const WzString &name)
 	{
 		return r;
 	}
-	auto v = it.value();
+	const auto &v = it.value();
 	ASSERT(v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().c_str(), name.toUtf8().c_str());
 	try {
 		r.x = v[0].get<float>();
@@ -293,7 +577,7 @@ Vector3i WzConfig::vector3i(const WzString &name)
 	{
 		return r;
 	}
-	auto v = it.value();
+	const auto &v = it.value();
 	ASSERT(v.size() == 3, "%s: Bad list of %s", mFilename.toUtf8().c_str(), name.toUtf8().c_str());
 	try {
 		r.x = v[0].get<int>();
@@ -322,7 +606,7 @@ Vector2i WzConfig::vector2i(const WzString &name)
 	{
 		return r;
 	}
-	auto v = it.value();
+	const auto &v = it.value();
 	ASSERT(v.size() == 2, "Bad list of %s", name.toUtf8().c_str());
 	try {
 		r.x = v[0].get<int>();
@@ -418,7 +702,7 @@ void WzConfig::endGroup()
 //
 void WzConfig::beginArray(const WzString &name)
 {
-	ASSERT(mArray.empty(), "beginArray() cannot be nested");
+	ASSERT(mArray.empty() && pReadArray == nullptr, "beginArray() cannot be nested");
 	mObjNameStack.push_back(mName);
 	mObjStack.push_back(pCurrentObj);
 	mName = name;
@@ -436,13 +720,15 @@ void WzConfig::beginArray(const WzString &name)
 			return;
 		}
 		ASSERT(it.value().is_array(), "%s: beginArray() on non-array key \"%s\"", mFilename.toUtf8().c_str(), name.toUtf8().c_str());
-		mArray = it.value();
-		if (mArray.size() == 0)
+		// traverse the array in place (read-only documents are never modified)
+		pReadArray = &it.value();
+		mReadArrayIndex = 0;
+		if (pReadArray->size() == 0)
 		{
 			return;
 		}
-		ASSERT(mArray.front().is_object(), "%s: beginArray() on non-object array \"%s\"", mFilename.toUtf8().c_str(), name.toUtf8().c_str());
-		pCurrentObj = &mArray.front();
+		ASSERT(pReadArray->front().is_object(), "%s: beginArray() on non-object array \"%s\"", mFilename.toUtf8().c_str(), name.toUtf8().c_str());
+		pCurrentObj = &pReadArray->front();
 	}
 }
 
@@ -460,12 +746,12 @@ void WzConfig::nextArrayItem()
 	}
 	else
 	{
-		if (!mArray.empty())
+		if (pReadArray != nullptr && mReadArrayIndex < pReadArray->size())
 		{
-			mArray.erase(mArray.begin());
-			if (!mArray.empty())
+			++mReadArrayIndex;
+			if (mReadArrayIndex < pReadArray->size())
 			{
-				pCurrentObj = &mArray.front();
+				pCurrentObj = &(*pReadArray)[mReadArrayIndex];
 			}
 			else
 			{
@@ -478,6 +764,10 @@ void WzConfig::nextArrayItem()
 
 size_t WzConfig::remainingArrayItems()
 {
+	if (mWarning != ReadAndWrite)
+	{
+		return (pReadArray != nullptr) ? pReadArray->size() - mReadArrayIndex : 0;
+	}
 	return mArray.size();
 }
 
@@ -513,6 +803,8 @@ void WzConfig::endArray()
 		mObjNameStack.pop_back();
 		pCurrentObj = mObjStack.back();
 		mObjStack.pop_back();
+		pReadArray = nullptr;
+		mReadArrayIndex = 0;
 	}
 	mArray = nlohmann::json::array();
 }
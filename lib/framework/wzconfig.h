@@ -102,10 +102,12 @@ private:
 	nlohmann::json mRoot = nlohmann::json::object();
 	nlohmann::json *pCurrentObj = nullptr; // the "current" json object
 	nlohmann::json mArray;
+	nlohmann::json *pReadArray = nullptr; // the array being traversed (read-only mode)
+	size_t mReadArrayIndex = 0;
 	WzString mName;
-	std::list<nlohmann::json *> mObjStack;
-	std::list<nlohmann::json> mNewObjStack; // stores newly-created objects (before they are added to root)
-	std::list<WzString> mObjNameStack;
+	std::vector<nlohmann::json *> mObjStack;
+	std::list<nlohmann::json> mNewObjStack; // stores newly-created objects (before they are added to root) - must not move
+	std::vector<WzString> mObjNameStack;
 	WzString mFilename;
 	bool mStatus;
 	warning mWarning;
@@ -251,4 +253,26 @@ inline void from_json(const json& j, vec3& r)
 json_variant json_getValue(const nlohmann::json& json, const WzString &key, const json_variant &defaultValue = json_variant());
 json_variant json_getValue(const nlohmann::json& json, nlohmann::json::size_type idx, const json_variant &defaultValue = json_variant());
 
+// Document (file) formats used when saving through WzConfig / wzSaveJsonDocument
+enum class WzConfigFormat
+{
+	JSON,	// pretty-printed JSON text
+	Binary	// versioned, compact binary encoding (zlib-compressed CBOR)
+};
+
+// Parse a document saved in either format (throws on invalid data, like nlohmann::json::parse)
+nlohmann::json wzParseJsonDocument(const char *data, size_t size);
+
+// Save a document. Inside a background writes section, it is serialised and written by a worker thread
+// in the section's format - otherwise it is immediately written as JSON.
+bool wzSaveJsonDocument(const std::string &filename, nlohmann::json &&document);
+
+// All documents saved between these calls are written in the background (in the order they were saved)
+void wzConfigBeginBackgroundWrites(WzConfigFormat format);
+void wzConfigEndBackgroundWrites();
+// Blocks until all queued background writes have finished. Returns false if any of them failed.
+bool wzConfigWaitForBackgroundWrites();
+// Finishes all queued background writes and stops the worker thread
+void wzConfigShutdownBackgroundWrites();
+
 #endif
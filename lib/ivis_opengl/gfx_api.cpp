@@ -22,6 +22,7 @@
 #include "gfx_api_null.h"
 #include "gfx_api_image_compress_priv.h"
 #include "gfx_api_image_basis_priv.h"
+#include "gfx_api_texture_cache_priv.h"
 #include "lib/framework/physfs_ext.h"
 #include <unordered_map>
 #include <algorithm>
@@ -236,19 +237,59 @@ optional<gfx_api::max_texture_compression_level> gfx_api::getMaxTextureCompressi
 
 #include "png_util.h"
 
-static gfx_api::texture* loadImageTextureFromFile_PNG(const std::string& filename, gfx_api::texture_type textureType, int maxWidth /*= -1*/, int maxHeight /*= -1*/, bool quiet)
+static std::vector<std::unique_ptr<iV_BaseImage>> textureLevelsFromUncompressedImage(iV_Image&& image, gfx_api::texture_type textureType, const std::string& filename, int maxWidth, int maxHeight);
+
+// Describes the compression that would be applied to an image file (for the compressed texture cache key)
+static std::string compressionDescriptionForFile(const std::string& filename, const std::string& formatsDescription)
 {
-	iV_Image loadedUncompressedImage;
+	auto maxCompressionLevel = gfx_api::getMaxTextureCompressionLevelOverride(filename);
+	return formatsDescription + "\n" + ((maxCompressionLevel.has_value()) ? std::to_string(static_cast<int>(maxCompressionLevel.value())) : std::string("-"));
+}
+
+static std::vector<std::unique_ptr<iV_BaseImage>> loadTextureLevelsFromFile_PNG(const std::string& filename, gfx_api::texture_type textureType, int maxWidth, int maxHeight, bool quiet)
+{
+	// 1.) If the image would be run-time compressed, check for cached compressed levels
+	std::string cacheKey;
+	std::string formatsDescription = gfx_api::realTimeCompressionFormatsDescription(gfx_api::pixel_format_target::texture_2d, textureType);
+	if (!formatsDescription.empty())
+	{
+		cacheKey = gfx_api::compressedTextureCacheKey(filename, gfx_api::pixel_format_target::texture_2d, textureType, maxWidth, maxHeight, compressionDescriptionForFile(filename, formatsDescription));
+		if (!cacheKey.empty())
+		{
+			auto cachedLevels = gfx_api::loadCompressedTextureCacheEntry(cacheKey, filename);
+			if (!cachedLevels.empty())
+			{
+				return cachedLevels;
+			}
+		}
+	}
 
-	// 1.) Load the PNG into an iV_Image
+	// 2.) Load the PNG into an iV_Image
+	iV_Image loadedUncompressedImage;
 	bool forceRGB = (textureType == gfx_api::texture_type::game_texture) || (textureType == gfx_api::texture_type::user_interface);
 	if (!iV_loadImage_PNG2(filename.c_str(), loadedUncompressedImage, forceRGB, quiet))
 	{
 		// Failed to load the image
-		return nullptr;
+		return {};
 	}
 
-	return gfx_api::context::get().loadTextureFromUncompressedImage(std::move(loadedUncompressedImage), textureType, filename, maxWidth, maxHeight);
+	// 3.) Convert, resize, and compress
+	auto levels = textureLevelsFromUncompressedImage(std::move(loadedUncompressedImage), textureType, filename, maxWidth, maxHeight);
+	if (!cacheKey.empty())
+	{
+		gfx_api::storeCompressedTextureCacheEntry(cacheKey, filename, levels);
+	}
+	return levels;
+}
+
+static gfx_api::texture* loadImageTextureFromFile_PNG(const std::string& filename, gfx_api::texture_type textureType, int maxWidth /*= -1*/, int maxHeight /*= -1*/, bool quiet)
+{
+	auto levels = loadTextureLevelsFromFile_PNG(filename, textureType, maxWidth, maxHeight, quiet);
+	if (levels.empty())
+	{
+		return nullptr;
+	}
+	return gfx_api::context::get().createTextureFromLevels(std::move(levels), filename);
 }
 
 #if defined(BASIS_ENABLED)
@@ -439,18 +480,18 @@ static std::vector<std::unique_ptr<iV_Image>> generateMipMapsFromUncompressedIma
 	return results;
 }
 
-// Takes an iv_Image and texture_type and loads a texture as appropriate / possible
-gfx_api::texture* gfx_api::context::loadTextureFromUncompressedImage(iV_Image&& image, gfx_api::texture_type textureType, const std::string& filename, int maxWidth /*= -1*/, int maxHeight /*= -1*/)
+// Takes an iv_Image and texture_type and makes the mip levels of a texture as appropriate / possible (converted, resized and compressed - but not uploaded)
+static std::vector<std::unique_ptr<iV_BaseImage>> textureLevelsFromUncompressedImage(iV_Image&& image, gfx_api::texture_type textureType, const std::string& filename, int maxWidth /*= -1*/, int maxHeight /*= -1*/)
 {
 	// 1.) Convert to expected # of channels based on textureType
 	if (!uncompressedPNGImageConvertChannels(image, gfx_api::pixel_format_target::texture_2d, textureType, filename))
 	{
-		return nullptr;
+		return {};
 	}
 
 	// 2.) If maxWidth / maxHeight exceed current image dimensions, resize()
 	bool imgScaleResult = image.scale_image_max_size(maxWidth, maxHeight);
-	ASSERT_OR_RETURN(nullptr, imgScaleResult, "Failed to scale image to max size (%d x %d): %s", maxWidth, maxHeight, filename.c_str());
+	ASSERT_OR_RETURN({}, imgScaleResult, "Failed to scale image to max size (%d x %d): %s", maxWidth, maxHeight, filename.c_str());
 
 	// 3.) Determine mipmap levels (if needed / desired, based on textureType)
 	size_t mipmap_levels = calcMipmapLevelsForUncompressedImage(image, textureType);
@@ -458,12 +499,12 @@ gfx_api::texture* gfx_api::context::loadTextureFromUncompressedImage(iV_Image&&
 	// 4.) Extend channels, if needed, to a supported uncompressed format
 	auto channels = image.channels();
 	// Verify that the gfx backend supports this format
-	auto closestSupportedChannels = getClosestSupportedUncompressedImageFormatChannels(gfx_api::pixel_format_target::texture_2d, channels);
-	ASSERT_OR_RETURN(nullptr, closestSupportedChannels.has_value(), "Exhausted all possible uncompressed formats??");
+	auto closestSupportedChannels = gfx_api::context::get().getClosestSupportedUncompressedImageFormatChannels(gfx_api::pixel_format_target::texture_2d, channels);
+	ASSERT_OR_RETURN({}, closestSupportedChannels.has_value(), "Exhausted all possible uncompressed formats??");
 	for (auto i = image.channels(); i < closestSupportedChannels; ++i)
 	{
 		bool expandResult = image.expand_channels_towards_rgba();
-		ASSERT_OR_RETURN(nullptr, expandResult, "Failed to expand channels: %s", filename.c_str());
+		ASSERT_OR_RETURN({}, expandResult, "Failed to expand channels: %s", filename.c_str());
 	}
 
 	auto uploadFormat = image.pixel_format();
@@ -476,61 +517,101 @@ gfx_api::texture* gfx_api::context::loadTextureFromUncompressedImage(iV_Image&&
 		}
 		else
 		{
-			debug(LOG_WZ, "Texture compression override prevented compressing to %s for file: %s", format_to_str(bestAvailableCompressedFormat.value()), filename.c_str());
+			debug(LOG_WZ, "Texture compression override prevented compressing to %s for file: %s", gfx_api::format_to_str(bestAvailableCompressedFormat.value()), filename.c_str());
 		}
 	}
 
-	// 5.) Create a new compatible gpu texture object
-	std::unique_ptr<gfx_api::texture> pTexture = std::unique_ptr<gfx_api::texture>(gfx_api::context::get().create_texture(mipmap_levels, image.width(), image.height(), uploadFormat, filename));
-
-	// 6.) Upload initial (full) level
-	if (uploadFormat == image.pixel_format())
-	{
-		bool uploadResult = pTexture->upload(0, image);
-		ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
-	}
-	else
+	// 5.) Generate the mipmaps (if needed), each from the uncompressed level before it, and run-time compress (if needed)
+	optional<int> alphaChannelOverride;
+	if (textureType == gfx_api::texture_type::alpha_mask)
 	{
-		// Run-time compression
-		auto compressedImage = gfx_api::compressImage(image, uploadFormat);
-		ASSERT_OR_RETURN(nullptr, compressedImage != nullptr, "Failed to compress image to format: %zu", static_cast<size_t>(uploadFormat));
-		bool uploadResult = pTexture->upload(0, *compressedImage);
-		ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
+		alphaChannelOverride = 0;
 	}
-
-	// 7.) Generate and upload mipmaps (if needed)
-	for (size_t i = 1; i < mipmap_levels; i++)
+	std::vector<std::unique_ptr<iV_BaseImage>> levels;
+	auto pCurrentLevel = std::make_unique<iV_Image>(std::move(image));
+	for (size_t i = 0; i < mipmap_levels; i++)
 	{
-		optional<int> alphaChannelOverride;
-		if (textureType == gfx_api::texture_type::alpha_mask)
+		std::unique_ptr<iV_Image> pNextLevel;
+		if (i + 1 < mipmap_levels)
 		{
-			alphaChannelOverride = 0;
-		}
+			unsigned int output_w = std::max<unsigned int>(1, pCurrentLevel->width() >> 1);
+			unsigned int output_h = std::max<unsigned int>(1, pCurrentLevel->height() >> 1);
 
-		unsigned int output_w = std::max<unsigned int>(1, image.width() >> 1);
-		unsigned int output_h = std::max<unsigned int>(1, image.height() >> 1);
-
-		bool resizeResult = image.resize(output_w, output_h, alphaChannelOverride);
-		ASSERT_OR_RETURN(nullptr, resizeResult, "Failed to resize image mipmap [%zu] to output size (%u x %u): %s", i, output_w, output_h, filename.c_str());
+			pNextLevel = std::make_unique<iV_Image>();
+			bool resizeResult = pNextLevel->resizedFromOther(*pCurrentLevel, output_w, output_h, alphaChannelOverride);
+			ASSERT_OR_RETURN({}, resizeResult, "Failed to resize image mipmap [%zu] to output size (%u x %u): %s", i + 1, output_w, output_h, filename.c_str());
+		}
 
-		if (uploadFormat == image.pixel_format())
+		if (uploadFormat == pCurrentLevel->pixel_format())
 		{
-			bool uploadResult = pTexture->upload(i, image);
-			ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
+			levels.push_back(std::move(pCurrentLevel));
 		}
 		else
 		{
 			// Run-time compression
-			auto compressedImage = gfx_api::compressImage(image, uploadFormat);
-			ASSERT_OR_RETURN(nullptr, compressedImage != nullptr, "Failed to compress image to format: %zu", static_cast<size_t>(uploadFormat));
-			bool uploadResult = pTexture->upload(i, *compressedImage);
-			ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
+			auto compressedImage = gfx_api::compressImage(*pCurrentLevel, uploadFormat);
+			ASSERT_OR_RETURN({}, compressedImage != nullptr, "Failed to compress image to format: %zu", static_cast<size_t>(uploadFormat));
+			levels.push_back(std::move(compressedImage));
 		}
+		pCurrentLevel = std::move(pNextLevel);
+	}
+
+	return levels;
+}
+
+// Takes an iv_Image and texture_type and loads a texture as appropriate / possible
+gfx_api::texture* gfx_api::context::loadTextureFromUncompressedImage(iV_Image&& image, gfx_api::texture_type textureType, const std::string& filename, int maxWidth /*= -1*/, int maxHeight /*= -1*/)
+{
+	auto levels = textureLevelsFromUncompressedImage(std::move(image), textureType, filename, maxWidth, maxHeight);
+	if (levels.empty())
+	{
+		return nullptr;
+	}
+	return createTextureFromLevels(std::move(levels), filename);
+}
+
+gfx_api::texture* gfx_api::context::createTextureFromLevels(std::vector<std::unique_ptr<iV_BaseImage>>&& levels, const std::string& filename)
+{
+	ASSERT_OR_RETURN(nullptr, !levels.empty(), "No image levels: %s", filename.c_str());
+
+	// Create a new compatible gpu texture object
+	std::unique_ptr<gfx_api::texture> pTexture = std::unique_ptr<gfx_api::texture>(create_texture(levels.size(), levels[0]->width(), levels[0]->height(), levels[0]->pixel_format(), filename));
+
+	// Upload image levels to texture
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		bool uploadResult = pTexture->upload(i, *(levels[i]));
+		ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
 	}
 
 	return pTexture.release();
 }
 
+std::vector<std::unique_ptr<iV_BaseImage>> gfx_api::loadTextureLevelsFromFile(const char *filename, gfx_api::texture_type textureType, int maxWidth /*= -1*/, int maxHeight /*= -1*/, bool quiet /*= false*/)
+{
+	auto imageLoadFilename = imageLoadFilenameFromInputFilename(filename);
+
+#if defined(BASIS_ENABLED)
+	if (imageLoadFilename.endsWith(".ktx2"))
+	{
+		// Already compressed, with mip levels - only the ones that fit the max size get transcoded
+		uint32_t maxWidth_u32 = (maxWidth > 0) ? static_cast<uint32_t>(maxWidth) : UINT32_MAX;
+		uint32_t maxHeight_u32 = (maxHeight > 0) ? static_cast<uint32_t>(maxHeight) : UINT32_MAX;
+		return gfx_api::loadiVImagesFromFile_Basis(imageLoadFilename.toUtf8(), textureType, gfx_api::pixel_format_target::texture_2d, nullopt /* auto-detect best possible format */, maxWidth_u32, maxHeight_u32);
+	}
+	else
+#endif
+	if (imageLoadFilename.endsWith(".png"))
+	{
+		return loadTextureLevelsFromFile_PNG(imageLoadFilename.toUtf8(), textureType, maxWidth, maxHeight, quiet);
+	}
+	else
+	{
+		debug(LOG_ERROR, "Unable to load image file: %s", filename);
+		return {};
+	}
+}
+
 std::unique_ptr<iV_Image> gfx_api::loadUncompressedImageFromFile(const char *filename, gfx_api::pixel_format_target target, gfx_api::texture_type textureType, int maxWidth /*= -1*/, int maxHeight /*= -1*/, bool forceRGBA8 /*= false*/)
 {
 	auto imageLoadFilename = imageLoadFilenameFromInputFilename(filename);
@@ -1013,7 +1094,23 @@ gfx_api::texture_array* gfx_api::context::loadTextureArrayFromFiles(const std::v
 		// load the file to an array of base images
 		std::vector<std::unique_ptr<iV_BaseImage>> loadedImagesForLayer;
 		std::vector<std::unique_ptr<iV_BaseImage>>* pImagesForLayer = nullptr;
-		if (imageLoadFilename.isEmpty())
+		std::string layerCacheKey;
+		bool layerInUploadFormat = (uploadFormat == desiredImageExtractionFormat);
+		if (!layerInUploadFormat && imageLoadFilename.endsWith(".png"))
+		{
+			// will be run-time compressed - check for cached compressed levels
+			layerCacheKey = gfx_api::compressedTextureCacheKey(imageLoadFilename.toUtf8(), gfx_api::pixel_format_target::texture_2d_array, textureType, maxWidth, maxHeight, compressionDescriptionForFile(imageLoadFilename.toUtf8(), gfx_api::format_to_str(uploadFormat)));
+			if (!layerCacheKey.empty())
+			{
+				loadedImagesForLayer = gfx_api::loadCompressedTextureCacheEntry(layerCacheKey, imageLoadFilename.toUtf8());
+				layerInUploadFormat = !loadedImagesForLayer.empty() && loadedImagesForLayer.front()->pixel_format() == uploadFormat;
+			}
+		}
+		if (layerInUploadFormat && !loadedImagesForLayer.empty())
+		{
+			pImagesForLayer = &loadedImagesForLayer;
+		}
+		else if (imageLoadFilename.isEmpty())
 		{
 			pImagesForLayer = getDefaultTextureMipsP(layer, width, height, mipmap_levels, desiredImageExtractionFormat);
 			ASSERT_OR_RETURN(nullptr, pImagesForLayer != nullptr, "Failed to generate matching default texture");
@@ -1075,7 +1172,7 @@ gfx_api::texture_array* gfx_api::context::loadTextureArrayFromFiles(const std::v
 		// upload the layer
 
 		// If already in the uploadFormat
-		if (uploadFormat == desiredImageExtractionFormat)
+		if (layerInUploadFormat)
 		{
 			// just load directly
 			bool uploadSuccess = gfx_api::context::get().loadTextureArrayLayerFromBaseImages(*texture_array, layer, *pImagesForLayer, imageLoadFilename.toUtf8(), width, height);
@@ -1086,6 +1183,7 @@ gfx_api::texture_array* gfx_api::context::loadTextureArrayFromFiles(const std::v
 			// convert from (presumably uncompressed) to desired run-time compressed target format (for each mip level)
 			ASSERT_OR_RETURN(nullptr, uncompressedExtractionFormat, "Expected uncompressed extraction format, but received: %s", gfx_api::format_to_str(desiredImageExtractionFormat));
 
+			std::vector<std::unique_ptr<iV_BaseImage>> compressedLevels;
 			for (size_t level = 0; level < pImagesForLayer->size(); ++level)
 			{
 				const iV_Image* image = dynamic_cast<iV_Image*>(pImagesForLayer->at(level).get());
@@ -1095,6 +1193,11 @@ gfx_api::texture_array* gfx_api::context::loadTextureArrayFromFiles(const std::v
 				ASSERT_OR_RETURN(nullptr, compressedImage != nullptr, "Failed to compress image to format: %zu", static_cast<size_t>(uploadFormat));
 				bool uploadResult = texture_array->upload_layer(layer, level, *compressedImage);
 				ASSERT_OR_RETURN(nullptr, uploadResult, "Failed to upload buffer to image");
+				compressedLevels.push_back(std::move(compressedImage));
+			}
+			if (!layerCacheKey.empty() && pImagesForLayer == &loadedImagesForLayer)
+			{
+				gfx_api::storeCompressedTextureCacheEntry(layerCacheKey, imageLoadFilename.toUtf8(), compressedLevels);
 			}
 		}
 	}
@@ -390,6 +390,27 @@ optional<gfx_api::pixel_format> gfx_api::bestRealTimeCompressionFormat(gfx_api::
 	return nullopt;
 }
 
+std::string gfx_api::realTimeCompressionFormatsDescription(gfx_api::pixel_format_target target, gfx_api::texture_type textureType)
+{
+	size_t target_idx = static_cast<size_t>(target);
+	if (textureType != gfx_api::texture_type::game_texture)
+	{
+		// see bestRealTimeCompressionFormatForImage
+		return {};
+	}
+	const auto& rgbaFormat = bestAvailableCompressionFormat_GameTextureRGBA[target_idx];
+	const auto& rgbFormat = bestAvailableCompressionFormat_GameTextureRGB[target_idx];
+	if (!rgbaFormat.has_value() && !rgbFormat.has_value())
+	{
+		return {};
+	}
+	std::string result = "RGBA:";
+	result += (rgbaFormat.has_value()) ? gfx_api::format_to_str(rgbaFormat.value()) : "<none>";
+	result += ",RGB:";
+	result += (rgbFormat.has_value()) ? gfx_api::format_to_str(rgbFormat.value()) : "<none>";
+	return result;
+}
+
 // Compresses an iV_Image to the desired compressed image format (if possible)
 std::unique_ptr<iV_BaseImage> gfx_api::compressImage(const iV_Image& image, gfx_api::pixel_format desiredFormat)
 {
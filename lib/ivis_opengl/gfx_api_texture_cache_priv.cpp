@@ -0,0 +1,286 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "gfx_api_texture_cache_priv.h"
+#include "gfx_api_image_compress_priv.h"
+#include "gfx_api.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/framework/crc.h"
+#include "lib/framework/physfs_ext.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#define TEXTURE_CACHE_DIR "cache/textures"
+#define TEXTURE_CACHE_EXTENSION ".wztc"
+#define TEXTURE_CACHE_MAX_FILES 2048
+static const uint32_t textureCacheVersion = 2; // increment if the way images are resized or compressed changes
+static const char textureCacheMagic[4] = {'W', 'Z', 'T', 'C'};
+
+// Cache entry layout (native byte order - the cache is never shared between systems):
+//   magic, version, pixel format, level count
+//   source file size (uint64), modification time (int64) and SHA-256 of its contents
+//   for each level: width, height, bufferRowLength, bufferImageHeight (uint32), data size (uint64)
+//   the data of each level
+struct TextureCacheLevelHeader
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t bufferRowLength;
+	uint32_t bufferImageHeight;
+	uint64_t dataSize;
+};
+
+static std::mutex textureCacheDirMutex;
+static bool textureCacheDirInitialized = false;
+
+static void initTextureCacheDir()
+{
+	std::lock_guard<std::mutex> guard(textureCacheDirMutex);
+	if (textureCacheDirInitialized)
+	{
+		return;
+	}
+	textureCacheDirInitialized = true;
+	PHYSFS_mkdir(TEXTURE_CACHE_DIR);
+	// bound the size of the cache (entries for changed files / other settings are never used again)
+	WZ_PHYSFS_cleanupOldFilesInFolder(TEXTURE_CACHE_DIR, TEXTURE_CACHE_EXTENSION, TEXTURE_CACHE_MAX_FILES, [](const char *fileName) {
+		if (PHYSFS_delete(fileName) == 0)
+		{
+			debug(LOG_WARNING, "Failed to delete old texture cache file: %s", fileName);
+			return false;
+		}
+		return true;
+	});
+}
+
+static std::string textureCacheFilePath(const std::string& key)
+{
+	return std::string(TEXTURE_CACHE_DIR "/") + key + TEXTURE_CACHE_EXTENSION;
+}
+
+template <typename T>
+static void appendValue(std::vector<char>& buffer, const T& value)
+{
+	const char *pValue = reinterpret_cast<const char *>(&value);
+	buffer.insert(buffer.end(), pValue, pValue + sizeof(T));
+}
+
+template <typename T>
+static bool readValue(const std::vector<char>& buffer, size_t& offset, T& value)
+{
+	if (buffer.size() - offset < sizeof(T))
+	{
+		return false;
+	}
+	memcpy(&value, buffer.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+struct TextureCacheSourceInfo
+{
+	uint64_t size = 0;
+	int64_t modTime = -1;  ///< -1 if the archive the file is in does not record it
+};
+
+static bool getSourceInfo(const std::string& imageLoadFilename, TextureCacheSourceInfo& info)
+{
+#if defined(WZ_PHYSFS_2_1_OR_GREATER)
+	PHYSFS_Stat metaData;
+	if (PHYSFS_stat(imageLoadFilename.c_str(), &metaData) == 0 || metaData.filesize < 0)
+	{
+		return false;
+	}
+	info.size = static_cast<uint64_t>(metaData.filesize);
+	info.modTime = metaData.modtime;
+#else
+	PHYSFS_file *fileHandle = PHYSFS_openRead(imageLoadFilename.c_str());
+	if (fileHandle == nullptr)
+	{
+		return false;
+	}
+	PHYSFS_sint64 fileLength = PHYSFS_fileLength(fileHandle);
+	PHYSFS_close(fileHandle);
+	if (fileLength < 0)
+	{
+		return false;
+	}
+	info.size = static_cast<uint64_t>(fileLength);
+	info.modTime = WZ_PHYSFS_getLastModTime(imageLoadFilename.c_str());
+#endif
+	return true;
+}
+
+static bool hashSourceFile(const std::string& imageLoadFilename, Sha256& output)
+{
+	std::vector<char> fileData;
+	if (!loadFileToBufferVector(imageLoadFilename.c_str(), fileData, false, false))
+	{
+		return false;
+	}
+	output = sha256Sum(fileData.data(), fileData.size());
+	return true;
+}
+
+std::string gfx_api::compressedTextureCacheKey(const std::string& imageLoadFilename, gfx_api::pixel_format_target target, gfx_api::texture_type textureType, int maxWidth, int maxHeight, const std::string& formatDescription)
+{
+	TextureCacheSourceInfo sourceInfo;
+	if (!getSourceInfo(imageLoadFilename, sourceInfo))
+	{
+		return {};
+	}
+	// The real dir is part of the key, so the same path in different mods / data dirs gets different entries
+	std::string keyData = imageLoadFilename + "\n" + WZ_PHYSFS_getRealDir_String(imageLoadFilename.c_str()) + "\n" + std::to_string(sourceInfo.size) + "\n" + std::to_string(sourceInfo.modTime);
+	keyData += "\n" + std::to_string(textureCacheVersion) + "\n" + std::to_string(static_cast<int>(target)) + "\n" + std::to_string(static_cast<int>(textureType)) + "\n" + std::to_string(maxWidth) + "x" + std::to_string(maxHeight) + "\n" + formatDescription;
+	return sha256Sum(keyData.data(), keyData.size()).toString();
+}
+
+std::vector<std::unique_ptr<iV_BaseImage>> gfx_api::loadCompressedTextureCacheEntry(const std::string& key, const std::string& imageLoadFilename)
+{
+	initTextureCacheDir();
+	const std::string cacheFilePath = textureCacheFilePath(key);
+	if (!PHYSFS_exists(cacheFilePath.c_str()))
+	{
+		return {};
+	}
+	std::vector<char> fileData;
+	if (!loadFileToBufferVector(cacheFilePath.c_str(), fileData, false, false))
+	{
+		return {};
+	}
+
+	size_t offset = 0;
+	char magic[4] = {};
+	uint32_t version = 0, format = 0, levelCount = 0;
+	bool headerOk = readValue(fileData, offset, magic) && readValue(fileData, offset, version) && readValue(fileData, offset, format) && readValue(fileData, offset, levelCount);
+	if (!headerOk || memcmp(magic, textureCacheMagic, sizeof(magic)) != 0 || version != textureCacheVersion || levelCount == 0 || format == static_cast<uint32_t>(gfx_api::pixel_format::invalid) || format > static_cast<uint32_t>(gfx_api::MAX_PIXEL_FORMAT))
+	{
+		debug(LOG_WARNING, "Discarding invalid texture cache file: %s", cacheFilePath.c_str());
+		PHYSFS_delete(cacheFilePath.c_str());
+		return {};
+	}
+	TextureCacheSourceInfo storedSourceInfo;
+	Sha256 storedSourceHash;
+	if (!readValue(fileData, offset, storedSourceInfo.size) || !readValue(fileData, offset, storedSourceInfo.modTime) || !readValue(fileData, offset, storedSourceHash.bytes))
+	{
+		debug(LOG_WARNING, "Discarding truncated texture cache file: %s", cacheFilePath.c_str());
+		PHYSFS_delete(cacheFilePath.c_str());
+		return {};
+	}
+	// The key already covers the size and modification time - only fall back to checking the contents if there is no modification time
+	TextureCacheSourceInfo sourceInfo;
+	if (!getSourceInfo(imageLoadFilename, sourceInfo) || sourceInfo.size != storedSourceInfo.size || sourceInfo.modTime != storedSourceInfo.modTime)
+	{
+		return {};
+	}
+	if (sourceInfo.modTime < 0)
+	{
+		Sha256 sourceHash;
+		if (!hashSourceFile(imageLoadFilename, sourceHash) || sourceHash != storedSourceHash)
+		{
+			return {};
+		}
+	}
+
+	std::vector<TextureCacheLevelHeader> levelHeaders(levelCount);
+	for (auto& levelHeader : levelHeaders)
+	{
+		if (!readValue(fileData, offset, levelHeader))
+		{
+			debug(LOG_WARNING, "Discarding truncated texture cache file: %s", cacheFilePath.c_str());
+			PHYSFS_delete(cacheFilePath.c_str());
+			return {};
+		}
+	}
+
+	std::vector<std::unique_ptr<iV_BaseImage>> levels;
+	for (const auto& levelHeader : levelHeaders)
+	{
+		if (fileData.size() - offset < levelHeader.dataSize)
+		{
+			debug(LOG_WARNING, "Discarding truncated texture cache file: %s", cacheFilePath.c_str());
+			PHYSFS_delete(cacheFilePath.c_str());
+			return {};
+		}
+		auto pLevel = std::make_unique<iV_CompressedImage>();
+		if (!pLevel->allocate(static_cast<gfx_api::pixel_format>(format), static_cast<size_t>(levelHeader.dataSize), levelHeader.bufferRowLength, levelHeader.bufferImageHeight, levelHeader.width, levelHeader.height))
+		{
+			return {};
+		}
+		memcpy(pLevel->uint64_w(), fileData.data() + offset, static_cast<size_t>(levelHeader.dataSize));
+		offset += static_cast<size_t>(levelHeader.dataSize);
+		levels.push_back(std::move(pLevel));
+	}
+	return levels;
+}
+
+void gfx_api::storeCompressedTextureCacheEntry(const std::string& key, const std::string& imageLoadFilename, const std::vector<std::unique_ptr<iV_BaseImage>>& levels)
+{
+	if (levels.empty() || gfx_api::is_uncompressed_format(levels.front()->pixel_format()))
+	{
+		return;
+	}
+	const gfx_api::pixel_format format = levels.front()->pixel_format();
+	if (std::any_of(levels.begin(), levels.end(), [format](const std::unique_ptr<iV_BaseImage>& level) { return level->pixel_format() != format; }))
+	{
+		return;
+	}
+
+	TextureCacheSourceInfo sourceInfo;
+	Sha256 sourceHash;
+	if (!getSourceInfo(imageLoadFilename, sourceInfo) || !hashSourceFile(imageLoadFilename, sourceHash))
+	{
+		return;
+	}
+
+	std::vector<char> fileData;
+	size_t dataSize = 0;
+	for (const auto& level : levels)
+	{
+		dataSize += level->data_size();
+	}
+	fileData.reserve(sizeof(textureCacheMagic) + sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2 + Sha256::Bytes + sizeof(TextureCacheLevelHeader) * levels.size() + dataSize);
+	fileData.insert(fileData.end(), textureCacheMagic, textureCacheMagic + sizeof(textureCacheMagic));
+	appendValue(fileData, textureCacheVersion);
+	appendValue(fileData, static_cast<uint32_t>(format));
+	appendValue(fileData, static_cast<uint32_t>(levels.size()));
+	appendValue(fileData, sourceInfo.size);
+	appendValue(fileData, sourceInfo.modTime);
+	appendValue(fileData, sourceHash.bytes);
+	for (const auto& level : levels)
+	{
+		TextureCacheLevelHeader levelHeader = {level->width(), level->height(), level->bufferRowLength(), level->bufferImageHeight(), static_cast<uint64_t>(level->data_size())};
+		appendValue(fileData, levelHeader);
+	}
+	for (const auto& level : levels)
+	{
+		fileData.insert(fileData.end(), reinterpret_cast<const char *>(level->data()), reinterpret_cast<const char *>(level->data()) + level->data_size());
+	}
+
+	initTextureCacheDir();
+	const std::string cacheFilePath = textureCacheFilePath(key);
+	if (fileData.size() > static_cast<size_t>(std::numeric_limits<UDWORD>::max()) || !saveFileAtomic(cacheFilePath.c_str(), fileData.data(), static_cast<UDWORD>(fileData.size())))
+	{
+		debug(LOG_WARNING, "Failed to write texture cache file: %s", cacheFilePath.c_str());
+	}
+}
@@ -0,0 +1,45 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "pietypes.h"
+#include "gfx_api_formats_def.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Run-time compressed mip levels are cached in the config dir, so each image file only has to be decoded and
+// compressed once (and not on every launch / level load). Thread-safe.
+namespace gfx_api
+{
+	// Key for the cache entry of an image file. Depends on the file's path, size and modification time, and on everything
+	// else the compressed levels depend on (target, textureType, max size, and formatDescription - which should name the
+	// compression formats that may be used). Returns an empty string if the file doesn't exist.
+	std::string compressedTextureCacheKey(const std::string& imageLoadFilename, gfx_api::pixel_format_target target, gfx_api::texture_type textureType, int maxWidth, int maxHeight, const std::string& formatDescription);
+
+	// Returns the cached mip levels (empty, if there is no valid cache entry for the current version of the image file).
+	// The stored hash of the file's contents is only checked if the file has no modification time.
+	std::vector<std::unique_ptr<iV_BaseImage>> loadCompressedTextureCacheEntry(const std::string& key, const std::string& imageLoadFilename);
+
+	// Caches the mip levels (does nothing if they aren't all in the same compressed format).
+	// The entry is written to a temporary file and renamed into place, so concurrent writers of the same key are safe.
+	void storeCompressedTextureCacheEntry(const std::string& key, const std::string& imageLoadFilename, const std::vector<std::unique_ptr<iV_BaseImage>>& levels);
+}
@@ -56,6 +56,8 @@
 #define NUM_RADAR_TEXTURES 2
 static GFX *radarGfx[NUM_RADAR_TEXTURES] = {nullptr};
 static size_t currRadarGfx = 0;
+/// Rows of each radar texture that are out of date
+static std::vector<uint8_t> radarStaleRows[NUM_RADAR_TEXTURES];
 
 /***************************************************************************/
 /*
@@ -131,6 +133,13 @@ void GFX::updateTexture(const iV_Image& image /*= nullptr*/)
 	mTexture->upload(0u, image);
 }
 
+void GFX::updateTextureSub(size_t x, size_t y, const iV_Image& image)
+{
+	ASSERT(mType == GFX_TEXTURE, "Wrong GFX type");
+	ASSERT_OR_RETURN(, mTexture != nullptr, "Null texture??");
+	mTexture->upload_sub(0u, x, y, image);
+}
+
 void GFX::buffers(int vertices, const void *vertBuf, const void *auxBuf)
 {
 	if (!mBuffers[VBO_VERTEX])
@@ -599,10 +608,101 @@ static void pie_DrawImage(IMAGEFILE *imageFile, int id, Vector2i size, const PIE
 	pie_DrawImageTemplate<gfx_api::DrawImagePSO>(imageFile, id, size, dest, colour, modelViewProjection, textureInset);
 }
 
+// Vertex buffers for the image batches of the current frame, since a buffer may only be uploaded once per frame
+static std::vector<gfx_api::buffer*> imageBatchBuffers;
+static size_t imageBatchBuffersUsed = 0;
+static size_t imageBatchBuffersFrame = 0;
+static std::vector<gfx_api::gfxFloat> imageBatchVertices;
+static std::vector<gfx_api::gfxFloat> imageBatchTexCoords;
+
+static gfx_api::buffer* getImageBatchBuffer()
+{
+	const size_t frameNum = gfx_api::context::get().current_FrameNum();
+	if (frameNum != imageBatchBuffersFrame)
+	{
+		imageBatchBuffersFrame = frameNum;
+		imageBatchBuffersUsed = 0;
+	}
+	if (imageBatchBuffersUsed >= imageBatchBuffers.size())
+	{
+		imageBatchBuffers.push_back(gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::stream_draw, "imageBatchBuffer[" + std::to_string(imageBatchBuffers.size()) + "]"));
+	}
+	return imageBatchBuffers[imageBatchBuffersUsed++];
+}
+
+void pie_ShutdownImageBatches()
+{
+	for (auto* buffer : imageBatchBuffers)
+	{
+		delete buffer;
+	}
+	imageBatchBuffers.clear();
+	imageBatchBuffersUsed = 0;
+}
+
+static bool sameImageBatch(const PieDrawImageRequest& a, const PieDrawImageRequest& b)
+{
+	return a.imageFile->pages[a.imageFile->imageDefs[a.ID].TPageID].id == b.imageFile->pages[b.imageFile->imageDefs[b.ID].TPageID].id
+		&& a.colour.rgba() == b.colour.rgba() && a.modelViewProjection == b.modelViewProjection;
+}
+
+// Puts the quads of all requests into one vertex buffer, and draws each run of requests that share a texture page, colour
+// and transform with a single draw call
+static void pie_DrawMultipleImagesBatched(const std::list<PieDrawImageRequest>& requests)
+{
+	imageBatchVertices.clear();
+	imageBatchTexCoords.clear();
+	for (const auto& request : requests)
+	{
+		AtlasImageDef const &image = request.imageFile->imageDefs[request.ID];
+		gfx_api::gfxFloat invTextureSize = 1.f / (float)request.imageFile->pages[image.TPageID].size;
+		const float tu = (float)(image.Tu + request.textureInset.x) * invTextureSize;
+		const float tv = (float)(image.Tv + request.textureInset.y) * invTextureSize;
+		const float su = (float)(request.size.x - (request.textureInset.x * 2)) * invTextureSize;
+		const float sv = (float)(request.size.y - (request.textureInset.y * 2)) * invTextureSize;
+		const float x0 = request.dest.x, y0 = request.dest.y, x1 = request.dest.x + request.dest.w, y1 = request.dest.y + request.dest.h;
+
+		// Same winding as the triangle strip of pie_internal::rectBuffer
+		imageBatchVertices.insert(imageBatchVertices.end(), {x0, y1, x0, y0, x1, y1, x1, y1, x0, y0, x1, y0});
+		imageBatchTexCoords.insert(imageBatchTexCoords.end(), {tu, tv + sv, tu, tv, tu + su, tv + sv, tu + su, tv + sv, tu, tv, tu + su, tv});
+	}
+	const size_t vertexBytes = imageBatchVertices.size() * sizeof(gfx_api::gfxFloat);
+	imageBatchVertices.insert(imageBatchVertices.end(), imageBatchTexCoords.begin(), imageBatchTexCoords.end());
+	gfx_api::buffer* buffer = getImageBatchBuffer();
+	buffer->upload(imageBatchVertices.size() * sizeof(gfx_api::gfxFloat), imageBatchVertices.data());
+
+	gfx_api::DrawImageBatchPSO::get().bind();
+	gfx_api::context::get().bind_vertex_buffers(0, { std::make_tuple(buffer, 0), std::make_tuple(buffer, vertexBytes) });
+	size_t runStart = 0;
+	for (auto it = requests.begin(); it != requests.end(); )
+	{
+		const PieDrawImageRequest& first = *it;
+		size_t runLength = 0;
+		do
+		{
+			++it;
+			++runLength;
+		} while (it != requests.end() && sameImageBatch(first, *it));
+
+		AtlasImageDef const &image = first.imageFile->imageDefs[first.ID];
+		gfx_api::DrawImageBatchPSO::get().bind_constants({ first.modelViewProjection, glm::vec2(0.f), glm::vec2(0.f), pielightToRGBAVec4(first.colour), 0 });
+		gfx_api::DrawImageBatchPSO::get().bind_textures(&pie_Texture(first.imageFile->pages[image.TPageID].id));
+		gfx_api::DrawImageBatchPSO::get().draw(runLength * 6, runStart * 6);
+		runStart += runLength;
+	}
+	gfx_api::context::get().unbind_vertex_buffers(0, { std::make_tuple(buffer, 0), std::make_tuple(buffer, vertexBytes) });
+}
+
 static void pie_DrawMultipleImages(const std::list<PieDrawImageRequest>& requests)
 {
 	if (requests.empty()) { return; }
 
+	if (requests.size() > 1)
+	{
+		pie_DrawMultipleImagesBatched(requests);
+		return;
+	}
+
 	bool didEnableRect = false;
 	gfx_api::DrawImagePSO::get().bind();
 
@@ -929,6 +1029,7 @@ void pie_SetRadar(gfx_api::gfxFloat x, gfx_api::gfxFloat y, gfx_api::gfxFloat wi
 		gfx_api::gfxFloat texcoords[] = { 0.0f, 0.0f,  1.0f, 0.0f,  0.0f, 1.0f,  1.0f, 1.0f };
 		gfx_api::gfxFloat vertices[] = { x, y,  x + width, y,  x, y + height,  x + width, y + height };
 		radarGfx[i]->buffers(4, vertices, texcoords);
+		radarStaleRows[i].assign(theight, 1);
 	}
 }
 
@@ -941,6 +1042,53 @@ void pie_DownLoadRadar(const iV_Image& bitmap)
 		currRadarGfx = 0;
 	}
 	radarGfx[currRadarGfx]->updateTexture(bitmap);
+	std::fill(radarStaleRows[currRadarGfx].begin(), radarStaleRows[currRadarGfx].end(), 0);
+}
+
+void pie_DownLoadRadarRows(const iV_Image& bitmap, const std::vector<uint8_t>& changedRows)
+{
+	for (size_t i = 0; i < NUM_RADAR_TEXTURES; ++i)
+	{
+		ASSERT_OR_RETURN(, radarStaleRows[i].size() == bitmap.height() && changedRows.size() == bitmap.height(), "Radar size mismatch");
+		for (size_t row = 0; row < changedRows.size(); ++row)
+		{
+			radarStaleRows[i][row] |= changedRows[row];
+		}
+	}
+	currRadarGfx++;
+	if (currRadarGfx >= NUM_RADAR_TEXTURES)
+	{
+		currRadarGfx = 0;
+	}
+
+	// Upload each run of stale rows, since the textures are double-buffered this includes the rows changed last time
+	std::vector<uint8_t> &staleRows = radarStaleRows[currRadarGfx];
+	const size_t rowSize = static_cast<size_t>(bitmap.width()) * bitmap.channels();
+	static iV_Image rows;
+	for (size_t first = 0; first < staleRows.size();)
+	{
+		if (!staleRows[first])
+		{
+			++first;
+			continue;
+		}
+		size_t last = first;
+		while (last < staleRows.size() && staleRows[last])
+		{
+			staleRows[last++] = 0;
+		}
+		if (first == 0 && last == staleRows.size())
+		{
+			radarGfx[currRadarGfx]->updateTexture(bitmap);
+			return;
+		}
+		if (rows.allocate(bitmap.width(), static_cast<unsigned int>(last - first), bitmap.channels()))
+		{
+			memcpy(rows.bmp_w(), bitmap.bmp() + first * rowSize, (last - first) * rowSize);
+			radarGfx[currRadarGfx]->updateTextureSub(0, first, rows);
+		}
+		first = last;
+	}
 }
 
 /** Display radar texture using the given height and width, depending on zoom level. */
@@ -96,6 +96,8 @@ public:
 
 	/// Upload given memory buffer to already allocated texture space on the GPU
 	void updateTexture(const iV_Image& image /*= nullptr*/);
+	/// Upload given memory buffer to part of the already allocated texture space on the GPU
+	void updateTextureSub(size_t x, size_t y, const iV_Image& image);
 
 	/// Upload vertex and texture buffer data to the GPU
 	void buffers(int vertices, const void *vertBuf, const void *texBuf);
@@ -267,9 +269,15 @@ void pie_UniTransBoxFill(float x0, float y0, float x1, float y1, PIELIGHT colour
 
 bool assertValidImage(IMAGEFILE *imageFile, unsigned id);
 
+/// Free the vertex buffers used to draw BatchedImageDrawRequests
+void pie_ShutdownImageBatches();
+
 bool pie_InitRadar();
 bool pie_ShutdownRadar();
 void pie_DownLoadRadar(const iV_Image& bitmap);
+/// Like pie_DownLoadRadar(), but only uploads the rows that changed. changedRows has a flag for each row of the bitmap,
+/// set if the row changed since the previous call.
+void pie_DownLoadRadarRows(const iV_Image& bitmap, const std::vector<uint8_t>& changedRows);
 void pie_RenderRadar(const glm::mat4 &modelViewProjectionMatrix);
 void pie_SetRadar(gfx_api::gfxFloat x, gfx_api::gfxFloat y, gfx_api::gfxFloat width, gfx_api::gfxFloat height, size_t twidth, size_t theight);
 
@@ -48,6 +48,9 @@ struct iIMDShape;
  */
 /***************************************************************************/
 bool pie_Draw3DShape(const iIMDShape *shape, int frame, int team, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, float stretchDepth = 0.f, bool onlySingleLevel = false);
+/** Draw the shape once at each of positions, using baseModelMatrix translated by the position as the model matrix.
+ *  Equivalent to count calls to pie_Draw3DShape, but queues the whole batch at once. */
+bool pie_Draw3DShapeInstances(const iIMDShape *shape, PIELIGHT colour, int pieFlag, const glm::mat4 &baseModelMatrix, const glm::vec3 *positions, size_t count);
 void pie_Draw3DButton(const iIMDShape *shape, PIELIGHT teamcolour, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix);
 
 void pie_GetResetCounts(size_t *pPieCount, size_t *pPolyCount);
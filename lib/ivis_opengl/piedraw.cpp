@@ -44,6 +44,7 @@
 #include <string.h>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <unordered_set>
 #include <utility>
 
@@ -74,6 +75,7 @@ static bool shadows = false;
 static bool shadowsHasBeenInit = false;
 static ShadowMode shadowMode = ShadowMode::Shadow_Mapping;
 static uint32_t numShadowCascades = WZ_MAX_SHADOW_CASCADES;
+static uint64_t depthPassGeneration = 0; ///< Changes whenever the depth pass textures may have been recreated
 static gfx_api::gfxFloat lighting0[LIGHT_MAX][4];
 static gfx_api::gfxFloat lightingDefault[LIGHT_MAX][4];
 
@@ -142,6 +144,7 @@ static void refreshShadowShaders()
 		gfx_api::context::get().setShadowConstants(shadowConstants);
 
 		// Trigger depth pass buffer free / rebuild if needed
+		++depthPassGeneration;
 		gfx_api::context::get().setDepthPassProperties(actualNumCascadesAndPasses, gfx_api::context::get().getDepthPassDimensions(0));
 	}
 }
@@ -168,6 +171,7 @@ bool pie_setShadowMapResolution(uint32_t resolution)
 {
 	ASSERT_OR_RETURN(false, resolution && !(resolution & (resolution - 1)), "Expecting power-of-2 resolution, received: %" PRIu32, resolution);
 	bool bShadowMappingEnabled = isShadowMappingEnabled();
+	++depthPassGeneration;
 	return gfx_api::context::get().setDepthPassProperties((bShadowMappingEnabled) ? numShadowCascades : 0, resolution);
 }
 
@@ -291,6 +295,10 @@ static gfx_api::buffer* getZeroedVertexBuffer(size_t size)
 void pie_Draw3DButton(const iIMDShape *shape, PIELIGHT teamcolour, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix)
 {
 	const auto& textures = shape->getTextures();
+	pie_TexMarkUsed(textures.texpage);
+	pie_TexMarkUsed(textures.tcmaskpage);
+	pie_TexMarkUsed(textures.normalpage);
+	pie_TexMarkUsed(textures.specularpage);
 	auto* tcmask = textures.tcmaskpage != iV_TEX_INVALID ? &pie_Texture(textures.tcmaskpage) : nullptr;
 	auto* normalmap = textures.normalpage != iV_TEX_INVALID ? &pie_Texture(textures.normalpage) : nullptr;
 	auto* specularmap = textures.specularpage != iV_TEX_INVALID ? &pie_Texture(textures.specularpage) : nullptr;
@@ -1010,6 +1018,8 @@ public:
 
 	// Queues a mesh for drawing
 	bool Draw3DShape(const iIMDShape *shape, int frame, PIELIGHT teamcolour, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, float stretchDepth);
+	// Queues one instance of the shape at each of positions, with a single state lookup for the whole batch
+	bool Draw3DShapeInstances(const iIMDShape *shape, PIELIGHT teamcolour, PIELIGHT colour, int pieFlag, const glm::mat4 &baseModelMatrix, const glm::vec3 *positions, size_t count);
 
 	// Finalizes queued meshes, ready for one or more DrawAll calls
 	// (After this is called, Draw3DShape should not be called until the InstancedMeshRenderer is clear()-ed)
@@ -1024,6 +1034,9 @@ public:
 	};
 	static constexpr int DrawParts_All = DrawParts::ShadowCastingShapes | DrawParts::TranslucentShapes | DrawParts::AdditiveShapes;
 
+	// Sums up the finalized shadow casting instances that may be drawn into a depth pass with the given light view-projection matrix
+	uint64_t ShadowCastersSignature(const glm::mat4 &lightViewProjection);
+
 	// Draws all queued meshes, given a projection + view matrix
 	bool DrawAll(uint64_t currentGameFrame, const glm::mat4 &projectionMatrix, const glm::mat4 &viewMatrix, const Vector3f &cameraPos, const ShadowCascadesInfo& shadowMVPMatrix, int drawParts = DrawParts_All, bool depthPass = false);
 public:
@@ -1066,10 +1079,63 @@ private:
 	ShapeVector tshapes;
 	ShapeVector shapes;
 
+	/// Instance data of the translucent and additive meshes, which is regenerated every frame
 	std::vector<gfx_api::Draw3DShapePerInstanceInterleavedData> instancesData;
 	std::vector<gfx_api::buffer*> instanceDataBuffers;
 	size_t currInstanceBufferIdx = 0;
 
+	templatedState stateForShape(const iIMDShape *shape, int pieFlag) const;
+	ShapeVector &queueForShape(const templatedState &state, int pieFlag, size_t numInstances);
+
+	/// Bounding sphere and a hash of the instance data of each finalized shadow casting instance
+	struct ShadowCaster
+	{
+		glm::vec3 centre;
+		float radius;
+		uint64_t hash;
+	};
+	std::vector<ShadowCaster> shadowCasters;
+	uint64_t nonInstancedFrames = 0;
+
+	static ShadowCaster shadowCasterFor(const iIMDShape *shape, const gfx_api::Draw3DShapePerInstanceInterleavedData &data);
+
+	/// The slots of the opaque instances of one mesh. An instance keeps its slot for as long as it is queued with the same
+	/// inputs every frame, so only instances that changed, appeared or disappeared need to be generated and uploaded.
+	struct PersistentMesh
+	{
+		size_t regionStart = 0; ///< First slot of this mesh in persistentInstancesData
+		size_t capacity = 0;
+		size_t liveCount = 0; ///< Slots [0, liveCount) are drawn
+		std::vector<SHAPE> inputs; ///< What each slot was generated from
+		std::vector<uint64_t> hashes;
+		std::vector<ShadowCaster> casters;
+		std::vector<uint8_t> seen; ///< Whether the slot was matched by an instance queued this frame
+		std::unordered_map<uint64_t, uint32_t> slotByHash;
+		size_t seenCount = 0;
+		std::vector<uint32_t> pending; ///< Queued instances (indices into the mesh's ShapeVector) that need a new slot
+	};
+	std::unordered_map<MeshInstanceKey, PersistentMesh> persistentMeshes;
+	std::vector<gfx_api::Draw3DShapePerInstanceInterleavedData> persistentInstancesData;
+	/// Changes whenever the persistent meshes are laid out again, which needs a full upload of every instance buffer
+	size_t persistentLayoutGeneration = 0;
+
+	struct InstanceBufferState
+	{
+		size_t layoutGeneration = std::numeric_limits<size_t>::max();
+		std::vector<size_t> dirtySlots; ///< Slots of persistentInstancesData written since this buffer was last uploaded
+	};
+	std::vector<InstanceBufferState> instanceBufferStates;
+	std::vector<gfx_api::Draw3DShapePerInstanceInterleavedData> uploadScratch;
+
+	void matchPersistentSlots(PersistentMesh &persistent, const ShapeVector &queued);
+	void layoutPersistentMeshes();
+	void fillPersistentSlots(const templatedState &state, PersistentMesh &persistent, const ShapeVector *queued);
+	void writePersistentSlot(const templatedState &state, PersistentMesh &persistent, size_t slot, const SHAPE &instance);
+	void movePersistentSlot(PersistentMesh &persistent, size_t from, size_t to);
+	void releasePersistentSlot(PersistentMesh &persistent, size_t slot);
+	void markPersistentSlotDirty(size_t idx);
+	void uploadInstances(size_t bufferIdx);
+
 	gfx_api::texture* lightmapTexture = nullptr;
 	glm::mat4 modelUVLightmapMatrix = glm::mat4();
 
@@ -1118,6 +1184,7 @@ bool InstancedMeshRenderer::initialize()
 	{
 		instanceDataBuffers[i] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer, gfx_api::context::buffer_storage_hint::stream_draw, "InstancedMeshRenderer::instanceDataBuffer[" + std::to_string(i) + "]");
 	}
+	instanceBufferStates.resize(instanceDataBuffers.size());
 	useInstancedRendering = true;
 	return true;
 }
@@ -1145,9 +1212,13 @@ void InstancedMeshRenderer::reset()
 		delete buffer;
 	}
 	instanceDataBuffers.clear();
+	instanceBufferStates.clear();
+	persistentMeshes.clear();
+	persistentInstancesData.clear();
+	++persistentLayoutGeneration;
 }
 
-bool InstancedMeshRenderer::Draw3DShape(const iIMDShape *shape, int frame, PIELIGHT teamcolour, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, float stretchDepth)
+templatedState InstancedMeshRenderer::stateForShape(const iIMDShape *shape, int pieFlag) const
 {
 	bool light = true;
 
@@ -1174,9 +1245,50 @@ bool InstancedMeshRenderer::Draw3DShape(const iIMDShape *shape, int frame, PIELI
 		light = true;
 	}
 
+	return templatedState((light) ? ((useInstancedRendering) ? SHADER_COMPONENT_INSTANCED : SHADER_COMPONENT) : ((useInstancedRendering) ? SHADER_NOLIGHT_INSTANCED : SHADER_NOLIGHT), shape, pieFlag);
+}
+
+InstancedMeshRenderer::ShapeVector &InstancedMeshRenderer::queueForShape(const templatedState &state, int pieFlag, size_t numInstances)
+{
+	if (pieFlag & (pie_ADDITIVE | pie_PREMULTIPLIED))
+	{
+		additiveInstancesCount += numInstances;
+		return (useInstancedRendering) ? instanceAdditiveMeshes[state] : tshapes;
+	}
+	else if (pieFlag & pie_TRANSLUCENT)
+	{
+		translucentInstancesCount += numInstances;
+		if (!useInstancedRendering)
+		{
+			return tshapes;
+		}
+		return (pieFlag & pie_NODEPTHWRITE) ? instanceTranslucentMeshesNoDepthWrite[state] : instanceTranslucentMeshes[state];
+	}
+	instancesCount += numInstances;
+	if (!useInstancedRendering)
+	{
+		return shapes;
+	}
+	auto [it, _] = instanceMeshes.try_emplace(state, poolAllocator);
+	return it->second;
+}
+
+static void markShapeTexturesUsed(const iIMDShape *shape)
+{
+	const iIMDShapeTextures& textures = shape->getTextures();
+	pie_TexMarkUsed(textures.texpage);
+	pie_TexMarkUsed(textures.tcmaskpage);
+	pie_TexMarkUsed(textures.normalpage);
+	pie_TexMarkUsed(textures.specularpage);
+}
+
+bool InstancedMeshRenderer::Draw3DShape(const iIMDShape *shape, int frame, PIELIGHT teamcolour, PIELIGHT colour, int pieFlag, int pieFlagData, const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, float stretchDepth)
+{
 	frame %= std::max<int>(1, shape->numFrames);
 
-	templatedState currentState = templatedState((light) ? ((useInstancedRendering) ? SHADER_COMPONENT_INSTANCED : SHADER_COMPONENT) : ((useInstancedRendering) ? SHADER_NOLIGHT_INSTANCED : SHADER_NOLIGHT), shape, pieFlag);
+	templatedState currentState = stateForShape(shape, pieFlag);
+
+	markShapeTexturesUsed(shape);
 
 	SHAPE tshape;
 	tshape.shape = shape;
@@ -1202,76 +1314,66 @@ bool InstancedMeshRenderer::Draw3DShape(const iIMDShape *shape, int frame, PIELI
 		tshape.modelMatrix = glm::translate(tshape.modelMatrix, glm::vec3(1.0f, (-shape->max.y * (pie_RAISE_SCALE - pieFlagData)) * (1.0f / pie_RAISE_SCALE), 1.0f));
 	}
 
-	if (pieFlag & (pie_ADDITIVE | pie_PREMULTIPLIED))
+	if ((pieFlag & (pie_ADDITIVE | pie_PREMULTIPLIED | pie_TRANSLUCENT)) == 0
+	    && shadows && (pieFlag & pie_SHADOW || pieFlag & pie_STATIC_SHADOW) && (shadowMode == ShadowMode::Fallback_Stencil_Shadows))
 	{
-		if (useInstancedRendering)
-		{
-			instanceAdditiveMeshes[currentState].push_back(tshape);
-		}
-		else
-		{
-			tshapes.push_back(tshape);
-		}
-		++additiveInstancesCount;
-	}
-	else if (pieFlag & pie_TRANSLUCENT)
-	{
-		if (useInstancedRendering)
-		{
-			if (pieFlag & pie_NODEPTHWRITE)
-			{
-				instanceTranslucentMeshesNoDepthWrite[currentState].push_back(tshape);
-			}
-			else
-			{
-				instanceTranslucentMeshes[currentState].push_back(tshape);
-			}
-		}
-		else
+		float distance;
+
+		// draw a shadow
+		ShadowcastingShape scshape;
+		scshape.modelViewMatrix = viewMatrix * modelMatrix;
+		distance = scshape.modelViewMatrix[3][0] * scshape.modelViewMatrix[3][0];
+		distance += scshape.modelViewMatrix[3][1] * scshape.modelViewMatrix[3][1];
+		distance += scshape.modelViewMatrix[3][2] * scshape.modelViewMatrix[3][2];
+
+		// if object is too far in the fog don't generate a shadow.
+		if (distance < SHADOW_END_DISTANCE)
 		{
-			tshapes.push_back(tshape);
+			// Calculate the light position relative to the object
+			glm::vec4 pos_light0 = glm::vec4(currentSunPosition, 0.f);
+			glm::mat4 invmat = glm::inverse(scshape.modelViewMatrix);
+
+			scshape.light = invmat * pos_light0;
+			scshape.shape = shape;
+			scshape.flag = pieFlag;
+			scshape.flag_data = pieFlagData;
+
+			scshapes.push_back(scshape);
 		}
-		++translucentInstancesCount;
 	}
-	else
-	{
-		if (shadows && (pieFlag & pie_SHADOW || pieFlag & pie_STATIC_SHADOW) && (shadowMode == ShadowMode::Fallback_Stencil_Shadows))
-		{
-			float distance;
 
-			// draw a shadow
-			ShadowcastingShape scshape;
-			scshape.modelViewMatrix = viewMatrix * modelMatrix;
-			distance = scshape.modelViewMatrix[3][0] * scshape.modelViewMatrix[3][0];
-			distance += scshape.modelViewMatrix[3][1] * scshape.modelViewMatrix[3][1];
-			distance += scshape.modelViewMatrix[3][2] * scshape.modelViewMatrix[3][2];
+	queueForShape(currentState, pieFlag, 1).push_back(tshape);
 
-			// if object is too far in the fog don't generate a shadow.
-			if (distance < SHADOW_END_DISTANCE)
-			{
-				// Calculate the light position relative to the object
-				glm::vec4 pos_light0 = glm::vec4(currentSunPosition, 0.f);
-				glm::mat4 invmat = glm::inverse(scshape.modelViewMatrix);
+	return true;
+}
 
-				scshape.light = invmat * pos_light0;
-				scshape.shape = shape;
-				scshape.flag = pieFlag;
-				scshape.flag_data = pieFlagData;
+bool InstancedMeshRenderer::Draw3DShapeInstances(const iIMDShape *shape, PIELIGHT teamcolour, PIELIGHT colour, int pieFlag, const glm::mat4 &baseModelMatrix, const glm::vec3 *positions, size_t count)
+{
+	ASSERT_OR_RETURN(false, (pieFlag & (pie_SHIELD | pie_HEIGHT_SCALED | pie_RAISE | pie_SHADOW | pie_STATIC_SHADOW)) == 0, "Unsupported pieFlag for instance batches: %d", pieFlag);
+	if (count == 0)
+	{
+		return true;
+	}
 
-				scshapes.push_back(scshape);
-			}
-		}
-		if (useInstancedRendering)
-		{
-			auto [it, _] = instanceMeshes.try_emplace(currentState, poolAllocator);
-			it->second.push_back(tshape);
-		}
-		else
-		{
-			shapes.push_back(tshape);
-		}
+	markShapeTexturesUsed(shape);
+
+	SHAPE tshape;
+	tshape.shape = shape;
+	tshape.frame = 0;
+	tshape.colour = colour;
+	tshape.teamcolour = teamcolour;
+	tshape.flag = pieFlag;
+	tshape.flag_data = 0;
+	tshape.stretch = 0.f;
+	tshape.modelMatrix = baseModelMatrix;
 
-		++instancesCount;
+	ShapeVector &queue = queueForShape(stateForShape(shape, pieFlag), pieFlag, count);
+	queue.reserve(queue.size() + count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		// Same as glm::translate(positions[i]) * baseModelMatrix, for an affine baseModelMatrix
+		tshape.modelMatrix[3] = baseModelMatrix[3] + glm::vec4(positions[i], 0.f);
+		queue.push_back(tshape);
 	}
 
 	return true;
@@ -1326,6 +1428,24 @@ bool pie_Draw3DShape(const iIMDShape *shape, int frame, int team, PIELIGHT colou
 	return retVal;
 }
 
+bool pie_Draw3DShapeInstances(const iIMDShape *shape, PIELIGHT colour, int pieFlag, const glm::mat4 &baseModelMatrix, const glm::vec3 *positions, size_t count)
+{
+	pieCount += count;
+
+	const bool drawAllLevels = (shape->modelLevel == 0);
+	const PIELIGHT teamcolour = shape->getTeamColourForModel(0);
+
+	bool retVal = false;
+	const iIMDShape *pCurrShape = shape;
+	do
+	{
+		retVal = instancedMeshRenderer.Draw3DShapeInstances(pCurrShape, teamcolour, colour, pieFlag, baseModelMatrix, positions, count);
+		pCurrShape = pCurrShape->next.get();
+	} while (drawAllLevels && pCurrShape && retVal);
+
+	return retVal;
+}
+
 static void pie_ShadowDrawLoop(ShadowCache &shadowCache, const glm::mat4& projectionMatrix)
 {
 //	size_t cachedShadowDraws = 0;
@@ -1412,6 +1532,16 @@ void pie_FinalizeMeshes(uint64_t currentGameFrame)
 	instancedMeshRenderer.FinalizeInstances();
 }
 
+uint64_t pie_ShadowCastersSignature(const glm::mat4 &lightViewProjection)
+{
+	return instancedMeshRenderer.ShadowCastersSignature(lightViewProjection);
+}
+
+uint64_t pie_DepthPassGeneration()
+{
+	return depthPassGeneration;
+}
+
 void pie_DrawAllMeshes(uint64_t currentGameFrame, const glm::mat4 &projectionMatrix, const glm::mat4& viewMatrix, const Vector3f &cameraPos, const ShadowCascadesInfo& shadowMVPMatrix, bool depthPass)
 {
 	int drawParts = InstancedMeshRenderer::DrawParts_All;
@@ -1445,31 +1575,57 @@ bool InstancedMeshRenderer::FinalizeInstances()
 
 	instancesData.clear();
 	finalizedDrawCalls.clear();
+	shadowCasters.clear();
 
 	if (instancesCount + translucentInstancesCount + additiveInstancesCount == 0)
 	{
 		return true;
 	}
 
-	instancesData.reserve(instancesCount + translucentInstancesCount + additiveInstancesCount);
+	// Match the queued opaque instances with the slots they had last frame
+	for (auto& persistent : persistentMeshes)
+	{
+		persistent.second.seen.assign(persistent.second.capacity, 0);
+		persistent.second.seenCount = 0;
+		persistent.second.pending.clear();
+	}
+	bool needsLayout = false;
+	for (const auto& mesh : instanceMeshes)
+	{
+		PersistentMesh& persistent = persistentMeshes[mesh.first];
+		matchPersistentSlots(persistent, mesh.second);
+		needsLayout = needsLayout || (persistent.seenCount + persistent.pending.size() > persistent.capacity);
+	}
+	if (needsLayout || persistentInstancesData.size() > 2 * instancesCount + 1024)
+	{
+		layoutPersistentMeshes();
+	}
+	for (auto& persistent : persistentMeshes)
+	{
+		auto queued = instanceMeshes.find(persistent.first);
+		fillPersistentSlots(persistent.first, persistent.second, (queued != instanceMeshes.end()) ? &queued->second : nullptr);
+	}
 
 	for (const auto& mesh : instanceMeshes)
 	{
-		const auto& meshInstances = mesh.second;
-		size_t startingIdxInInstancesBuffer = instancesData.size();
-		for (const auto& instance : meshInstances)
+		const PersistentMesh& persistent = persistentMeshes[mesh.first];
+		if ((mesh.first.pieFlag & (pie_SHADOW | pie_STATIC_SHADOW)) != 0)
 		{
-			instancesData.push_back(GenerateInstanceData(instance.frame, instance.colour, instance.teamcolour, instance.flag, instance.flag_data, instance.modelMatrix, instance.stretch));
+			shadowCasters.insert(shadowCasters.end(), persistent.casters.begin(), persistent.casters.begin() + persistent.liveCount);
 		}
-		finalizedDrawCalls.emplace_back(mesh.first, meshInstances.size(), startingIdxInInstancesBuffer);
+		finalizedDrawCalls.emplace_back(mesh.first, persistent.liveCount, persistent.regionStart);
 	}
 
+	// The rest is drawn in the order it was queued in, so it is regenerated every frame after the persistent slots
+	instancesData.reserve(translucentInstancesCount + additiveInstancesCount);
+	const size_t streamedStart = persistentInstancesData.size();
+
 	startIdxTranslucentDrawCalls = finalizedDrawCalls.size();
 
 	for (const auto& mesh : instanceTranslucentMeshes)
 	{
 		const auto& meshInstances = mesh.second;
-		size_t startingIdxInInstancesBuffer = instancesData.size();
+		size_t startingIdxInInstancesBuffer = streamedStart + instancesData.size();
 		for (const auto& instance : meshInstances)
 		{
 			instancesData.push_back(GenerateInstanceData(instance.frame, instance.colour, instance.teamcolour, instance.flag, instance.flag_data, instance.modelMatrix, instance.stretch));
@@ -1482,7 +1638,7 @@ bool InstancedMeshRenderer::FinalizeInstances()
 	for (const auto& mesh : instanceTranslucentMeshesNoDepthWrite)
 	{
 		const auto& meshInstances = mesh.second;
-		size_t startingIdxInInstancesBuffer = instancesData.size();
+		size_t startingIdxInInstancesBuffer = streamedStart + instancesData.size();
 		for (const auto& instance : meshInstances)
 		{
 			instancesData.push_back(GenerateInstanceData(instance.frame, instance.colour, instance.teamcolour, instance.flag, instance.flag_data, instance.modelMatrix, instance.stretch));
@@ -1495,7 +1651,7 @@ bool InstancedMeshRenderer::FinalizeInstances()
 	for (const auto& mesh : instanceAdditiveMeshes)
 	{
 		const auto& meshInstances = mesh.second;
-		size_t startingIdxInInstancesBuffer = instancesData.size();
+		size_t startingIdxInInstancesBuffer = streamedStart + instancesData.size();
 		for (const auto& instance : meshInstances)
 		{
 			instancesData.push_back(GenerateInstanceData(instance.frame, instance.colour, instance.teamcolour, instance.flag, instance.flag_data, instance.modelMatrix, instance.stretch));
@@ -1509,13 +1665,287 @@ bool InstancedMeshRenderer::FinalizeInstances()
 	{
 		currInstanceBufferIdx = 0;
 	}
-	instanceDataBuffers[currInstanceBufferIdx]->upload(instancesData.size() * sizeof(gfx_api::Draw3DShapePerInstanceInterleavedData), instancesData.data());
+	uploadInstances(currInstanceBufferIdx);
 
 	instancesData.clear();
 
 	return true;
 }
 
+static inline uint64_t mixShadowCasterHash(uint64_t x)
+{
+	// splitmix64 finalizer
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+InstancedMeshRenderer::ShadowCaster InstancedMeshRenderer::shadowCasterFor(const iIMDShape *shape, const gfx_api::Draw3DShapePerInstanceInterleavedData &data)
+{
+	const glm::mat4 &modelMatrix = data.ModelViewMatrix;
+	const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))});
+
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&data);
+	for (size_t i = 0; i < sizeof(data); ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+	}
+	hash ^= reinterpret_cast<uintptr_t>(shape);
+
+	// The radius is measured from the model's origin, leave some room for animations and stretching to the terrain
+	return {glm::vec3(modelMatrix[3]), (shape->radius + 32) * scale * 1.25f, hash};
+}
+
+// The sum is independent of the order the meshes were batched in, so it only changes if an instance inside the light's
+// view changed, appeared or disappeared. Without instanced rendering there is nothing to compare, so it changes every frame.
+uint64_t InstancedMeshRenderer::ShadowCastersSignature(const glm::mat4 &lightViewProjection)
+{
+	if (!useInstancedRendering)
+	{
+		return ++nonInstancedFrames;
+	}
+
+	// Clip space units per world unit along x and y (the light's projection is orthographic)
+	const float scaleX = glm::length(glm::vec3(lightViewProjection[0][0], lightViewProjection[1][0], lightViewProjection[2][0]));
+	const float scaleY = glm::length(glm::vec3(lightViewProjection[0][1], lightViewProjection[1][1], lightViewProjection[2][1]));
+	uint64_t signature = shadows;
+	for (const auto &caster : shadowCasters)
+	{
+		const glm::vec4 clipPos = lightViewProjection * glm::vec4(caster.centre, 1.f);
+		if (std::abs(clipPos.x) > 1.f + caster.radius * scaleX || std::abs(clipPos.y) > 1.f + caster.radius * scaleY)
+		{
+			continue;
+		}
+		signature += mixShadowCasterHash(caster.hash);
+	}
+	return signature;
+}
+
+// Identifies an instance by everything GenerateInstanceData uses (the shape is part of the mesh key)
+static uint64_t hashInstanceInputs(const SHAPE &instance)
+{
+	// FNV-1a, a word at a time
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto mix = [&hash](uint32_t word) {
+		hash = (hash ^ word) * 0x100000001b3ULL;
+	};
+	const float *matrix = &instance.modelMatrix[0][0];
+	for (size_t i = 0; i < 16; ++i)
+	{
+		uint32_t word;
+		memcpy(&word, &matrix[i], sizeof(word));
+		mix(word);
+	}
+	uint32_t stretch;
+	memcpy(&stretch, &instance.stretch, sizeof(stretch));
+	mix(static_cast<uint32_t>(instance.frame));
+	mix(instance.colour.rgba());
+	mix(instance.teamcolour.rgba());
+	mix(static_cast<uint32_t>(instance.flag));
+	mix(static_cast<uint32_t>(instance.flag_data));
+	mix(stretch);
+	return hash;
+}
+
+static bool sameInstanceInputs(const SHAPE &a, const SHAPE &b)
+{
+	return a.modelMatrix == b.modelMatrix && a.frame == b.frame && a.colour.rgba() == b.colour.rgba() && a.teamcolour.rgba() == b.teamcolour.rgba()
+		&& a.flag == b.flag && a.flag_data == b.flag_data && a.stretch == b.stretch;
+}
+
+void InstancedMeshRenderer::matchPersistentSlots(PersistentMesh &persistent, const ShapeVector &queued)
+{
+	for (size_t i = 0; i < queued.size(); ++i)
+	{
+		const SHAPE &instance = queued[i];
+		auto it = persistent.slotByHash.find(hashInstanceInputs(instance));
+		if (it != persistent.slotByHash.end() && !persistent.seen[it->second] && sameInstanceInputs(persistent.inputs[it->second], instance))
+		{
+			persistent.seen[it->second] = 1;
+			++persistent.seenCount;
+			continue;
+		}
+		persistent.pending.push_back(static_cast<uint32_t>(i));
+	}
+}
+
+// Gives every mesh room for half again as many instances as it needs now, and drops the meshes that are not drawn anymore
+void InstancedMeshRenderer::layoutPersistentMeshes()
+{
+	uploadScratch.clear();
+	for (auto it = persistentMeshes.begin(); it != persistentMeshes.end(); )
+	{
+		PersistentMesh &persistent = it->second;
+		const size_t required = persistent.seenCount + persistent.pending.size();
+		if (required == 0)
+		{
+			it = persistentMeshes.erase(it);
+			continue;
+		}
+		// Only the slots matched this frame are kept, packed to the front of the new region (the region may be
+		// smaller than the old live count, when far fewer instances are drawn than before)
+		const size_t newRegionStart = uploadScratch.size();
+		const size_t newCapacity = required + required / 2 + 1;
+		persistent.slotByHash.clear();
+		size_t kept = 0;
+		for (size_t slot = 0; slot < persistent.liveCount; ++slot)
+		{
+			if (!persistent.seen[slot])
+			{
+				continue;
+			}
+			uploadScratch.push_back(persistentInstancesData[persistent.regionStart + slot]);
+			persistent.inputs[kept] = persistent.inputs[slot];
+			persistent.hashes[kept] = persistent.hashes[slot];
+			persistent.casters[kept] = persistent.casters[slot];
+			persistent.slotByHash[persistent.hashes[kept]] = static_cast<uint32_t>(kept);
+			++kept;
+		}
+		ASSERT(kept == persistent.seenCount, "Expected %zu matched slots, found %zu", persistent.seenCount, kept);
+		uploadScratch.resize(newRegionStart + newCapacity);
+		persistent.regionStart = newRegionStart;
+		persistent.capacity = newCapacity;
+		persistent.liveCount = kept;
+		persistent.inputs.resize(newCapacity);
+		persistent.hashes.resize(newCapacity);
+		persistent.casters.resize(newCapacity);
+		persistent.seen.assign(newCapacity, 0);
+		std::fill(persistent.seen.begin(), persistent.seen.begin() + kept, 1);
+		++it;
+	}
+	persistentInstancesData.swap(uploadScratch);
+	uploadScratch.clear();
+	++persistentLayoutGeneration;
+}
+
+// Puts the pending instances into the slots nobody matched, and keeps the slots of the mesh contiguous by moving the last
+// ones into any gaps that are left
+void InstancedMeshRenderer::fillPersistentSlots(const templatedState &state, PersistentMesh &persistent, const ShapeVector *queued)
+{
+	size_t slot = 0;
+	while (slot < persistent.liveCount)
+	{
+		if (persistent.seen[slot])
+		{
+			++slot;
+			continue;
+		}
+		releasePersistentSlot(persistent, slot);
+		if (!persistent.pending.empty())
+		{
+			writePersistentSlot(state, persistent, slot, (*queued)[persistent.pending.back()]);
+			persistent.pending.pop_back();
+			++slot;
+			continue;
+		}
+		--persistent.liveCount;
+		if (slot < persistent.liveCount)
+		{
+			movePersistentSlot(persistent, persistent.liveCount, slot);
+		}
+	}
+	while (!persistent.pending.empty())
+	{
+		writePersistentSlot(state, persistent, persistent.liveCount++, (*queued)[persistent.pending.back()]);
+		persistent.pending.pop_back();
+	}
+}
+
+void InstancedMeshRenderer::writePersistentSlot(const templatedState &state, PersistentMesh &persistent, size_t slot, const SHAPE &instance)
+{
+	const size_t idx = persistent.regionStart + slot;
+	persistentInstancesData[idx] = GenerateInstanceData(instance.frame, instance.colour, instance.teamcolour, instance.flag, instance.flag_data, instance.modelMatrix, instance.stretch);
+	persistent.inputs[slot] = instance;
+	persistent.hashes[slot] = hashInstanceInputs(instance);
+	persistent.slotByHash[persistent.hashes[slot]] = static_cast<uint32_t>(slot);
+	if ((state.pieFlag & (pie_SHADOW | pie_STATIC_SHADOW)) != 0)
+	{
+		persistent.casters[slot] = shadowCasterFor(state.shape, persistentInstancesData[idx]);
+	}
+	persistent.seen[slot] = 1;
+	markPersistentSlotDirty(idx);
+}
+
+void InstancedMeshRenderer::movePersistentSlot(PersistentMesh &persistent, size_t from, size_t to)
+{
+	auto it = persistent.slotByHash.find(persistent.hashes[from]);
+	if (it != persistent.slotByHash.end() && it->second == from)
+	{
+		it->second = static_cast<uint32_t>(to);
+	}
+	persistentInstancesData[persistent.regionStart + to] = persistentInstancesData[persistent.regionStart + from];
+	persistent.inputs[to] = persistent.inputs[from];
+	persistent.hashes[to] = persistent.hashes[from];
+	persistent.casters[to] = persistent.casters[from];
+	persistent.seen[to] = persistent.seen[from];
+	markPersistentSlotDirty(persistent.regionStart + to);
+}
+
+void InstancedMeshRenderer::releasePersistentSlot(PersistentMesh &persistent, size_t slot)
+{
+	auto it = persistent.slotByHash.find(persistent.hashes[slot]);
+	if (it != persistent.slotByHash.end() && it->second == slot)
+	{
+		persistent.slotByHash.erase(it);
+	}
+}
+
+void InstancedMeshRenderer::markPersistentSlotDirty(size_t idx)
+{
+	for (auto &bufferState : instanceBufferStates)
+	{
+		// Buffers from before the last layout get everything uploaded anyway
+		if (bufferState.layoutGeneration == persistentLayoutGeneration)
+		{
+			bufferState.dirtySlots.push_back(idx);
+		}
+	}
+}
+
+// Each of the ring buffers gets the slots written since it was last used, followed by the translucent and additive instances
+void InstancedMeshRenderer::uploadInstances(size_t bufferIdx)
+{
+	gfx_api::buffer *buffer = instanceDataBuffers[bufferIdx];
+	InstanceBufferState &bufferState = instanceBufferStates[bufferIdx];
+	const size_t instanceSize = sizeof(gfx_api::Draw3DShapePerInstanceInterleavedData);
+	const size_t persistentCount = persistentInstancesData.size();
+	const size_t totalSize = (persistentCount + instancesData.size()) * instanceSize;
+	if (bufferState.layoutGeneration != persistentLayoutGeneration || buffer->current_buffer_size() < totalSize || bufferState.dirtySlots.size() * 2 > persistentCount)
+	{
+		uploadScratch.assign(persistentInstancesData.begin(), persistentInstancesData.end());
+		uploadScratch.insert(uploadScratch.end(), instancesData.begin(), instancesData.end());
+		buffer->upload(totalSize, uploadScratch.data());
+		uploadScratch.clear();
+		bufferState.layoutGeneration = persistentLayoutGeneration;
+		bufferState.dirtySlots.clear();
+		return;
+	}
+
+	auto &dirtySlots = bufferState.dirtySlots;
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+	dirtySlots.erase(std::unique(dirtySlots.begin(), dirtySlots.end()), dirtySlots.end());
+	for (size_t i = 0; i < dirtySlots.size(); )
+	{
+		size_t runEnd = i + 1;
+		while (runEnd < dirtySlots.size() && dirtySlots[runEnd] == dirtySlots[runEnd - 1] + 1)
+		{
+			++runEnd;
+		}
+		buffer->update(dirtySlots[i] * instanceSize, (runEnd - i) * instanceSize, &persistentInstancesData[dirtySlots[i]], gfx_api::buffer::update_flag::non_overlapping_updates_promise);
+		i = runEnd;
+	}
+	dirtySlots.clear();
+	if (!instancesData.empty())
+	{
+		buffer->update(persistentCount * instanceSize, instancesData.size() * instanceSize, instancesData.data(), gfx_api::buffer::update_flag::non_overlapping_updates_promise);
+	}
+}
+
 bool InstancedMeshRenderer::DrawAll(uint64_t currentGameFrame, const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const Vector3f &cameraPos, const ShadowCascadesInfo& shadowCascades, int drawParts, bool depthPass)
 {
 	perFrameUniformsShaderOnce.reset();
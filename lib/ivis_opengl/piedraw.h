@@ -33,4 +33,8 @@ namespace gfx_api
 void pie_StartMeshes();
 void pie_UpdateLightmap(gfx_api::texture* lightmapTexture, const glm::mat4& modelUVLightmapMatrix);
 void pie_FinalizeMeshes(uint64_t currentGameFrame);
+/// Changes whenever the meshes a depth pass with this light view-projection would draw change (call after pie_FinalizeMeshes)
+uint64_t pie_ShadowCastersSignature(const glm::mat4 &lightViewProjection);
+/// Changes whenever the depth pass images were (or may have been) recreated, discarding their contents
+uint64_t pie_DepthPassGeneration();
 void pie_DrawAllMeshes(uint64_t currentGameFrame, const glm::mat4 &projectionMatrix, const glm::mat4 &viewMatrix, const Vector3f &cameraPos, const ShadowCascadesInfo& shadowMVPMatrix, bool depthPass);
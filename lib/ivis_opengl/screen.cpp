@@ -234,6 +234,7 @@ void screenShutDown()
 
 	delete pie_internal::rectBuffer;
 	pie_internal::rectBuffer = nullptr;
+	pie_ShutdownImageBatches();
 
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
@@ -20,6 +20,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/frameresource.h"
+#include "lib/framework/physfs_ext.h"
 
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -28,8 +29,10 @@
 #include "lib/ivis_opengl/png_util.h"
 
 #include "screen.h"
+#include "lib/framework/wzapp.h"
 
 #include <algorithm>
+#include <deque>
 #include <unordered_map>
 
 #if defined(__clang__)
@@ -52,11 +55,28 @@
 
 //*************************************************************************
 
+/// Streaming state of a texture page loaded through iV_GetTexture while a streaming budget is set
+struct iTexStreaming
+{
+	bool streamed = false;        ///< Whether the page is managed by the streaming at all
+	bool fullResolution = false;  ///< Whether the full resolution texture is loaded, rather than the small one
+	bool loading = false;         ///< Whether a load is queued on the streaming thread
+	bool loadingFullResolution = false; ///< Whether the queued load is for the full resolution texture
+	int maxWidth = -1;            ///< Max size the texture was requested with
+	int maxHeight = -1;
+	size_t memorySize = 0;        ///< Size of the loaded mip levels
+	size_t smallMemorySize = 0;   ///< Size of the mip levels at the small size
+	size_t fullMemorySize = 0;    ///< Size of the mip levels at full resolution (estimated until loaded once)
+	uint32_t lastUsedFrame = 0;
+	uint32_t generation = 0;      ///< Changes whenever the texture is replaced, to drop loads that were queued before
+};
+
 struct iTexPage
 {
 	std::string filename;
 	gfx_api::texture* id = nullptr;
 	gfx_api::texture_type textureType = gfx_api::texture_type::user_interface;
+	iTexStreaming streaming;
 
 	iTexPage() = default;
 
@@ -66,6 +86,7 @@ struct iTexPage
 		id = input.id;
 		input.id = nullptr;
 		std::swap(textureType, input.textureType);
+		std::swap(streaming, input.streaming);
 	}
 
 	~iTexPage()
@@ -115,6 +136,8 @@ void pie_AssignTexture(size_t page, gfx_api::texture* texture)
 	if (_TEX_PAGE[page].id)
 		delete _TEX_PAGE[page].id;
 	_TEX_PAGE[page].id = texture;
+	_TEX_PAGE[page].streaming.streamed = false;
+	++_TEX_PAGE[page].streaming.generation;
 }
 
 static size_t pie_AddTexPage_Impl(gfx_api::texture *pTexture, const char *filename, gfx_api::texture_type textureType, size_t page)
@@ -128,6 +151,8 @@ static size_t pie_AddTexPage_Impl(gfx_api::texture *pTexture, const char *filena
 		delete _TEX_PAGE[page].id;
 	_TEX_PAGE[page].id = pTexture;
 	_TEX_PAGE[page].textureType = textureType;
+	_TEX_PAGE[page].streaming.streamed = false;
+	++_TEX_PAGE[page].streaming.generation;
 
 	/* Send back the texpage number so we can store it in the IMD */
 	return page;
@@ -190,6 +215,298 @@ gfx_api::texture* loadTextureHandleGraphicsOverrides(const char *filename, gfx_a
 	return pTexture;
 }
 
+// MARK: - Texture streaming
+
+// While a budget is set, model textures are first loaded with at most TEXTURE_STREAM_INITIAL_SIZE pixels per side (for
+// .ktx2 files, only the small mip levels get transcoded). Textures that are drawn get loaded at full resolution by the
+// streaming thread, most recently drawn first, while the loaded textures fit in the budget. If they no longer fit, the
+// textures that were not drawn for the longest time go back to the small size.
+
+#define TEXTURE_STREAM_INITIAL_SIZE 256
+/// Textures drawn within this many frames are never dropped back to the small size
+#define TEXTURE_STREAM_KEEP_FRAMES 120
+/// At most this many loads are queued at a time, so the most wanted textures are loaded first
+#define TEXTURE_STREAM_MAX_QUEUED 4
+/// Until a texture was loaded at full resolution once, assume it is this many times bigger than the small size
+/// (1024 pixels per side, the common size of model textures)
+#define TEXTURE_STREAM_ESTIMATED_GROWTH 16
+
+static size_t textureStreamingBudget = 0;
+static uint32_t textureStreamFrame = 1;
+
+struct TextureStreamRequest
+{
+	size_t page;
+	uint32_t generation;
+	bool fullResolution;
+	std::string filename;
+	gfx_api::texture_type textureType;
+	int maxWidth;
+	int maxHeight;
+	std::vector<std::unique_ptr<iV_BaseImage>> levels; ///< Filled in by the streaming thread
+};
+
+static WZ_THREAD *textureStreamThread = nullptr;
+static WZ_SEMAPHORE *textureStreamSemaphore = nullptr;
+static WZ_MUTEX *textureStreamMutex = nullptr;
+static std::deque<std::unique_ptr<TextureStreamRequest>> textureStreamRequests;   ///< Protected by textureStreamMutex
+static std::vector<std::unique_ptr<TextureStreamRequest>> textureStreamResults;   ///< Protected by textureStreamMutex
+static volatile bool textureStreamQuit = false;
+
+static std::vector<std::unique_ptr<iV_BaseImage>> loadTextureLevelsHandleGraphicsOverrides(const char *filename, gfx_api::texture_type textureType, int maxWidth, int maxHeight)
+{
+	std::string loadPath = WZ_CURRENT_GRAPHICS_OVERRIDES_PREFIX "/texpages/";
+	loadPath += filename;
+	auto levels = gfx_api::loadTextureLevelsFromFile(loadPath.c_str(), textureType, maxWidth, maxHeight, true);
+	if (levels.empty())
+	{
+		loadPath = "texpages/";
+		loadPath += filename;
+		levels = gfx_api::loadTextureLevelsFromFile(loadPath.c_str(), textureType, maxWidth, maxHeight);
+	}
+	return levels;
+}
+
+static size_t textureLevelsMemorySize(const std::vector<std::unique_ptr<iV_BaseImage>>& levels)
+{
+	size_t size = 0;
+	for (const auto& level : levels)
+	{
+		size += level->data_size();
+	}
+	return size;
+}
+
+static int textureStreamThreadFunc(void *)
+{
+	while (true)
+	{
+		wzSemaphoreWait(textureStreamSemaphore);  // Wait until needed.
+		if (textureStreamQuit)
+		{
+			break;
+		}
+
+		wzMutexLock(textureStreamMutex);
+		if (textureStreamRequests.empty())
+		{
+			wzMutexUnlock(textureStreamMutex);
+			continue;
+		}
+		auto request = std::move(textureStreamRequests.front());
+		textureStreamRequests.pop_front();
+		wzMutexUnlock(textureStreamMutex);
+
+		request->levels = loadTextureLevelsHandleGraphicsOverrides(request->filename.c_str(), request->textureType, request->maxWidth, request->maxHeight);
+
+		wzMutexLock(textureStreamMutex);
+		textureStreamResults.push_back(std::move(request));
+		wzMutexUnlock(textureStreamMutex);
+	}
+	return 0;
+}
+
+static void textureStreamShutdown()
+{
+	if (textureStreamThread == nullptr)
+	{
+		return;
+	}
+	textureStreamQuit = true;
+	wzSemaphorePost(textureStreamSemaphore);  // Wake up the thread
+	wzThreadJoin(textureStreamThread);
+	textureStreamThread = nullptr;
+	textureStreamRequests.clear();
+	textureStreamResults.clear();
+	wzSemaphoreDestroy(textureStreamSemaphore);
+	textureStreamSemaphore = nullptr;
+	wzMutexDestroy(textureStreamMutex);
+	textureStreamMutex = nullptr;
+}
+
+/// Small size to load a texture at, given the max size it was requested with
+static int textureStreamInitialSize(int maxSize)
+{
+	return (maxSize > 0) ? std::min(maxSize, TEXTURE_STREAM_INITIAL_SIZE) : TEXTURE_STREAM_INITIAL_SIZE;
+}
+
+static void textureStreamQueue(size_t page, bool fullResolution)
+{
+	if (textureStreamThread == nullptr)
+	{
+		textureStreamQuit = false;
+		textureStreamSemaphore = wzSemaphoreCreate(0);
+		textureStreamMutex = wzMutexCreate();
+		textureStreamThread = wzThreadCreate(textureStreamThreadFunc, nullptr, "wzTexStream");
+		wzThreadStart(textureStreamThread);
+	}
+
+	iTexPage &texPage = _TEX_PAGE[page];
+	texPage.streaming.loading = true;
+	texPage.streaming.loadingFullResolution = fullResolution;
+	auto request = std::make_unique<TextureStreamRequest>();
+	request->page = page;
+	request->generation = texPage.streaming.generation;
+	request->fullResolution = fullResolution;
+	request->filename = texPage.filename;
+	request->textureType = texPage.textureType;
+	request->maxWidth = (fullResolution) ? texPage.streaming.maxWidth : textureStreamInitialSize(texPage.streaming.maxWidth);
+	request->maxHeight = (fullResolution) ? texPage.streaming.maxHeight : textureStreamInitialSize(texPage.streaming.maxHeight);
+
+	wzMutexLock(textureStreamMutex);
+	textureStreamRequests.push_back(std::move(request));
+	wzMutexUnlock(textureStreamMutex);
+	wzSemaphorePost(textureStreamSemaphore);
+}
+
+static optional<size_t> iV_GetStreamedTexture(const char *filename, gfx_api::texture_type textureType, int maxWidth, int maxHeight)
+{
+	auto levels = loadTextureLevelsHandleGraphicsOverrides(filename, textureType, textureStreamInitialSize(maxWidth), textureStreamInitialSize(maxHeight));
+	if (levels.empty())
+	{
+		debug(LOG_ERROR, "Failed to load %s", filename);
+		return nullopt;
+	}
+	const size_t memorySize = textureLevelsMemorySize(levels);
+	// If the image is smaller than the small size, it is already at full resolution
+	const bool alreadyFullResolution = std::max(levels.front()->width(), levels.front()->height()) < static_cast<unsigned int>(std::min(textureStreamInitialSize(maxWidth), textureStreamInitialSize(maxHeight)));
+	gfx_api::texture *pTexture = gfx_api::context::get().createTextureFromLevels(std::move(levels), filename);
+	if (!pTexture)
+	{
+		debug(LOG_ERROR, "Failed to create texture %s", filename);
+		return nullopt;
+	}
+
+	size_t page = pie_AddTexPage(pTexture, filename, textureType);
+	iTexStreaming &streaming = _TEX_PAGE[page].streaming;
+	streaming.streamed = !alreadyFullResolution;
+	streaming.fullResolution = alreadyFullResolution;
+	streaming.maxWidth = maxWidth;
+	streaming.maxHeight = maxHeight;
+	streaming.memorySize = memorySize;
+	streaming.smallMemorySize = memorySize;
+	streaming.fullMemorySize = (alreadyFullResolution) ? memorySize : memorySize * TEXTURE_STREAM_ESTIMATED_GROWTH;
+	return optional<size_t>(page);
+}
+
+void pie_SetTextureStreamingBudget(size_t bytes)
+{
+	textureStreamingBudget = bytes;
+}
+
+void pie_TexMarkUsed(size_t page)
+{
+	if (page != iV_TEX_INVALID && page < _TEX_PAGE.size())
+	{
+		_TEX_PAGE[page].streaming.lastUsedFrame = textureStreamFrame;
+	}
+}
+
+void pie_TexUpdateStreaming()
+{
+	++textureStreamFrame;
+
+	// Swap in the textures the streaming thread finished
+	std::vector<std::unique_ptr<TextureStreamRequest>> results;
+	if (textureStreamMutex != nullptr)
+	{
+		wzMutexLock(textureStreamMutex);
+		std::swap(results, textureStreamResults);
+		wzMutexUnlock(textureStreamMutex);
+	}
+	for (auto &result : results)
+	{
+		if (result->page >= _TEX_PAGE.size() || _TEX_PAGE[result->page].streaming.generation != result->generation)
+		{
+			continue; // replaced in the meantime
+		}
+		iTexPage &texPage = _TEX_PAGE[result->page];
+		texPage.streaming.loading = false;
+		if (result->levels.empty())
+		{
+			debug(LOG_ERROR, "Failed to stream %s", texPage.filename.c_str());
+			texPage.streaming.streamed = false; // keep what we have
+			continue;
+		}
+		const size_t memorySize = textureLevelsMemorySize(result->levels);
+		gfx_api::texture *pTexture = gfx_api::context::get().createTextureFromLevels(std::move(result->levels), texPage.filename);
+		if (!pTexture)
+		{
+			texPage.streaming.streamed = false;
+			continue;
+		}
+		delete texPage.id;
+		texPage.id = pTexture;
+		texPage.streaming.fullResolution = result->fullResolution;
+		texPage.streaming.memorySize = memorySize;
+		if (result->fullResolution)
+		{
+			texPage.streaming.fullMemorySize = memorySize;
+		}
+		else
+		{
+			texPage.streaming.smallMemorySize = memorySize;
+		}
+	}
+
+	// Work out what is loaded (counting queued loads at the size they will have), and which textures are candidates to load or drop
+	size_t loadedSize = 0;
+	size_t queued = 0;
+	std::vector<size_t> wanted;
+	std::vector<size_t> droppable;
+	for (size_t page = 0; page < _TEX_PAGE.size(); ++page)
+	{
+		const iTexStreaming &streaming = _TEX_PAGE[page].streaming;
+		if (!streaming.streamed)
+		{
+			continue;
+		}
+		if (streaming.loading)
+		{
+			loadedSize += (streaming.loadingFullResolution) ? streaming.fullMemorySize : streaming.smallMemorySize;
+			++queued;
+			continue;
+		}
+		loadedSize += streaming.memorySize;
+		if (!streaming.fullResolution && streaming.lastUsedFrame + 1 >= textureStreamFrame)
+		{
+			wanted.push_back(page);
+		}
+		else if (streaming.fullResolution && streaming.lastUsedFrame + TEXTURE_STREAM_KEEP_FRAMES < textureStreamFrame)
+		{
+			droppable.push_back(page);
+		}
+	}
+
+	// Drop the textures that were not used for the longest time, until the rest fits
+	if (textureStreamingBudget > 0 && loadedSize > textureStreamingBudget)
+	{
+		std::sort(droppable.begin(), droppable.end(), [](size_t a, size_t b) { return _TEX_PAGE[a].streaming.lastUsedFrame < _TEX_PAGE[b].streaming.lastUsedFrame; });
+		for (size_t i = 0; i < droppable.size() && loadedSize > textureStreamingBudget && queued < TEXTURE_STREAM_MAX_QUEUED; ++i)
+		{
+			const iTexStreaming &streaming = _TEX_PAGE[droppable[i]].streaming;
+			loadedSize -= streaming.memorySize - std::min(streaming.memorySize, streaming.smallMemorySize);
+			textureStreamQueue(droppable[i], false);
+			++queued;
+		}
+		return;
+	}
+
+	// Load the wanted textures at full resolution while there is room for them (everything, if streaming got switched off)
+	for (size_t i = 0; i < wanted.size() && queued < TEXTURE_STREAM_MAX_QUEUED; ++i)
+	{
+		const iTexStreaming &streaming = _TEX_PAGE[wanted[i]].streaming;
+		const size_t growth = streaming.fullMemorySize - std::min(streaming.fullMemorySize, streaming.memorySize);
+		if (textureStreamingBudget > 0 && loadedSize + growth > textureStreamingBudget)
+		{
+			continue;
+		}
+		loadedSize += growth;
+		textureStreamQueue(wanted[i], true);
+		++queued;
+	}
+}
+
 /** Retrieve the texture number for a given texture resource.
  *
  *  @note We keep textures in a separate data structure _TEX_PAGE apart from the
@@ -214,6 +531,11 @@ optional<size_t> iV_GetTexture(const char *filename, gfx_api::texture_type textu
 		return it->second;
 	}
 
+	if (textureStreamingBudget > 0 && textureType != gfx_api::texture_type::user_interface)
+	{
+		return iV_GetStreamedTexture(filename, textureType, maxWidth, maxHeight);
+	}
+
 	gfx_api::texture *pTexture = loadTextureHandleGraphicsOverrides(filename, textureType, maxWidth, maxHeight);
 	if (!pTexture)
 	{
@@ -269,8 +591,43 @@ bool debugReloadTexturesFromDisk(const std::unordered_set<size_t>& texPages)
 	return true;
 }
 
+size_t pie_PrecompressTextures()
+{
+	if (!wz_texture_compression)
+	{
+		debug(LOG_ERROR, "Texture compression is disabled - nothing to precompress");
+		return 0;
+	}
+	std::vector<std::string> filenames;
+	WZ_PHYSFS_enumerateFiles("texpages", [&filenames](const char *file) -> bool {
+		std::string filename = file;
+		// Only (non-aux) model textures are run-time compressed
+		if (strEndsWith(filename, ".png") && !strEndsWith(filename, iV_TEXNAME_TCSUFFIX ".png") && !strEndsWith(filename, "_nm.png") && !strEndsWith(filename, "_sm.png"))
+		{
+			filenames.push_back(filename);
+		}
+		return true; // continue
+	});
+	std::sort(filenames.begin(), filenames.end());
+
+	size_t count = 0;
+	for (const auto& filename : filenames)
+	{
+		// loading fills the compressed texture cache
+		auto levels = loadTextureLevelsHandleGraphicsOverrides(filename.c_str(), gfx_api::texture_type::game_texture, -1, -1);
+		if (!levels.empty())
+		{
+			debug(LOG_INFO, "Precompressed texture: %s", filename.c_str());
+			++count;
+		}
+	}
+	return count;
+}
+
 void pie_TexShutDown()
 {
+	textureStreamShutdown();
+
 	// TODO, lazy deletions for faster loading of next level
 	debug(LOG_TEXTURE, "Cleaning out %u textures", static_cast<unsigned>(_TEX_PAGE.size()));
 	_TEX_PAGE.clear();
@@ -58,6 +58,18 @@ std::string pie_MakeTexPageTCMaskName(const std::string& filename);
 
 bool debugReloadTexturesFromDisk(const std::unordered_set<size_t>& texPages);
 
+/// Load (and so compress, and cache) all model textures. Returns the number loaded.
+size_t pie_PrecompressTextures();
+
+/// Memory (in bytes) model textures may use before the ones drawn least recently are dropped back to a small size.
+/// 0 loads them at full resolution right away.
+void pie_SetTextureStreamingBudget(size_t bytes);
+/// Note that the texture page is drawn this frame
+void pie_TexMarkUsed(size_t page);
+/// Once per frame (from the main loop, outside of the frame's rendering): swap in the textures that finished loading,
+/// and queue the next ones to load or drop
+void pie_TexUpdateStreaming();
+
 //*************************************************************************
 
 void pie_TexShutDown();
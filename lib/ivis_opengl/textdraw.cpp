@@ -59,6 +59,7 @@ static float font_colour[4] = {1.f, 1.f, 1.f, 1.f};
 #endif
 #include <unordered_map>
 #include <memory>
+#include <list>
 #include <limits>
 #include <climits>
 
@@ -1256,8 +1257,6 @@ static FTFace &getFTFace(iV_fonts FontID, hb_script_t script)
 	}
 }
 
-static gfx_api::texture* textureID = nullptr;
-
 void iV_TextInit(unsigned int horizScalePercentage, unsigned int vertScalePercentage)
 {
 	if (horizScalePercentage > 100 && horizScalePercentage < 200)
@@ -1332,6 +1331,8 @@ void iV_TextInit(unsigned int horizScalePercentage, unsigned int vertScalePercen
 	bLoadedTextSystem = true;
 }
 
+static void clearRenderedTextCache(); // forward-declare
+
 void iV_TextShutdown()
 {
 	glyphCache->clear();
@@ -1341,9 +1342,8 @@ void iV_TextShutdown()
 	baseFonts = nullptr;
 	delete cjkFonts;
 	cjkFonts = nullptr;
-	delete textureID;
-	textureID = nullptr;
 	fontToEllipsisMap.clear();
+	clearRenderedTextCache();
 	clearFontDataCache();
 	bLoadedTextSystem = false;
 }
@@ -1695,6 +1695,242 @@ std::vector<TextLine> iV_FormatText(const WzString& String, UDWORD MaxWidth, UDW
 	return lineDrawResults;
 }
 
+// MARK: - Rendered text cache
+
+// Rendered (shaped + rasterized) text is cached by (text, font), so identical labels share one rasterization.
+// Small ones are packed into a few shared atlas textures, instead of each getting a texture of its own.
+// Entries that are still used by a WzText are kept, the others are dropped least-recently-used first.
+// (The cache is cleared when the text scale factor changes, along with the rest of the text system.)
+
+#define TEXT_ATLAS_SIZE 1024
+#define TEXT_ATLAS_MAX_PAGES 4
+#define TEXT_ATLAS_MAX_ENTRY_HEIGHT 128
+#define TEXT_ATLAS_SHELF_ROUNDING 8
+#define TEXT_ATLAS_PADDING 1 // transparent border around each entry, so bilinear filtering doesn't pick up its neighbours
+#define TEXT_CACHE_MAX_ENTRIES 1024 // (not counting the ones still used by a WzText)
+
+struct TextAtlasShelf
+{
+	uint32_t y;
+	uint32_t height;
+	uint32_t usedWidth = 0;
+	size_t liveEntries = 0;
+
+	TextAtlasShelf(uint32_t y, uint32_t height) : y(y), height(height) { }
+};
+
+struct TextAtlasPage
+{
+	std::unique_ptr<gfx_api::texture> texture;
+	std::vector<TextAtlasShelf> shelves;
+	uint32_t nextShelfY = 0;
+
+	optional<Vector2i> allocate(uint32_t width, uint32_t height, size_t &shelfIdx)
+	{
+		const uint32_t shelfHeight = ((height + TEXT_ATLAS_SHELF_ROUNDING - 1) / TEXT_ATLAS_SHELF_ROUNDING) * TEXT_ATLAS_SHELF_ROUNDING;
+		for (size_t i = 0; i < shelves.size(); ++i)
+		{
+			TextAtlasShelf &shelf = shelves[i];
+			// use a shelf of exactly this height, or an emptied one that is not much taller
+			bool heightFits = (shelf.height == shelfHeight) || (shelf.liveEntries == 0 && shelf.height >= shelfHeight && shelf.height <= shelfHeight * 2);
+			if (heightFits && shelf.usedWidth + width <= TEXT_ATLAS_SIZE)
+			{
+				shelfIdx = i;
+				Vector2i position(shelf.usedWidth, shelf.y);
+				shelf.usedWidth += width;
+				++shelf.liveEntries;
+				return position;
+			}
+		}
+		if (nextShelfY + shelfHeight > TEXT_ATLAS_SIZE)
+		{
+			return nullopt;
+		}
+		shelves.emplace_back(nextShelfY, shelfHeight);
+		nextShelfY += shelfHeight;
+		shelfIdx = shelves.size() - 1;
+		shelves.back().usedWidth = width;
+		shelves.back().liveEntries = 1;
+		return Vector2i(0, shelves.back().y);
+	}
+
+	void release(size_t shelfIdx)
+	{
+		TextAtlasShelf &shelf = shelves[shelfIdx];
+		if (--shelf.liveEntries == 0)
+		{
+			shelf.usedWidth = 0;
+		}
+	}
+};
+
+struct TextCacheKey
+{
+	std::string text;
+	iV_fonts fontID;
+
+	bool operator==(const TextCacheKey &other) const { return fontID == other.fontID && text == other.text; }
+};
+
+struct TextCacheKeyHash
+{
+	std::size_t operator()(const TextCacheKey& k) const noexcept
+	{
+		return std::hash<std::string>{}(k.text) ^ (static_cast<size_t>(k.fontID) * 0x9E3779B97F4A7C15ull);
+	}
+};
+
+struct RenderedTextCacheEntry
+{
+	std::shared_ptr<TextAtlasPage> page; // if in an atlas
+	size_t shelfIdx = 0;
+	std::unique_ptr<gfx_api::texture> ownTexture; // if too big for an atlas
+	Vector2i textureSize = Vector2i(0, 0);
+	Vector2i origin = Vector2i(0, 0); // position of the rendered text in the texture
+	Vector2i dimensions = Vector2i(0, 0);
+	Vector2i offsets = Vector2i(0, 0);
+	Vector2i layoutMetrics = Vector2i(0, 0);
+	std::list<TextCacheKey>::iterator lruPosition;
+
+	gfx_api::texture* texture() const
+	{
+		return (page) ? page->texture.get() : ownTexture.get();
+	}
+
+	~RenderedTextCacheEntry()
+	{
+		if (page)
+		{
+			page->release(shelfIdx);
+		}
+	}
+};
+
+static std::vector<std::shared_ptr<TextAtlasPage>> textAtlasPages;
+static std::unordered_map<TextCacheKey, std::shared_ptr<RenderedTextCacheEntry>, TextCacheKeyHash> renderedTextCache;
+static std::list<TextCacheKey> renderedTextLRU; // most recently used first
+
+// Drops the least recently used entry that no WzText uses. Returns false if there is none.
+static bool evictRenderedText()
+{
+	for (size_t remaining = renderedTextLRU.size(); remaining > 0; --remaining)
+	{
+		auto cacheIt = renderedTextCache.find(renderedTextLRU.back());
+		if (cacheIt->second.use_count() == 1)
+		{
+			renderedTextCache.erase(cacheIt);
+			renderedTextLRU.pop_back();
+			return true;
+		}
+		// still used by a WzText, which counts as recently used
+		renderedTextLRU.splice(renderedTextLRU.begin(), renderedTextLRU, std::prev(renderedTextLRU.end()));
+	}
+	return false;
+}
+
+static bool addToTextAtlas(RenderedTextCacheEntry &entry, const iV_Image &bitmap, const std::string &debugName)
+{
+	const uint32_t paddedWidth = bitmap.width() + TEXT_ATLAS_PADDING * 2;
+	const uint32_t paddedHeight = bitmap.height() + TEXT_ATLAS_PADDING * 2;
+	if (paddedWidth > TEXT_ATLAS_SIZE / 2 || paddedHeight > TEXT_ATLAS_MAX_ENTRY_HEIGHT)
+	{
+		return false;
+	}
+
+	optional<Vector2i> position;
+	size_t shelfIdx = 0;
+	std::shared_ptr<TextAtlasPage> page;
+	do
+	{
+		for (auto &candidatePage : textAtlasPages)
+		{
+			position = candidatePage->allocate(paddedWidth, paddedHeight, shelfIdx);
+			if (position.has_value())
+			{
+				page = candidatePage;
+				break;
+			}
+		}
+	} while (!position.has_value() && textAtlasPages.size() >= TEXT_ATLAS_MAX_PAGES && evictRenderedText());
+
+	if (!position.has_value())
+	{
+		if (textAtlasPages.size() >= TEXT_ATLAS_MAX_PAGES)
+		{
+			return false;
+		}
+		page = std::make_shared<TextAtlasPage>();
+		iV_Image clearImage;
+		clearImage.allocate(TEXT_ATLAS_SIZE, TEXT_ATLAS_SIZE, bitmap.channels(), true);
+		page->texture = std::unique_ptr<gfx_api::texture>(gfx_api::context::get().createTextureForCompatibleImageUploads(1, clearImage, "text::atlas"));
+		ASSERT_OR_RETURN(false, page->texture != nullptr, "Failed to create text atlas");
+		page->texture->upload(0u, clearImage);
+		textAtlasPages.push_back(page);
+		position = page->allocate(paddedWidth, paddedHeight, shelfIdx);
+		ASSERT_OR_RETURN(false, position.has_value(), "Failed to allocate in new text atlas");
+	}
+
+	iV_Image paddedBitmap;
+	paddedBitmap.allocate(paddedWidth, paddedHeight, bitmap.channels(), true);
+	const size_t rowSize = bitmap.width() * bitmap.channels();
+	for (unsigned int y = 0; y < bitmap.height(); ++y)
+	{
+		memcpy(paddedBitmap.bmp_w() + ((y + TEXT_ATLAS_PADDING) * paddedWidth + TEXT_ATLAS_PADDING) * bitmap.channels(), bitmap.bmp() + y * rowSize, rowSize);
+	}
+	if (!page->texture->upload_sub(0u, position->x, position->y, paddedBitmap))
+	{
+		debug(LOG_ERROR, "Failed to upload text to atlas: %s", debugName.c_str());
+		page->release(shelfIdx);
+		return false;
+	}
+
+	entry.page = std::move(page);
+	entry.shelfIdx = shelfIdx;
+	entry.textureSize = Vector2i(TEXT_ATLAS_SIZE, TEXT_ATLAS_SIZE);
+	entry.origin = Vector2i(position->x + TEXT_ATLAS_PADDING, position->y + TEXT_ATLAS_PADDING);
+	return true;
+}
+
+static std::shared_ptr<RenderedTextCacheEntry> getRenderedText(const WzString& text, iV_fonts fontID)
+{
+	TextCacheKey key {text.toUtf8(), fontID};
+	auto it = renderedTextCache.find(key);
+	if (it != renderedTextCache.end())
+	{
+		renderedTextLRU.splice(renderedTextLRU.begin(), renderedTextLRU, it->second->lruPosition);
+		return it->second;
+	}
+
+	DrawTextResult drawResult = getShaper().drawText(text, fontID);
+	auto entry = std::make_shared<RenderedTextCacheEntry>();
+	entry->dimensions = (drawResult.text.bitmap) ? Vector2i(drawResult.text.bitmap->width(), drawResult.text.bitmap->height()) : Vector2i(0,0);
+	entry->offsets = Vector2i(drawResult.text.offset_x, drawResult.text.offset_y);
+	entry->layoutMetrics = Vector2i(drawResult.layoutMetrics.width, drawResult.layoutMetrics.height);
+	if (entry->dimensions.x > 0 && entry->dimensions.y > 0)
+	{
+		const iV_Image &bitmap = *(drawResult.text.bitmap.get());
+		if (!addToTextAtlas(*entry, bitmap, key.text))
+		{
+			entry->ownTexture = std::unique_ptr<gfx_api::texture>(gfx_api::context::get().createTextureForCompatibleImageUploads(1, bitmap, std::string("text::") + key.text));
+			entry->ownTexture->upload(0u, bitmap);
+			entry->textureSize = entry->dimensions;
+		}
+	}
+
+	renderedTextLRU.push_front(key);
+	entry->lruPosition = renderedTextLRU.begin();
+	renderedTextCache.emplace(std::move(key), entry);
+	while (renderedTextCache.size() > TEXT_CACHE_MAX_ENTRIES && evictRenderedText()) { }
+	return entry;
+}
+
+static void clearRenderedTextCache()
+{
+	renderedTextCache.clear();
+	renderedTextLRU.clear();
+	textAtlasPages.clear(); // (pages still used by a WzText stay alive until it is redrawn)
+}
+
 // Needs modification
 void iV_DrawTextRotated(const char* string, float XPos, float YPos, float rotation, iV_fonts fontID)
 {
@@ -1711,15 +1947,12 @@ void iV_DrawTextRotated(const char* string, float XPos, float YPos, float rotati
 	color.byte.b = static_cast<UBYTE>(font_colour[2] * 255.f);
 	color.byte.a = static_cast<UBYTE>(font_colour[3] * 255.f);
 
-	DrawTextResult drawResult = getShaper().drawText(string, fontID);
-
-	if (drawResult.text.bitmap && drawResult.text.bitmap->width() > 0 && drawResult.text.bitmap->height() > 0)
+	auto rendered = getRenderedText(string, fontID);
+	gfx_api::texture* texture = rendered->texture();
+	if (texture)
 	{
-		if (textureID)
-			delete textureID;
-		textureID = gfx_api::context::get().createTextureForCompatibleImageUploads(1, *(drawResult.text.bitmap.get()), std::string("text::") + string);
-		textureID->upload(0u, *(drawResult.text.bitmap.get()));
-		iV_DrawImageText(*textureID, Vector2f(XPos, YPos), Vector2f((float)drawResult.text.offset_x / _horizScaleFactor, (float)drawResult.text.offset_y / _vertScaleFactor), Vector2f((float)drawResult.text.bitmap->width() / _horizScaleFactor, (float)drawResult.text.bitmap->height() / _vertScaleFactor), rotation, color);
+		WzClippingRectF textRectInPixels(rendered->origin.x, rendered->origin.y, rendered->dimensions.x, rendered->dimensions.y);
+		iV_DrawImageTextClipped(*texture, rendered->textureSize, Vector2f(XPos, YPos), Vector2f((float)rendered->offsets.x / _horizScaleFactor, (float)rendered->offsets.y / _vertScaleFactor), Vector2f((float)rendered->dimensions.x / _horizScaleFactor, (float)rendered->dimensions.y / _vertScaleFactor), rotation, color, textRectInPixels);
 	}
 }
 
@@ -1773,22 +2006,8 @@ void WzText::drawAndCacheText(const WzString& string, iV_fonts fontID)
 	mPtsLineSize = metricsHeight_PixelsToPoints((type->size->metrics.ascender - type->size->metrics.descender) >> 6);
 	mPtsBelowBase = metricsHeight_PixelsToPoints(type->size->metrics.descender >> 6);
 
-	DrawTextResult drawResult = getShaper().drawText(string, fontID);
-	dimensions = (drawResult.text.bitmap) ? Vector2i(drawResult.text.bitmap->width(), drawResult.text.bitmap->height()) : Vector2i(0,0);
-	offsets = Vector2i(drawResult.text.offset_x, drawResult.text.offset_y);
-	layoutMetrics = Vector2i(drawResult.layoutMetrics.width, drawResult.layoutMetrics.height);
-
-	if (texture)
-	{
-		delete texture;
-		texture = nullptr;
-	}
-
-	if (dimensions.x > 0 && dimensions.y > 0)
-	{
-		texture = gfx_api::context::get().createTextureForCompatibleImageUploads(1, *(drawResult.text.bitmap.get()), std::string("text::") + string.toUtf8());
-		texture->upload(0u, *(drawResult.text.bitmap.get()));
-	}
+	rendered = getRenderedText(string, fontID);
+	layoutMetrics = rendered->layoutMetrics;
 }
 
 void WzText::redrawAndCacheText()
@@ -1803,35 +2022,22 @@ WzText::WzText(const WzString &string, iV_fonts fontID)
 
 WzText::~WzText()
 {
-	if (texture)
-		delete texture;
 }
 
 WzText& WzText::operator=(WzText&& other)
 {
 	if (this != &other)
 	{
-		// Free the existing texture, if any.
-		if (texture)
-		{
-			delete texture;
-		}
-
 		// Get the other data
-		texture = other.texture;
+		rendered = std::move(other.rendered);
 		mFontID = other.mFontID;
 		mText = std::move(other.mText);
 		mPtsAboveBase = other.mPtsAboveBase;
 		mPtsBelowBase = other.mPtsBelowBase;
 		mPtsLineSize = other.mPtsLineSize;
-		offsets = other.offsets;
-		dimensions = other.dimensions;
 		mRenderingHorizScaleFactor = other.mRenderingHorizScaleFactor;
 		mRenderingVertScaleFactor = other.mRenderingVertScaleFactor;
 		layoutMetrics = other.layoutMetrics;
-
-		// Reset other's texture
-		other.texture = nullptr;
 	}
 	return *this;
 }
@@ -1859,12 +2065,15 @@ void WzText::renderClipped(Vector2f position, PIELIGHT colour, WzRect screenClip
 {
 	updateCacheIfNecessary();
 
+	gfx_api::texture* texture = (rendered) ? rendered->texture() : nullptr;
 	if (texture == nullptr)
 	{
 		// A texture will not always be created. (For example, if the rendered text is empty.)
 		// No need to render if there's nothing to render.
 		return;
 	}
+	const Vector2i& dimensions = rendered->dimensions;
+	const Vector2i& offsets = rendered->offsets;
 
 	Vector2f visualOrigin(position.x, position.y + mPtsAboveBase);
 	int logicalDisplayWidth = static_cast<int>(dimensions.x / mRenderingHorizScaleFactor);
@@ -1882,8 +2091,8 @@ void WzText::renderClipped(Vector2f position, PIELIGHT colour, WzRect screenClip
 	clippingRect.translateBy(static_cast<int>(-visualOrigin.x), static_cast<int>(-visualOrigin.y)); // translate to 0,0 origin
 
 	WzClippingRectF clippingRectInPixels(
-		clippingRect.left() * mRenderingHorizScaleFactor,
-		clippingRect.top() * mRenderingVertScaleFactor,
+		rendered->origin.x + clippingRect.left() * mRenderingHorizScaleFactor,
+		rendered->origin.y + clippingRect.top() * mRenderingVertScaleFactor,
 		clippingRect.width() * mRenderingHorizScaleFactor,
 		clippingRect.height() * mRenderingVertScaleFactor
 	);
@@ -1893,19 +2102,22 @@ void WzText::renderClipped(Vector2f position, PIELIGHT colour, WzRect screenClip
 		std::min(logicalDisplayHeight, clippingRect.height())
 	);
 
-	iV_DrawImageTextClipped(*texture, dimensions, position + Vector2f(clippingRect.x(), clippingRect.y()), Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), logicalDrawSize, 0.f, colour, clippingRectInPixels);
+	iV_DrawImageTextClipped(*texture, rendered->textureSize, position + Vector2f(clippingRect.x(), clippingRect.y()), Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), logicalDrawSize, 0.f, colour, clippingRectInPixels);
 }
 
 void WzText::render(Vector2f position, PIELIGHT colour, float rotation, int maxWidth, int maxHeight)
 {
 	updateCacheIfNecessary();
 
+	gfx_api::texture* texture = (rendered) ? rendered->texture() : nullptr;
 	if (texture == nullptr)
 	{
 		// A texture will not always be created. (For example, if the rendered text is empty.)
 		// No need to render if there's nothing to render.
 		return;
 	}
+	const Vector2i& dimensions = rendered->dimensions;
+	const Vector2i& offsets = rendered->offsets;
 
 	if (rotation != 0.f)
 	{
@@ -1914,16 +2126,16 @@ void WzText::render(Vector2f position, PIELIGHT colour, float rotation, int maxW
 
 	if (maxWidth <= 0 && maxHeight <= 0)
 	{
-		iV_DrawImageText(*texture, position, Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), Vector2f(dimensions.x / mRenderingHorizScaleFactor, dimensions.y / mRenderingVertScaleFactor), rotation, colour);
+		WzClippingRectF textRectInPixels(rendered->origin.x, rendered->origin.y, dimensions.x, dimensions.y);
+		iV_DrawImageTextClipped(*texture, rendered->textureSize, position, Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), Vector2f(dimensions.x / mRenderingHorizScaleFactor, dimensions.y / mRenderingVertScaleFactor), rotation, colour, textRectInPixels);
 	}
 	else
 	{
-		WzClippingRectF clippingRectInPixels(
-			0.f, 0.f,
-			(maxWidth > 0) ? ((float)maxWidth * mRenderingHorizScaleFactor) : dimensions.x,
-			(maxHeight > 0) ? ((float)maxHeight * mRenderingVertScaleFactor) : dimensions.y
-		);
-		iV_DrawImageTextClipped(*texture, dimensions, position, Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), Vector2f((maxWidth > 0) ? maxWidth : dimensions.x / mRenderingHorizScaleFactor, (maxHeight > 0) ? maxHeight : dimensions.y / mRenderingVertScaleFactor), rotation, colour, clippingRectInPixels);
+		// (clipped to the rendered text, so nothing next to it in the atlas gets drawn)
+		float clippedWidth = (maxWidth > 0) ? std::min<float>((float)maxWidth * mRenderingHorizScaleFactor, dimensions.x) : dimensions.x;
+		float clippedHeight = (maxHeight > 0) ? std::min<float>((float)maxHeight * mRenderingVertScaleFactor, dimensions.y) : dimensions.y;
+		WzClippingRectF clippingRectInPixels(rendered->origin.x, rendered->origin.y, clippedWidth, clippedHeight);
+		iV_DrawImageTextClipped(*texture, rendered->textureSize, position, Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), Vector2f(clippedWidth / mRenderingHorizScaleFactor, clippedHeight / mRenderingVertScaleFactor), rotation, colour, clippingRectInPixels);
 	}
 }
 
@@ -21,6 +21,7 @@
 #ifndef _INCLUDED_TEXTDRAW_
 #define _INCLUDED_TEXTDRAW_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,8 @@
 using nonstd::optional;
 using nonstd::nullopt;
 
+struct RenderedTextCacheEntry;
+
 enum iV_fonts
 {
 	font_regular,
@@ -82,12 +85,10 @@ private:
 	void updateCacheIfNecessary();
 private:
 	WzString mText;
-	gfx_api::texture* texture = nullptr;
+	std::shared_ptr<RenderedTextCacheEntry> rendered; // shared with other WzText of the same text and font
 	int mPtsAboveBase = 0;
 	int mPtsBelowBase = 0;
 	int mPtsLineSize = 0;
-	Vector2i offsets = Vector2i(0, 0);
-	Vector2i dimensions = Vector2i(0, 0);
 	float mRenderingHorizScaleFactor = 0.f;
 	float mRenderingVertScaleFactor = 0.f;
 	iV_fonts mFontID = font_count;
@@ -41,6 +41,7 @@
 #  pragma GCC diagnostic pop
 #endif
 
+#include <atomic>
 #include <ctime>
 #include <memory>
 
@@ -55,6 +56,8 @@ static const uint32_t currentReplayFormatVer = 3;
 static const uint32_t minReplayFormatVerSupported = 3;
 static const size_t DefaultReplayBufferSize = 32768;
 static const size_t MaxReplayBufferSize = 2 * 1024 * 1024;
+static const size_t ReplayReadBlockSize = 128 * 1024;
+static const int MaxReplayReadAheadBlocks = 16;
 
 typedef std::vector<uint8_t> SerializedNetMessagesBuffer;
 static moodycamel::BlockingReaderWriterQueue<SerializedNetMessagesBuffer> serializedBufferWriteQueue(256);
@@ -63,6 +66,14 @@ static SerializedNetMessagesBuffer latestWriteBuffer;
 static size_t minBufferSizeToQueue = DefaultReplayBufferSize;
 static WZ_THREAD *saveThread = nullptr;
 
+static moodycamel::BlockingReaderWriterQueue<SerializedNetMessagesBuffer> serializedBufferReadQueue(MaxReplayReadAheadBlocks + 1);
+static SerializedNetMessagesBuffer latestReadBuffer;
+static size_t latestReadBufferPos = 0;
+static bool replayReadReachedEnd = false;
+static WZ_SEMAPHORE *replayReadAheadSlots = nullptr;
+static std::atomic<bool> replayLoadThreadStopRequested(false);
+static WZ_THREAD *loadThread = nullptr;
+
 // This function is run in its own thread! Do not call any non-threadsafe functions!
 static int replaySaveThreadFunc(void *data)
 {
@@ -85,6 +96,71 @@ static int replaySaveThreadFunc(void *data)
 	return 0;
 }
 
+// This function is run in its own thread! Do not call any non-threadsafe functions!
+// Reads the net message section of the replay in large blocks, staying at most MaxReplayReadAheadBlocks ahead of the consumer
+static int replayLoadThreadFunc(void *data)
+{
+	PHYSFS_file *pLoadHandle = (PHYSFS_file *)data;
+	int result = (pLoadHandle != nullptr) ? 0 : 1;
+	while (pLoadHandle != nullptr)
+	{
+		wzSemaphoreWait(replayReadAheadSlots);
+		if (replayLoadThreadStopRequested.load(std::memory_order_acquire))
+		{
+			break;
+		}
+		SerializedNetMessagesBuffer item(ReplayReadBlockSize);
+		PHYSFS_sint64 bytesRead = WZ_PHYSFS_readBytes(pLoadHandle, item.data(), static_cast<PHYSFS_uint32>(item.size()));
+		if (bytesRead <= 0)
+		{
+			break;
+		}
+		item.resize(static_cast<size_t>(bytesRead));
+		serializedBufferReadQueue.enqueue(std::move(item));
+		if (static_cast<size_t>(bytesRead) < ReplayReadBlockSize)
+		{
+			// reached the end of the file
+			break;
+		}
+	}
+	// Push one empty chunk to signify "we're done!"
+	serializedBufferReadQueue.enqueue(SerializedNetMessagesBuffer());
+	return result;
+}
+
+// Make sure at least `len` unconsumed bytes are available in latestReadBuffer (starting at latestReadBufferPos)
+static bool replayLoadEnsureAvailable(size_t len)
+{
+	while (latestReadBuffer.size() - latestReadBufferPos < len)
+	{
+		if (replayReadReachedEnd)
+		{
+			return false;
+		}
+		SerializedNetMessagesBuffer item;
+		serializedBufferReadQueue.wait_dequeue(item);
+		if (item.empty())
+		{
+			replayReadReachedEnd = true;
+			return false;
+		}
+		wzSemaphorePost(replayReadAheadSlots);
+		if (latestReadBufferPos >= latestReadBuffer.size())
+		{
+			// common case: everything consumed, just take over the new block
+			latestReadBuffer = std::move(item);
+		}
+		else
+		{
+			// a message straddles the block boundary - keep the unconsumed tail and append the new block
+			latestReadBuffer.erase(latestReadBuffer.begin(), latestReadBuffer.begin() + latestReadBufferPos);
+			latestReadBuffer.insert(latestReadBuffer.end(), item.begin(), item.end());
+		}
+		latestReadBufferPos = 0;
+	}
+	return true;
+}
+
 static bool NETreplaySaveWritePreamble(const nlohmann::json& settings, ReplayOptionsHandler const &optionsHandler)
 {
 	if (!replaySaveHandle)
@@ -424,44 +500,52 @@ bool NETreplayLoadStart(std::string const &filename, ReplayOptionsHandler& optio
 		return onFail(parseError.c_str());
 	}
 
+	// Create a background thread and hand off all further reading from the file handle to it
+	ASSERT(loadThread == nullptr, "Failed to release prior thread");
+	latestReadBuffer.clear();
+	latestReadBufferPos = 0;
+	replayReadReachedEnd = false;
+	replayLoadThreadStopRequested.store(false, std::memory_order_release);
+	replayReadAheadSlots = wzSemaphoreCreate(MaxReplayReadAheadBlocks);
+	loadThread = wzThreadCreate(replayLoadThreadFunc, replayLoadHandle, "replayLoadThread");
+	wzThreadStart(loadThread);
+
 	debug(LOG_INFO, "Started reading replay file \"%s\".", filename.c_str());
 	return true;
 }
 
-bool NETreplayLoadNetMessage(std::unique_ptr<NetMessage> &message, uint8_t &player)
+bool NETreplayLoadNetMessage(optional<NetMessage> &message, uint8_t &player)
 {
 	if (!replayLoadHandle)
 	{
 		return false;
 	}
 
-	WZ_PHYSFS_readBytes(replayLoadHandle, &player, 1);
-
-	uint8_t type;
-	WZ_PHYSFS_readBytes(replayLoadHandle, &type, 1);
-
-	uint8_t b[2];
-	bool rd = WZ_PHYSFS_readBytes(replayLoadHandle, &b, 2);
-	if (!rd)
+	// Each entry is: | player (1 byte) | type (1 byte) | payload length (2 bytes) | payload |
+	const size_t entryHeaderLength = sizeof(uint8_t) + NetMessage::HEADER_LENGTH;
+	if (!replayLoadEnsureAvailable(entryHeaderLength))
 	{
 		return false;
 	}
 	uint16_t len = 0;
-	// Load payload length from uint16_t (network byte order) starting at the second byte of the data buffer.
-	wz_ntohs_load_unaligned(len, b);
+	// Load payload length from uint16_t (network byte order) starting at the third byte of the entry.
+	wz_ntohs_load_unaligned(len, &latestReadBuffer[latestReadBufferPos + 2]);
 
-	std::vector<uint8_t> replayData(len);
-	size_t messageRead = WZ_PHYSFS_readBytes(replayLoadHandle, replayData.data(), len);
-
-	if (messageRead != len)
+	size_t entryLength = entryHeaderLength + len;
+	if (!replayLoadEnsureAvailable(entryLength))
 	{
 		return false;
 	}
 
-	NetMessageBuilder msgBuilder(type, len);
-	msgBuilder.append(replayData.data(), len);
-
-	message = std::make_unique<NetMessage>(msgBuilder.build());
+	const uint8_t *pEntry = &latestReadBuffer[latestReadBufferPos];
+	player = pEntry[0];
+	// The message still gets its own (pool allocated) copy of the data, since it outlives the read-ahead block in the game queues.
+	message = NetMessage::tryFromRawData(pEntry + 1, entryLength - 1);
+	latestReadBufferPos += entryLength;
+	if (!message.has_value())
+	{
+		return false;
+	}
 
 	return (message->type() > GAME_MIN_TYPE && message->type() < GAME_MAX_TYPE) || message->type() == REPLAY_ENDED;
 }
@@ -473,6 +557,24 @@ bool NETreplayLoadStop()
 		return false;
 	}
 
+	// Stop the read-ahead thread (it may be waiting for a free slot) and discard anything it read
+	if (loadThread)
+	{
+		replayLoadThreadStopRequested.store(true, std::memory_order_release);
+		wzSemaphorePost(replayReadAheadSlots);
+		wzThreadJoin(loadThread);
+		loadThread = nullptr;
+	}
+	SerializedNetMessagesBuffer item;
+	while (serializedBufferReadQueue.try_dequeue(item)) { }
+	if (replayReadAheadSlots)
+	{
+		wzSemaphoreDestroy(replayReadAheadSlots);
+		replayReadAheadSlots = nullptr;
+	}
+	latestReadBuffer = SerializedNetMessagesBuffer();
+	latestReadBufferPos = 0;
+
 	if (!PHYSFS_close(replayLoadHandle))
 	{
 		debug(LOG_ERROR, "Could not close replay file: %s", WZ_PHYSFS_getLastError());
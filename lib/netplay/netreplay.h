@@ -30,7 +30,7 @@ bool NETreplaySaveStop(ReplayOptionsHandler const &optionsHandler);
 void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player);
 
 bool NETreplayLoadStart(std::string const &filename, ReplayOptionsHandler& optionsHandler, uint32_t& output_replayFormatVer);
-bool NETreplayLoadNetMessage(std::unique_ptr<NetMessage> &message, uint8_t &player);
+bool NETreplayLoadNetMessage(optional<NetMessage> &message, uint8_t &player);
 bool NETreplayLoadStop();
 
 #endif // _NETREPLAY_H
@@ -600,7 +600,7 @@ bool NETloadReplay(std::string const &filename, ReplayOptionsHandler& optionsHan
 	{
 		return false;
 	}
-	std::unique_ptr<NetMessage> newMessage;
+	optional<NetMessage> newMessage;
 	uint8_t player;
 	bool gotReplayEnded = false;
 	while (NETreplayLoadNetMessage(newMessage, player))
@@ -620,6 +620,7 @@ bool NETloadReplay(std::string const &filename, ReplayOptionsHandler& optionsHan
 	if (!gotReplayEnded && replayFormatVer >= 2)
 	{
 		debug(LOG_POPUP, _("Unable to load replay: The replay file is incomplete or corrupted."));
+		NETreplayLoadStop();
 		bIsReplay = true;
 		NETshutdownReplay();
 		return false;
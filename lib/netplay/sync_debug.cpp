@@ -100,7 +100,7 @@ struct SyncDebugValueChange : public SyncDebugEntry
 
 struct SyncDebugIntList : public SyncDebugEntry
 {
-	void set(uint32_t& crc, char const* f, char const* s, int const* ints, size_t num)
+	void set(uint32_t& crc, char const* f, char const* s, int const* ints, size_t num, uint32_t const* formatCrc = nullptr)
 	{
 		function = f;
 		string = s;
@@ -110,6 +110,11 @@ struct SyncDebugIntList : public SyncDebugEntry
 		{
 			valueBytes[n] = wz_htonl(ints[n]);
 		}
+		if (formatCrc != nullptr)
+		{
+			uint32_t formatBytes = wz_htonl(*formatCrc);
+			crc = wz::crc_update(crc, &formatBytes, 4);
+		}
 		crc = wz::crc_update(crc, valueBytes, 4 * numInts);
 	}
 	int snprint(char* buf, size_t bufSize, int const*& ints) const
@@ -212,15 +217,15 @@ struct SyncDebugLog
 		valueChanges.back().set(crc, f, vn, nv, i);
 		log.push_back('v');
 	}
-	void intList(char const* f, char const* s, int* begin, size_t num)
+	void intList(char const* f, char const* s, int const* begin, size_t num, uint32_t const* formatCrc = nullptr)
 	{
 		size_t offset = ints.size();
 		ints.resize(ints.size() + num);
-		int* buf = &ints[offset];
+		int* buf = ints.data() + offset;
 		std::copy(begin, begin + num, buf);
 
 		intLists.resize(intLists.size() + 1);
-		intLists.back().set(crc, f, s, buf, num);
+		intLists.back().set(crc, f, s, buf, num, formatCrc);
 		log.push_back('i');
 	}
 	int snprint(char* buf, size_t bufSize)
@@ -526,6 +531,17 @@ bool DesyncLogOutputter::PlayerDesyncLogOutput::LogOutputter::write(uint32_t tim
 
 // MARK: -
 
+SyncDebugCallSite::SyncDebugCallSite(const char* f)
+: function(f)
+{
+#ifdef WZ_CC_MSVC
+	while (*f != '\0') if (*f++ == ':')
+	{
+		function = f;    // Strip "Class::" from "Class::myFunction".
+	}
+#endif
+}
+
 void _syncDebug(const char* function, const char* str, ...)
 {
 #ifdef WZ_CC_MSVC
@@ -545,6 +561,19 @@ void _syncDebug(const char* function, const char* str, ...)
 	syncDebugLog[syncDebugNext].string(function, outputBuffer);
 }
 
+void _syncDebugFormatInts(SyncDebugCallSite& site, const char* str, const int* ints, size_t numInts)
+{
+	if (site.format != str)
+	{
+		// Use CRC of the text (not the addresses) of the strings, to avoid false positive desynchs between platforms.
+		site.format = str;
+		site.formatCrc = wz::crc_update(wz::crc_init(), site.function, strlen(site.function) + 1);
+		site.formatCrc = wz::crc_update(site.formatCrc, str, strlen(str) + 1);
+	}
+
+	syncDebugLog[syncDebugNext].intList(site.function, str, ints, numInts, &site.formatCrc);
+}
+
 void _syncDebugIntList(const char* function, const char* str, int* ints, size_t numInts)
 {
 #ifdef WZ_CC_MSVC
@@ -24,10 +24,43 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <type_traits>
+
+/// A syncDebug() call site.
+struct SyncDebugCallSite
+{
+	explicit SyncDebugCallSite(const char* function);
+
+	const char* function;             ///< Function name, without any "Class::" prefix.
+	const char* format = nullptr;     ///< Format string the formatCrc was calculated from.
+	uint32_t formatCrc = 0;           ///< CRC of the function name and format string, used instead of formatting the message.
+};
 
 /// Sync debugging. Only prints anything, if different players would print different things.
-#define syncDebug(...) do { _syncDebug(__FUNCTION__, __VA_ARGS__); } while(0)
+/// Calls with only (up to 32-bit) integer arguments are logged in binary form, and only formatted if the log is dumped.
+#define syncDebug(...) do { if (false) { _syncDebugCheckFormat(__VA_ARGS__); } static SyncDebugCallSite _syncDebugCallSite(__FUNCTION__); _syncDebugAtCallSite(_syncDebugCallSite, __VA_ARGS__); } while(0)
 void _syncDebug(const char* function, const char* str, ...) WZ_DECL_FORMAT(WZ_PRINTF_FORMAT, 2, 3);
+void _syncDebugFormatInts(SyncDebugCallSite& site, const char* str, const int* ints, size_t numInts);
+
+static inline void _syncDebugCheckFormat(const char* str, ...) WZ_DECL_FORMAT(WZ_PRINTF_FORMAT, 1, 2);
+static inline void _syncDebugCheckFormat(const char*, ...) {}  ///< Never called, only lets the compiler check syncDebug() format strings.
+
+template <typename T>
+using SyncDebugIsIntArg = std::integral_constant<bool, (std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= sizeof(int)>;
+
+template <typename... Args>
+inline void _syncDebugAtCallSite(SyncDebugCallSite& site, const char* str, Args... args)
+{
+	if constexpr ((SyncDebugIsIntArg<Args>::value && ...) && sizeof...(Args) <= 40)
+	{
+		int ints[sizeof...(Args) + 1] = {static_cast<int>(args)...};  // + 1, since arrays can't be empty.
+		_syncDebugFormatInts(site, str, ints, sizeof...(Args));
+	}
+	else
+	{
+		_syncDebug(site.function, str, args...);
+	}
+}
 
 /// Faster than syncDebug. Make sure that str is a format string that takes ints only.
 void _syncDebugIntList(const char* function, const char* str, int* ints, size_t numInts);
@@ -65,7 +65,7 @@ unsigned W_BUTTON::getState() const
 
 void W_BUTTON::setFlash(bool enable)
 {
-	dirty = true;
+	markDirty();
 	if (enable)
 	{
 		state |= WBUT_FLASH;
@@ -78,7 +78,7 @@ void W_BUTTON::setFlash(bool enable)
 
 void W_BUTTON::unlock()
 {
-	dirty = true;
+	markDirty();
 	state &= ~(WBUT_LOCK | WBUT_CLICKLOCK);
 }
 
@@ -87,8 +87,12 @@ void W_BUTTON::setState(unsigned newState)
 	ASSERT(!((newState & WBUT_LOCK) && (newState & WBUT_CLICKLOCK)), "Cannot have both WBUT_LOCK and WBUT_CLICKLOCK");
 
 	unsigned mask = WBUT_DISABLE | WBUT_LOCK | WBUT_CLICKLOCK;
+	unsigned oldState = state;
 	state = (state & ~mask) | (newState & mask);
-	dirty = true;
+	if (state != oldState)
+	{
+		markDirty();
+	}
 }
 
 WzString W_BUTTON::getString() const
@@ -99,7 +103,7 @@ WzString W_BUTTON::getString() const
 void W_BUTTON::setString(WzString string)
 {
 	pText = string;
-	dirty = true;
+	markDirty();
 }
 
 void W_BUTTON::setTip(std::string string)
@@ -146,7 +150,7 @@ void W_BUTTON::clicked(W_CONTEXT *, WIDGET_KEY key)
 	}
 	lastClickTime = realTime;
 
-	dirty = true;
+	markDirty();
 
 	/* Can't click a button if it is disabled or locked down */
 	if ((state & (WBUT_DISABLE | WBUT_LOCK)) == 0)
@@ -196,7 +200,7 @@ void W_BUTTON::released(W_CONTEXT *, WIDGET_KEY key)
 				lockedScreen->setReturn(shared_from_this());
 			}
 			state &= ~WBUT_DOWN;
-			dirty = true;
+			markDirty();
 		}
 	}
 
@@ -220,7 +224,7 @@ void W_BUTTON::highlight(W_CONTEXT *psContext)
 	if ((state & WBUT_HIGHLIGHT) == 0)
 	{
 		state |= WBUT_HIGHLIGHT;
-		dirty = true;
+		markDirty();
 	}
 	if (AudioCallback)
 	{
@@ -233,7 +237,7 @@ void W_BUTTON::highlight(W_CONTEXT *psContext)
 void W_BUTTON::highlightLost()
 {
 	state &= ~(WBUT_DOWN | WBUT_HIGHLIGHT);
-	dirty = true;
+	markDirty();
 
 	clickDownStart = nullopt;
 	clickDownKey = nullopt;
@@ -501,7 +505,7 @@ void W_BUTTON::ProgressBorder::resetStartingTime()
 void W_BUTTON::setImages(Images const &images_)
 {
 	images = images_;
-	dirty = true;
+	markDirty();
 	if (!images.normal.isNull())
 	{
 		setGeometry(x(), y(), images.normal.width(), images.normal.height());
@@ -510,7 +514,7 @@ void W_BUTTON::setImages(Images const &images_)
 
 void W_BUTTON::setImages(AtlasImage image, AtlasImage imageDown, AtlasImage imageHighlight, AtlasImage imageDisabled)
 {
-	dirty = true;
+	markDirty();
 	setImages(Images(image, imageDown, imageHighlight, imageDisabled));
 }
 
@@ -525,7 +529,7 @@ void MultipleChoiceButton::setChoice(unsigned newChoice)
 	{
 		return;
 	}
-	dirty = true;
+	markDirty();
 	choice = newChoice;
 	std::map<int, Images>::const_iterator image = imageSets.find(choice);
 	if (image != imageSets.end())
@@ -556,7 +560,7 @@ void MultipleChoiceButton::setTip(unsigned choiceValue, char const *stringUtf8)
 void MultipleChoiceButton::setImages(unsigned choiceValue, Images const &stateImages)
 {
 	imageSets[choiceValue] = stateImages;
-	dirty = true;
+	markDirty();
 	if (choice == choiceValue)
 	{
 		W_BUTTON::setImages(stateImages);
@@ -64,13 +64,7 @@ void ClipRectWidget::displayRecursive(const WidgetGraphicsContext &context)
 		.translatedBy(x() - offset.x, + y() - offset.y)
 		.clippedBy(WzRect(offset.x, offset.y, width(), height()));
 
-	for (auto child : children())
-	{
-		if (child->visible())
-		{
-			child->displayRecursive(childrenContext);
-		}
-	}
+	displayChildrenRecursive(childrenContext);
 }
 
 bool ClipRectWidget::isChildVisible(const std::shared_ptr<WIDGET>& child)
@@ -89,6 +83,7 @@ bool ClipRectWidget::setTopOffset(uint16_t value)
 		return false;
 	}
 	offset.y = value;
+	markDirty();
 	return true;
 }
 
@@ -104,6 +99,7 @@ bool ClipRectWidget::setLeftOffset(uint16_t value)
 		return false;
 	}
 	offset.x = value;
+	markDirty();
 	return true;
 }
 
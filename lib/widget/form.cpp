@@ -83,8 +83,12 @@ void W_CLICKFORM::setState(unsigned newState)
 	ASSERT(!((newState & WBUT_LOCK) && (newState & WBUT_CLICKLOCK)), "Cannot have both WBUT_LOCK and WBUT_CLICKLOCK");
 
 	unsigned mask = WBUT_DISABLE | WBUT_LOCK | WBUT_CLICKLOCK;
+	unsigned oldState = state;
 	state = (state & ~mask) | (newState & mask);
-	dirty = true;
+	if (state != oldState)
+	{
+		markDirty();
+	}
 }
 
 void W_CLICKFORM::setFlash(bool enable)
@@ -97,7 +101,7 @@ void W_CLICKFORM::setFlash(bool enable)
 	{
 		state &= ~WBUT_FLASH;
 	}
-	dirty = true;
+	markDirty();
 }
 
 void W_CLICKFORM::run(W_CONTEXT *psContext)
@@ -135,7 +139,7 @@ bool W_FORM::isUserMovable() const
 
 void W_FORM::clicked(W_CONTEXT *psContext, WIDGET_KEY key)
 {
-	dirty = true;
+	markDirty();
 	if (isUserMovable() && key == WKEY_PRIMARY)
 	{
 		if (formState == FormState::MINIMIZED && (psContext->mx <= minimizedGeometry().x() + minimizedLeftButtonWidth))
@@ -158,7 +162,7 @@ void W_FORM::released(W_CONTEXT *psContext, WIDGET_KEY)
 	}
 	if (!isUserMovable() || !dragStart.has_value()) { return; }
 	dragStart = nullopt;
-	dirty = true;
+	markDirty();
 }
 
 void W_FORM::run(W_CONTEXT *psContext)
@@ -203,7 +207,7 @@ void W_FORM::mouseDragged(WIDGET_KEY wkey, W_CONTEXT *psStartContext, W_CONTEXT
 	{
 		minimizedRect = WzRect(newPosition.x, newPosition.y, minimizedRect.width(), minimizedRect.height());
 	}
-	dirty = true;
+	markDirty();
 	dragStart = currentMousePos;
 }
 
@@ -223,7 +227,7 @@ void W_CLICKFORM::clicked(W_CONTEXT *psContext, WIDGET_KEY key)
 			state |= WBUT_DOWN;
 			clickDownStart = std::chrono::steady_clock::now();
 			clickDownKey = key;
-			dirty = true;
+			markDirty();
 
 			if (AudioCallback != nullptr)
 			{
@@ -246,7 +250,7 @@ void W_CLICKFORM::released(W_CONTEXT *, WIDGET_KEY key)
 				lockedScreen->setReturn(shared_from_this());
 			}
 			state &= ~WBUT_DOWN;
-			dirty = true;
+			markDirty();
 		}
 	}
 
@@ -270,7 +274,7 @@ void W_CLICKFORM::highlight(W_CONTEXT *psContext)
 /* Respond to the mouse moving off a form */
 void W_FORM::highlightLost()
 {
-	dirty = true;
+	markDirty();
 }
 
 void W_CLICKFORM::highlightLost()
@@ -280,7 +284,7 @@ void W_CLICKFORM::highlightLost()
 	state &= ~(WBUT_DOWN | WBUT_HIGHLIGHT);
 	clickDownStart = nullopt;
 	clickDownKey = nullopt;
-	dirty = true;
+	markDirty();
 }
 
 void W_FORM::display(int xOffset, int yOffset)
@@ -208,7 +208,7 @@ void W_LABEL::setString(WzString string)
 	displayCache.wzText.clear();
 	displayCache.wzText.push_back(WzCachedText(string, FontID, LABEL_DEFAULT_CACHE_EXPIRY));
 	maxLineWidth = -1; // delay calculating line width until it's requested
-	dirty = true;
+	markDirty();
 }
 
 void W_LABEL::setTip(std::string string)
@@ -220,7 +220,7 @@ void W_LABEL::setTextAlignment(WzTextAlignment align)
 {
 	style &= ~(WLAB_ALIGNLEFT | WLAB_ALIGNCENTRE | WLAB_ALIGNRIGHT);
 	style |= align;
-	dirty = true;
+	markDirty();
 }
 
 void W_LABEL::run(W_CONTEXT *)
@@ -215,7 +215,9 @@ ListWidget::ListWidget()
 	, spacing(4, 4)
 	, currentPage_(0)
 	, order(RightThenDown)
-{}
+{
+	setRetainedDisplay(true);  // Only the widgets on the current page are shown.
+}
 
 void ListWidget::widgetLost(WIDGET *widget)
 {
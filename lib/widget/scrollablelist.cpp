@@ -31,6 +31,7 @@ void ScrollableListWidget::initialize()
 {
 	attach(scrollBar = ScrollBarWidget::make());
 	attach(listView = std::make_shared<ClipRectWidget>());
+	listView->setRetainedDisplay(true);  // Only visit the rows which are scrolled into view.
 	scrollBar->show(false);
 	scrollbarWidth = SCROLLBAR_WIDTH;
 	backgroundColor.clear();
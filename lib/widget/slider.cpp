@@ -97,7 +97,7 @@ void W_SLIDER::run(W_CONTEXT *psContext)
 		{
 			lockedScreen->setReturn(shared_from_this());
 		}
-		dirty = true;
+		markDirty();
 	}
 }
 
@@ -105,7 +105,7 @@ void W_SLIDER::clicked(W_CONTEXT *psContext, WIDGET_KEY)
 {
 	if (isEnabled())
 	{
-		dirty = true;
+		markDirty();
 		state |= SLD_DRAG;
 		isHandlingDrag = true;
 		updateSliderFromMousePosition(psContext);
@@ -120,7 +120,7 @@ void W_SLIDER::released(W_CONTEXT *psContext, WIDGET_KEY)
 void W_SLIDER::highlight(W_CONTEXT *)
 {
 	state |= SLD_HILITE;
-	dirty = true;
+	markDirty();
 }
 
 
@@ -128,7 +128,7 @@ void W_SLIDER::highlight(W_CONTEXT *)
 void W_SLIDER::highlightLost()
 {
 	state &= ~SLD_HILITE;
-	dirty = true;
+	markDirty();
 }
 
 void W_SLIDER::setTip(std::string string)
@@ -143,6 +143,12 @@ public:
 	WidgetGraphicsContext clippedBy(WzRect const &newRect) const;
 
 	WidgetGraphicsContext setAllowChildDisplayRecursiveIfSelfClipped(bool val) const;
+
+	bool operator ==(WidgetGraphicsContext const &other) const;
+	bool operator !=(WidgetGraphicsContext const &other) const
+	{
+		return !(*this == other);
+	}
 };
 
 struct WidgetHelp
@@ -250,7 +256,12 @@ public:
 
 	void show(bool doShow = true)
 	{
-		style = (style & ~WIDG_HIDDEN) | (!doShow * WIDG_HIDDEN);
+		UDWORD newStyle = (style & ~WIDG_HIDDEN) | (!doShow * WIDG_HIDDEN);
+		if (newStyle != style)
+		{
+			style = newStyle;
+			markDirty();
+		}
 	}
 	void hide()
 	{
@@ -285,6 +296,7 @@ public:
 			}
 		}
 		childWidgets = {};
+		markDirty();
 	}
 	WzRect screenGeometry() const
 	{
@@ -437,8 +449,26 @@ public:
 		WidgetGraphicsContext context;
 		displayRecursive(context);
 	}
+
+	/// Mark this widget, and all its ancestors, as changed.
+	void markDirty();
+
+	/**
+	 * Opt in to retained display of the children.
+	 *
+	 * The set of visible children that intersect the clip rect is remembered, and reused each frame until this widget
+	 * is marked dirty (a child is attached, detached, moved, resized, shown or hidden, or any descendant changes state)
+	 * or it is displayed with a different context. Children which are entirely outside of the clip rect are then not
+	 * even visited, which makes long scrollable lists and tab pages cheap to display when nothing changes.
+	 * This only saves the traversal, the children that are displayed still draw themselves every frame.
+	 * Only use for widgets whose children are drawn within their own geometry.
+	 */
+	void setRetainedDisplay(bool enabled);
 	static void processMouseDragEvent(const W_CONTEXT &sContext, WIDGET_KEY wkey, WIDGET_KEYSTATE* pState, bool alsoTriggerReleased);
 
+protected:
+	void displayChildrenRecursive(WidgetGraphicsContext const &childrenContext);  ///< Display all visible children (or only the retained ones).
+
 private:
 	std::weak_ptr<WIDGET> parentWidget;
 	std::vector<std::shared_ptr<WIDGET>> childWidgets;
@@ -447,6 +477,10 @@ private:
 	bool					isTransparentToClicks = false;
 	bool					isTransparentToMouse = false;
 
+	bool                    retainedDisplay = false;
+	std::vector<WIDGET *>   retainedChildren;       ///< Children to display, only valid while !dirty.
+	WidgetGraphicsContext   retainedContext;        ///< Context retainedChildren was computed for.
+
 	WIDGET(WIDGET const &) = delete;
 	WIDGET &operator =(WIDGET const &) = delete;
 
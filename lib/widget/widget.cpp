@@ -536,7 +536,7 @@ void WIDGET::setGeometry(WzRect const &r)
 	}
 	dim = r;
 	geometryChanged();
-	dirty = true;
+	markDirty();
 }
 
 void WIDGET::setGeometryFromScreenRect(WzRect const &r)
@@ -611,6 +611,7 @@ void WIDGET::attach(const std::shared_ptr<WIDGET> &widget, ChildZPos zPos /*= Ch
 		childWidgets.insert(childWidgets.begin(), widget);
 		break;
 	}
+	markDirty();
 }
 
 void WIDGET::detach(const std::shared_ptr<WIDGET> &widget)
@@ -625,6 +626,7 @@ void WIDGET::detach(const std::shared_ptr<WIDGET> &widget)
 	{
 		childWidgets.erase(it);
 	}
+	markDirty();
 
 	widgetLost(widget.get());
 }
@@ -1612,18 +1614,76 @@ void WIDGET::displayRecursive(WidgetGraphicsContext const &context)
 	}
 
 	// Display the widgets on this widget.
+	displayChildrenRecursive(childrenContext);
+}
+
+void WIDGET::displayChildrenRecursive(WidgetGraphicsContext const &childrenContext)
+{
 	// NOTE: Draw them in the opposite order that clicks are processed, so behavior matches the visual.
 	// i.e. Since findMouseTargetRecursive handles processing children in decreasing z-order (i.e. "top-down")
 	//      we want to draw things in list order (bottom-up) so the "top-most" is drawn last
-	for (auto const &child: childWidgets)
+	if (!retainedDisplay)
+	{
+		for (auto const &child: childWidgets)
+		{
+			if (child->visible())
+			{
+				child->displayRecursive(childrenContext);
+			}
+		}
+		return;
+	}
+
+	if (dirty || childrenContext != retainedContext)
 	{
-		if (child->visible())
+		retainedChildren.clear();
+		for (auto const &child: childWidgets)
 		{
-			child->displayRecursive(childrenContext);
+			if (child->visible() && childrenContext.clipIntersects(child->geometry(), nullptr))
+			{
+				retainedChildren.push_back(child.get());
+			}
+		}
+		retainedContext = childrenContext;
+		dirty = false;  // Anything changed while displaying the children marks us dirty again.
+	}
+	size_t numDisplayed = 0;
+	for (; numDisplayed < retainedChildren.size() && !dirty; ++numDisplayed)
+	{
+		retainedChildren[numDisplayed]->displayRecursive(childrenContext);
+	}
+	if (numDisplayed < retainedChildren.size())
+	{
+		// A child changed the children while being displayed, so the remaining pointers may be stale. Display the
+		// rest from the live list this frame.
+		WIDGET *lastDisplayed = retainedChildren[numDisplayed - 1];
+		auto it = std::find_if(childWidgets.begin(), childWidgets.end(), [lastDisplayed](std::shared_ptr<WIDGET> const &child) { return child.get() == lastDisplayed; });
+		for (it = (it != childWidgets.end()) ? it + 1 : it; it != childWidgets.end(); ++it)
+		{
+			if ((*it)->visible() && childrenContext.clipIntersects((*it)->geometry(), nullptr))
+			{
+				(*it)->displayRecursive(childrenContext);
+			}
 		}
 	}
 }
 
+void WIDGET::markDirty()
+{
+	dirty = true;
+	for (auto ancestor = parent(); ancestor != nullptr; ancestor = ancestor->parent())
+	{
+		ancestor->dirty = true;
+	}
+}
+
+void WIDGET::setRetainedDisplay(bool enabled)
+{
+	retainedDisplay = enabled;
+	retainedChildren.clear();
+	markDirty();
+}
+
 /* Display the screen's widgets in their current state
  * (Call after calling widgRunScreen, this allows the input
  *  processing to be separated from the display of the widgets).
@@ -1795,6 +1855,14 @@ WidgetGraphicsContext WidgetGraphicsContext::clippedBy(WzRect const &newRect) co
 	return newContext;
 }
 
+bool WidgetGraphicsContext::operator ==(WidgetGraphicsContext const &other) const
+{
+	return offset == other.offset
+		&& clipped == other.clipped
+		&& (!clipped || clipRect == other.clipRect)
+		&& allowChildDisplayIfSelfClipped == other.allowChildDisplayIfSelfClipped;
+}
+
 WidgetGraphicsContext WidgetGraphicsContext::setAllowChildDisplayRecursiveIfSelfClipped(bool val) const
 {
 	WidgetGraphicsContext newContext(*this);
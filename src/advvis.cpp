@@ -28,6 +28,7 @@
 #include "advvis.h"
 #include "profiling.h"
 #include "map.h"
+#include "terrain.h"
 
 // ------------------------------------------------------------------------------------
 #define FADE_IN_TIME	(GAME_TICKS_PER_SEC/10)
@@ -69,6 +70,7 @@ void	avUpdateTiles()
 			{
 				maxLevel /= 2;
 			}
+			const UBYTE oldLevel = static_cast<UBYTE>(psTile->level);
 			if (psTile->level > maxLevel)
 			{
 				psTile->level = MAX(psTile->level - increment, maxLevel);
@@ -77,6 +79,11 @@ void	avUpdateTiles()
 			{
 				psTile->level = MIN(psTile->level + increment, maxLevel);
 			}
+			if (static_cast<UBYTE>(psTile->level) != oldLevel)
+			{
+				const int x = i % mapWidth, y = i / mapWidth;
+				markLightmapDirty(x, y, x, y);
+			}
 		}
 	}
 }
@@ -125,5 +132,6 @@ void	preProcessVisibility()
 			}
 		}
 	}
+	dirtyAllLightmap();
 }
 // ------------------------------------------------------------------------------------
@@ -36,6 +36,7 @@
 #include "profiling.h"
 #include "lib/gamelib/gtime.h"
 #include <cmath>
+#include <vector>
 
 #ifndef GLM_ENABLE_EXPERIMENTAL
 	#define GLM_ENABLE_EXPERIMENTAL
@@ -59,128 +60,170 @@ enum AP_TYPE
 	AP_SNOW
 };
 
-enum AP_STATUS
-{
-	APS_INACTIVE,
-	APS_ACTIVE
-};
+#define SNOW_SIZE				80
+#define RAIN_SIZE				50
+#define ATMOS_INITIAL_PARTICLES	4096
 
-static ATPART	*asAtmosParts = nullptr;
-static UDWORD	freeParticle = 0;
-static WT_CLASS	weather = WT_NONE;
+/* Same near limit as pie_RotateProjectWithPerspective uses for points behind the camera */
+static const float ATMOS_MIN_CLIP_W = 256.f / (3 * 330);
 
-/* Setup all the particles */
-void atmosInitSystem()
+/*	The live particles, packed at the front of each array. Dead particles are swapped with the last one, so the
+	update and draw loops only touch live particles, and the movement, wrapping and culling passes are simple
+	loops over floats which the compiler can vectorise. */
+struct ATMOS_PARTICLES
 {
-	if (!asAtmosParts && weather != WT_NONE)
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> velX, velY, velZ;
+	std::vector<UBYTE> type;
+
+	size_t size() const
+	{
+		return type.size();
+	}
+
+	void reserve(size_t count)
 	{
-		// calloc sets all to APS_INACTIVE initially
-		asAtmosParts = (ATPART *)calloc(MAX_ATMOS_PARTICLES, sizeof(*asAtmosParts));
-		if (!asAtmosParts)
+		for (auto *v : {&posX, &posY, &posZ, &velX, &velY, &velZ})
 		{
-			debug(LOG_ERROR, "Failed to initialize atmos system - memory allocation failed");
+			v->reserve(count);
 		}
+		type.reserve(count);
 	}
-	/* Start at the beginning */
-	freeParticle = 0;
-}
 
-/*	Makes a particle wrap around - if it goes off the grid, then it returns
-	on the other side - provided it's still on world... Which it should be */
-static void testParticleWrap(ATPART *psPart)
-{
-	/* Gone off left side */
-	if (psPart->position.x < playerPos.p.x - world_coord(visibleTiles.x) / 2)
+	void add(const Vector3f &pos, const Vector3f &vel, AP_TYPE particleType)
 	{
-		psPart->position.x += world_coord(visibleTiles.x);
+		posX.push_back(pos.x);
+		posY.push_back(pos.y);
+		posZ.push_back(pos.z);
+		velX.push_back(vel.x);
+		velY.push_back(vel.y);
+		velZ.push_back(vel.z);
+		type.push_back(static_cast<UBYTE>(particleType));
 	}
 
-	/* Gone off right side */
-	else if (psPart->position.x > (playerPos.p.x + world_coord(visibleTiles.x) / 2))
+	void remove(size_t i)
 	{
-		psPart->position.x -= world_coord(visibleTiles.x);
+		for (auto *v : {&posX, &posY, &posZ, &velX, &velY, &velZ})
+		{
+			(*v)[i] = v->back();
+			v->pop_back();
+		}
+		type[i] = type.back();
+		type.pop_back();
 	}
 
-	/* Gone off top */
-	if (psPart->position.z < playerPos.p.z - world_coord(visibleTiles.y) / 2)
+	void release()
 	{
-		psPart->position.z += world_coord(visibleTiles.y);
+		for (auto *v : {&posX, &posY, &posZ, &velX, &velY, &velZ})
+		{
+			std::vector<float>().swap(*v);
+		}
+		std::vector<UBYTE>().swap(type);
 	}
+};
 
-	/* Gone off bottom */
-	else if (psPart->position.z > (playerPos.p.z + world_coord(visibleTiles.y) / 2))
+static ATMOS_PARTICLES	atmosParts;
+static WT_CLASS	weather = WT_NONE;
+
+/* Setup all the particles */
+void atmosInitSystem()
+{
+	if (weather != WT_NONE)
 	{
-		psPart->position.z -= world_coord(visibleTiles.y);
+		atmosParts.reserve(ATMOS_INITIAL_PARTICLES);
 	}
 }
 
-/* Moves one of the particles */
-static void processParticle(ATPART *psPart)
+/*	Moves the particles, and makes them wrap around - if one goes off the grid, then it returns
+	on the other side - provided it's still on world... Which it should be */
+static void moveParticles()
 {
-	SDWORD	groundHeight;
-	Vector3i pos;
-	UDWORD	x, y;
-	MAPTILE	*psTile;
+	const size_t count = atmosParts.size();
+	const float timeFraction = graphicsTimeAdjustedIncrement(1.f);
+	const float minX = static_cast<float>(playerPos.p.x - world_coord(visibleTiles.x) / 2);
+	const float maxX = static_cast<float>(playerPos.p.x + world_coord(visibleTiles.x) / 2);
+	const float minZ = static_cast<float>(playerPos.p.z - world_coord(visibleTiles.y) / 2);
+	const float maxZ = static_cast<float>(playerPos.p.z + world_coord(visibleTiles.y) / 2);
+	const float wrapX = static_cast<float>(world_coord(visibleTiles.x));
+	const float wrapZ = static_cast<float>(world_coord(visibleTiles.y));
+
+	float *posX = atmosParts.posX.data();
+	float *posY = atmosParts.posY.data();
+	float *posZ = atmosParts.posZ.data();
+	const float *velX = atmosParts.velX.data();
+	const float *velY = atmosParts.velY.data();
+	const float *velZ = atmosParts.velZ.data();
+
+	/* Move the particles - frame rate controlled */
+	for (size_t i = 0; i < count; ++i)
+	{
+		posX[i] += velX[i] * timeFraction;
+		posY[i] += velY[i] * timeFraction;
+		posZ[i] += velZ[i] * timeFraction;
+	}
 
-	/* Only move if the game isn't paused */
-	if (!gamePaused())
+	/* Wrap them around if they've gone off grid... */
+	for (size_t i = 0; i < count; ++i)
 	{
-		/* Move the particle - frame rate controlled */
-		psPart->position.x += graphicsTimeAdjustedIncrement(psPart->velocity.x);
-		psPart->position.y += graphicsTimeAdjustedIncrement(psPart->velocity.y);
-		psPart->position.z += graphicsTimeAdjustedIncrement(psPart->velocity.z);
+		posX[i] += (posX[i] < minX) ? wrapX : ((posX[i] > maxX) ? -wrapX : 0.f);
+		posZ[i] += (posZ[i] < minZ) ? wrapZ : ((posZ[i] > maxZ) ? -wrapZ : 0.f);
+	}
+}
+
+/* Kills the particles that left the world or hit the ground, and lets the snow drift */
+static void processParticles()
+{
+	const float maxX = static_cast<float>((mapWidth - 1) * TILE_UNITS);
+	const float maxZ = static_cast<float>((mapHeight - 1) * TILE_UNITS);
 
-		/* Wrap it around if it's gone off grid... */
-		testParticleWrap(psPart);
+	// Go backwards, so the particle swapped into a removed one's place has already been processed
+	for (size_t i = atmosParts.size(); i-- > 0;)
+	{
+		const float x = atmosParts.posX[i];
+		const float y = atmosParts.posY[i];
+		const float z = atmosParts.posZ[i];
 
 		/* If it's gone off the WORLD... */
-		if (psPart->position.x < 0 || psPart->position.z < 0 ||
-		    psPart->position.x > ((mapWidth - 1)*TILE_UNITS) ||
-		    psPart->position.z > ((mapHeight - 1)*TILE_UNITS))
+		if (x < 0 || z < 0 || x > maxX || z > maxZ)
 		{
 			/* The kill it */
-			psPart->status = APS_INACTIVE;
-			return;
+			atmosParts.remove(i);
+			continue;
 		}
 
 		/* What height is the ground under it? Only do if low enough...*/
-		if (psPart->position.y < TILE_MAX_HEIGHT)
+		if (y < TILE_MAX_HEIGHT)
 		{
 			/* Get ground height */
-			groundHeight = map_Height(static_cast<int>(psPart->position.x), static_cast<int>(psPart->position.z));
+			const SDWORD groundHeight = map_Height(static_cast<int>(x), static_cast<int>(z));
 
 			/* Are we below ground? */
-			if ((int)psPart->position.y < groundHeight
-			    || psPart->position.y < 0.f)
+			if ((int)y < groundHeight || y < 0.f)
 			{
-				/* Kill it and return */
-				psPart->status = APS_INACTIVE;
-				if (psPart->type == AP_RAIN)
+				if (atmosParts.type[i] == AP_RAIN)
 				{
-					x = map_coord(static_cast<int32_t>(psPart->position.x));
-					y = map_coord(static_cast<int32_t>(psPart->position.z));
-					psTile = mapTile(x, y);
+					MAPTILE *psTile = mapTile(map_coord(static_cast<int32_t>(x)), map_coord(static_cast<int32_t>(z)));
 					if (terrainType(psTile) == TER_WATER && TEST_TILE_VISIBLE_TO_SELECTEDPLAYER(psTile)) // display-only check for adding effect
 					{
-						pos.x = static_cast<int>(psPart->position.x);
-						pos.z = static_cast<int>(psPart->position.z);
-						pos.y = groundHeight;
+						Vector3i pos(static_cast<int>(x), groundHeight, static_cast<int>(z));
 						effectSetSize(60);
 						addEffect(&pos, EFFECT_EXPLOSION, EXPLOSION_TYPE_SPECIFIED, true, getDisplayImdFromIndex(MI_SPLASH), 0);
 					}
 				}
-				return;
+				/* Kill it */
+				atmosParts.remove(i);
+				continue;
 			}
 		}
-		if (psPart->type == AP_SNOW)
+		if (atmosParts.type[i] == AP_SNOW)
 		{
 			if (rand() % 30 == 1)
 			{
-				psPart->velocity.z = (float)SNOW_SPEED_DRIFT;
+				atmosParts.velZ[i] = (float)SNOW_SPEED_DRIFT;
 			}
 			if (rand() % 30 == 1)
 			{
-				psPart->velocity.x = (float)SNOW_SPEED_DRIFT;
+				atmosParts.velX[i] = (float)SNOW_SPEED_DRIFT;
 			}
 		}
 	}
@@ -189,63 +232,21 @@ static void processParticle(ATPART *psPart)
 /* Adds a particle to the system if it can */
 static void atmosAddParticle(const Vector3f &pos, AP_TYPE type)
 {
-	UDWORD	activeCount;
-	UDWORD	i;
-
-	for (i = freeParticle, activeCount = 0; asAtmosParts[i].status == APS_ACTIVE && activeCount < MAX_ATMOS_PARTICLES; i++)
-	{
-		activeCount++;
-		/* Check for wrap around */
-		if (i >= (MAX_ATMOS_PARTICLES - 1))
-		{
-			/* Go back to the first one */
-			i = 0;
-		}
-	}
-
 	/* Check the list isn't just full of essential effects */
-	if (activeCount >= MAX_ATMOS_PARTICLES - 1)
+	if (atmosParts.size() >= MAX_ATMOS_PARTICLES - 1)
 	{
 		/* All of the particles active!?!? */
 		return;
 	}
-	else
-	{
-		freeParticle = i;
-	}
-
-	/* Record it's type */
-	asAtmosParts[freeParticle].type = (UBYTE)type;
-
-	/* Make it active */
-	asAtmosParts[freeParticle].status = APS_ACTIVE;
-
-	/* Setup the imd */
-	switch (type)
-	{
-	case AP_SNOW:
-		asAtmosParts[freeParticle].imd = getImdFromIndex(MI_SNOW);
-		asAtmosParts[freeParticle].size = 80;
-		break;
-	case AP_RAIN:
-		asAtmosParts[freeParticle].imd = getImdFromIndex(MI_RAIN);
-		asAtmosParts[freeParticle].size = 50;
-		break;
-	default:
-		break;
-	}
-
-	/* Setup position */
-	asAtmosParts[freeParticle].position = pos;
 
 	/* Setup its velocity */
 	if (type == AP_RAIN)
 	{
-		asAtmosParts[freeParticle].velocity = Vector3f(RAIN_SPEED_DRIFT, RAIN_SPEED_FALL, RAIN_SPEED_DRIFT);
+		atmosParts.add(pos, Vector3f(RAIN_SPEED_DRIFT, RAIN_SPEED_FALL, RAIN_SPEED_DRIFT), type);
 	}
 	else
 	{
-		asAtmosParts[freeParticle].velocity = Vector3f(SNOW_SPEED_DRIFT, SNOW_SPEED_FALL, SNOW_SPEED_DRIFT);
+		atmosParts.add(pos, Vector3f(SNOW_SPEED_DRIFT, SNOW_SPEED_FALL, SNOW_SPEED_DRIFT), type);
 	}
 }
 
@@ -257,22 +258,11 @@ void atmosUpdateSystem()
 	UDWORD	numberToAdd;
 	Vector3f pos;
 
-	if (!asAtmosParts)
-	{
-		return;
-	}
-
 	// we don't want to do any of this while paused.
 	if (!gamePaused() && weather != WT_NONE)
 	{
-		for (i = 0; i < MAX_ATMOS_PARTICLES; i++)
-		{
-			/* See if it's active */
-			if (asAtmosParts[i].status == APS_ACTIVE)
-			{
-				processParticle(&asAtmosParts[i]);
-			}
-		}
+		moveParticles();
+		processParticles();
 
 		// The original code added a fixed number of particles per tick. To take into account game speed
 		// we have to accumulate a fractional number of particles to add them at a slower or faster rate.
@@ -336,36 +326,48 @@ static inline void renderParticleInternal(ATPART *psPart, const glm::mat4 &viewM
 void atmosDrawParticles(const glm::mat4 &viewMatrix, const glm::mat4 &perspectiveViewMatrix)
 {
 	WZ_PROFILE_SCOPE(atmosDrawParticles);
-	UDWORD	i;
 
-	if (weather == WT_NONE || !asAtmosParts)
+	if (weather == WT_NONE || atmosParts.size() == 0)
 	{
 		return;
 	}
 
-	const glm::mat4 rotateMatrix = glm::rotate(UNDEG(-playerPos.r.y), glm::vec3(0.f, 1.f, 0.f)) *
-		glm::rotate(UNDEG(-playerPos.r.x), glm::vec3(0.f, 1.f, 0.f));
-	glm::mat4 rotateScaleMatrix = rotateMatrix;
-	UDWORD last_particle_size = 0;
+	const size_t count = atmosParts.size();
+	const float *posX = atmosParts.posX.data();
+	const float *posY = atmosParts.posY.data();
+	const float *posZ = atmosParts.posZ.data();
+
+	/* Is it visible on the screen? Find out for all of them in one go */
+	static std::vector<UBYTE> visible;
+	visible.resize(count);
+	const glm::mat4 &m = perspectiveViewMatrix;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float clipX = m[0][0] * posX[i] + m[1][0] * posY[i] - m[2][0] * posZ[i] + m[3][0];
+		const float clipY = m[0][1] * posX[i] + m[1][1] * posY[i] - m[2][1] * posZ[i] + m[3][1];
+		const float clipW = m[0][3] * posX[i] + m[1][3] * posY[i] - m[2][3] * posZ[i] + m[3][3];
+		visible[i] = clipW >= ATMOS_MIN_CLIP_W && clipX >= -clipW && clipX < clipW && clipY > -clipW && clipY <= clipW;
+	}
 
-	/* Traverse the list */
-	for (i = 0; i < MAX_ATMOS_PARTICLES; i++)
+	/* Gather the visible ones by type, each type is then drawn as a single batch */
+	static std::vector<glm::vec3> rainPositions, snowPositions;
+	rainPositions.clear();
+	snowPositions.clear();
+	for (size_t i = 0; i < count; ++i)
 	{
-		/* Don't bother unless it's active */
-		if (asAtmosParts[i].status == APS_ACTIVE)
+		if (visible[i])
 		{
-			/* Is it visible on the screen? */
-			if (clipXYZ(static_cast<int>(asAtmosParts[i].position.x), static_cast<int>(asAtmosParts[i].position.z), static_cast<int>(asAtmosParts[i].position.y), perspectiveViewMatrix))
-			{
-				if (last_particle_size != asAtmosParts[i].size)
-				{
-					rotateScaleMatrix = rotateMatrix * glm::scale(glm::vec3(asAtmosParts[i].size / 100.f));
-					last_particle_size = asAtmosParts[i].size;
-				}
-				renderParticleInternal(&asAtmosParts[i], viewMatrix, rotateScaleMatrix);
-			}
+			auto &positions = (atmosParts.type[i] == AP_RAIN) ? rainPositions : snowPositions;
+			positions.emplace_back(posX[i], posY[i], -posZ[i]);
 		}
 	}
+
+	/* Make it face camera */
+	const glm::mat4 rotateMatrix = glm::rotate(UNDEG(-playerPos.r.y), glm::vec3(0.f, 1.f, 0.f)) *
+		glm::rotate(UNDEG(-playerPos.r.x), glm::vec3(0.f, 1.f, 0.f));
+	/* Scale it, and draw it... */
+	pie_Draw3DShapeInstances(getImdFromIndex(MI_RAIN)->displayModel(), WZCOL_WHITE, 0, rotateMatrix * glm::scale(glm::vec3(RAIN_SIZE / 100.f)), rainPositions.data(), rainPositions.size());
+	pie_Draw3DShapeInstances(getImdFromIndex(MI_SNOW)->displayModel(), WZCOL_WHITE, 0, rotateMatrix * glm::scale(glm::vec3(SNOW_SIZE / 100.f)), snowPositions.data(), snowPositions.size());
 }
 
 void renderParticle(ATPART *psPart, const glm::mat4 &viewMatrix)
@@ -383,10 +385,9 @@ void atmosSetWeatherType(WT_CLASS type)
 		weather = type;
 		atmosInitSystem();
 	}
-	if (type == WT_NONE && asAtmosParts)
+	if (type == WT_NONE)
 	{
-		free(asAtmosParts);
-		asAtmosParts = nullptr;
+		atmosParts.release();
 	}
 }
 
@@ -36,6 +36,7 @@
 #include "miscimd.h"
 #include "profiling.h"
 #include "droid.h"
+#include "scenejobs.h"
 
 #include <algorithm>
 
@@ -57,6 +58,7 @@ struct BUCKET_TAG
 	RENDER_TYPE     objectType; //type of object held
 	void           *pObject;    //pointer to the object
 	int32_t         actualZ;
+	bool            clipped;
 };
 
 static std::vector<BUCKET_TAG> bucketArray;
@@ -308,22 +310,18 @@ static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void *pObject, const glm:
 	return z;
 }
 
-/* add an object to the current render list */
-void bucketAddTypeToList(RENDER_TYPE objectType, void *pObject, const glm::mat4 &perspectiveViewMatrix)
+/* work out the sort key of an object, or mark it clipped */
+static void bucketCalculateTag(BUCKET_TAG &tag, const glm::mat4 &perspectiveViewMatrix)
 {
 	const iIMDShape *pie;
-	BUCKET_TAG	newTag;
+	RENDER_TYPE objectType = tag.objectType;
+	void *pObject = tag.pObject;
 	int32_t		z = bucketCalculateZ(objectType, pObject, perspectiveViewMatrix);
 
-	if (z < 0)
+	tag.clipped = (z < 0);
+	if (tag.clipped)
 	{
 		/* Object will not be render - has been clipped! */
-		if (objectType == RENDER_DROID || objectType == RENDER_STRUCTURE)
-		{
-			/* Won't draw selection boxes */
-			((BASE_OBJECT *)pObject)->sDisplay.frameNumber = 0;
-		}
-
 		return;
 	}
 
@@ -374,10 +372,19 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void *pObject, const glm::mat4
 		break;
 	}
 
-	//put the object data into the tag
+	tag.actualZ = z;
+}
+
+/* add an object to the current render list */
+void bucketAddTypeToList(RENDER_TYPE objectType, void *pObject, const glm::mat4 &perspectiveViewMatrix)
+{
+	BUCKET_TAG	newTag;
+
+	//put the object data into the tag, the sort key is calculated when the list is rendered
 	newTag.objectType = objectType;
 	newTag.pObject = pObject;
-	newTag.actualZ = z;
+	newTag.actualZ = 0;
+	newTag.clipped = false;
 
 	//add tag to bucketArray
 	bucketArray.push_back(newTag);
@@ -387,6 +394,22 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void *pObject, const glm::mat4
 void bucketRenderCurrentList(const glm::mat4 &viewMatrix, const glm::mat4 &perspectiveViewMatrix)
 {
 	WZ_PROFILE_SCOPE(bucketRenderCurrentList);
+	// Only reads the objects, so cull them on the scene threads, then drop the clipped ones in the original order
+	sceneParallelFor(bucketArray.size(), 128, [&perspectiveViewMatrix](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			bucketCalculateTag(bucketArray[i], perspectiveViewMatrix);
+		}
+	});
+	for (const BUCKET_TAG &tag : bucketArray)
+	{
+		if (tag.clipped && (tag.objectType == RENDER_DROID || tag.objectType == RENDER_STRUCTURE))
+		{
+			/* Won't draw selection boxes */
+			((BASE_OBJECT *)tag.pObject)->sDisplay.frameNumber = 0;
+		}
+	}
+	bucketArray.erase(std::remove_if(bucketArray.begin(), bucketArray.end(), [](const BUCKET_TAG &tag) { return tag.clipped; }), bucketArray.end());
 	std::sort(bucketArray.begin(), bucketArray.end());
 
 	for (auto thisTag = bucketArray.cbegin(); thisTag != bucketArray.cend(); ++thisTag)
@@ -87,6 +87,8 @@ static bool wz_autogame = false;
 static std::string wz_saveandquit;
 static std::string wz_test;
 static bool wz_cli_headless = false;
+static bool wz_replay_crunch = false;
+static bool wz_precompress_textures = false;
 static bool wz_streamer_spectator_mode = false;
 static bool wz_lobby_slashcommands = false;
 static int wz_min_autostart_players = -1;
@@ -338,6 +340,8 @@ typedef enum
 	CLI_CONTINUE,
 	CLI_AUTOHOST,
 	CLI_AUTOHEADLESS,
+	CLI_REPLAYCRUNCH,
+	CLI_PRECOMPRESSTEXTURES,
 #if defined(WZ_OS_WIN)
 	CLI_WIN_ENABLE_CONSOLE,
 #endif
@@ -428,6 +432,8 @@ static const struct poptOption *getOptionsTable()
 		},
 		{ "autogame", POPT_ARG_NONE, CLI_AUTOGAME,   N_("Run games automatically for testing"), nullptr },
 		{ "headless", POPT_ARG_NONE, CLI_AUTOHEADLESS,   N_("Headless mode (only supported when also specifying --autogame, --autohost, --skirmish)"), nullptr },
+		{ "replay-crunch", POPT_ARG_NONE, CLI_REPLAYCRUNCH,   N_("Simulate a replay as fast as possible and quit when it ends (implies --headless, use with --loadreplay)"), nullptr },
+		{ "precompress-textures", POPT_ARG_NONE, CLI_PRECOMPRESSTEXTURES,   N_("Fill the compressed texture cache and quit"), nullptr },
 		{ "saveandquit", POPT_ARG_STRING, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name") },
 		{ "skirmish", POPT_ARG_STRING, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test") },
 		{ "continue", POPT_ARG_NONE, CLI_CONTINUE,   N_("Continue the last saved game"), nullptr },
@@ -1076,6 +1082,16 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			wz_test = token;
 			break;
 
+		case CLI_REPLAYCRUNCH:
+			wz_replay_crunch = true;
+			wz_cli_headless = true;
+			setHeadlessGameMode(wz_cli_headless);
+			break;
+
+		case CLI_PRECOMPRESSTEXTURES:
+			wz_precompress_textures = true;
+			break;
+
 		case CLI_AUTOHEADLESS:
 			wz_cli_headless = true;
 			setHeadlessGameMode(true);
@@ -1376,6 +1392,16 @@ bool autogame_enabled()
 	return wz_autogame;
 }
 
+bool replay_crunch_enabled()
+{
+	return wz_replay_crunch;
+}
+
+bool precompress_textures_enabled()
+{
+	return wz_precompress_textures;
+}
+
 const std::string &saveandquit_enabled()
 {
 	return wz_saveandquit;
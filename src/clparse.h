@@ -36,6 +36,8 @@ ParseCLIEarlyResult ParseCommandLineEarly(int argc, const char * const *argv);
 bool ParseCommandLineDebugFlags(int argc, const char * const *argv);
 
 bool autogame_enabled();
+bool replay_crunch_enabled();
+bool precompress_textures_enabled();
 const std::string &saveandquit_enabled();
 const std::string &wz_skirmish_test();
 bool streamer_spectator_mode();
@@ -69,6 +69,7 @@
 #include "intdisplay.h"
 #include "radar.h"
 #include "display3d.h"
+#include "scenejobs.h"
 #include "lighting.h"
 #include "console.h"
 #include "projectile.h"
@@ -174,6 +175,8 @@ static float skybox_scale = 10000.0f;
 
 //
 static bool bDrawTerrainShadows = true;
+static ShadowCascadeCache shadowCascadeCache;
+static uint64_t shadowCascadeCacheDepthPassGeneration = 0; ///< pie_DepthPassGeneration() the cached cascades were rendered into
 
 /// When to display HP bars
 UWORD barMode;
@@ -1383,6 +1386,7 @@ static void drawTiles(iView *player, LightingData& lightData, LightMap& lightmap
 	const glm::mat4 tileCalcPerspectiveViewMatrix = perspectiveMatrix * baseViewMatrix;
 	{
 		WZ_PROFILE_SCOPE(init_lightmap);
+		markLightmapDirty(playerXTile - visibleTiles.x / 2, playerZTile - visibleTiles.y / 2, playerXTile + visibleTiles.x / 2, playerZTile + visibleTiles.y / 2);
 		for (int i = -visibleTiles.y / 2, idx = 0; i <= visibleTiles.y / 2; i++, ++idx)
 		{
 			/* Go through the x's */
@@ -1501,17 +1505,34 @@ static void drawTiles(iView *player, LightingData& lightData, LightMap& lightmap
 	if (currShadowMode == ShadowMode::Shadow_Mapping)
 	{
 		WZ_PROFILE_SCOPE(ShadowMapping);
+		if (shadowCascadeCacheDepthPassGeneration != pie_DepthPassGeneration())
+		{
+			// The depth pass images were recreated (resolution or cascade count changed), so nothing cached is left in them
+			shadowCascadeCache.clear();
+			shadowCascadeCacheDepthPassGeneration = pie_DepthPassGeneration();
+		}
+		const uint64_t terrainSignature = (bDrawTerrainShadows) ? getTerrainGeometryGeneration() * 0x9e3779b97f4a7c15ULL + 1 : 0;
 		for (size_t i = 0; i < numShadowCascades; ++i)
 		{
+			// The shadow map keeps its contents, so skip cascades where nothing that casts a shadow moved
+			const glm::mat4 lightViewProjection = shadowCascades[i].projectionMatrix * shadowCascades[i].viewMatrix;
+			if (!shadowCascadeCache.needsUpdate(i, shadowCascades[i], pie_ShadowCastersSignature(lightViewProjection) + terrainSignature))
+			{
+				continue;
+			}
 			gfx_api::context::get().beginDepthPass(i);
 			if (bDrawTerrainShadows)
 			{
-				drawTerrainDepthOnly(shadowCascades[i].projectionMatrix * shadowCascades[i].viewMatrix);
+				drawTerrainDepthOnly(lightViewProjection);
 			}
 			pie_DrawAllMeshes(currentGameFrame, shadowCascades[i].projectionMatrix, shadowCascades[i].viewMatrix, cameraPos, shadowCascadesInfo, true);
 			gfx_api::context::get().endCurrentDepthPass();
 		}
 	}
+	else
+	{
+		shadowCascadeCache.clear();
+	}
 	// start main render pass
 
 
@@ -2011,6 +2032,31 @@ void	renderProjectile(PROJECTILE *psCurr, const glm::mat4 &viewMatrix, const glm
 	}
 }
 
+/// Objects of the current display pass, and whether they survived culling
+static std::vector<BASE_OBJECT *> sceneObjects;
+static std::vector<uint8_t> sceneObjectVisible;
+
+/// Cull sceneObjects on the scene threads (cull may only read), then render the visible ones in their original order
+template <typename Cull, typename Render>
+static void cullAndRenderSceneObjects(Cull cull, Render render)
+{
+	sceneObjectVisible.resize(sceneObjects.size());
+	sceneParallelFor(sceneObjects.size(), 256, [&cull](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			sceneObjectVisible[i] = cull(sceneObjects[i], i);
+		}
+	});
+	for (size_t i = 0; i < sceneObjects.size(); ++i)
+	{
+		if (sceneObjectVisible[i])
+		{
+			render(sceneObjects[i]);
+		}
+	}
+	sceneObjects.clear();
+}
+
 /// Draw the buildings
 static void displayStaticObjects(const glm::mat4 &viewMatrix, const glm::mat4 &perspectiveViewMatrix)
 {
@@ -2022,45 +2068,23 @@ static void displayStaticObjects(const glm::mat4 &viewMatrix, const glm::mat4 &p
 	for (unsigned aPlayer = 0; aPlayer < MAX_PLAYERS; ++aPlayer)
 	{
 		/* Now go all buildings for that player */
-		for (BASE_OBJECT* obj : apsStructLists[aPlayer])
-		{
-			/* Worth rendering the structure? */
-			if (obj->type != OBJ_STRUCTURE || (obj->died != 0 && obj->died < graphicsTime)
-				|| !quickClipXYToMaximumTilesFromCurrentPosition(obj->pos.x, obj->pos.y))
-			{
-				continue;
-			}
-			STRUCTURE *psStructure = castStructure(obj);
-
-			if (!clipStructureOnScreen(psStructure))
-			{
-				continue;
-			}
-
-			renderStructure(psStructure, viewMatrix, perspectiveViewMatrix);
-		}
+		sceneObjects.insert(sceneObjects.end(), apsStructLists[aPlayer].begin(), apsStructLists[aPlayer].end());
 	}
 
 	// Walk through destroyed objects.
+	sceneObjects.insert(sceneObjects.end(), psDestroyedObj.begin(), psDestroyedObj.end());
 
-	/* Now go all buildings for that player */
-	for (BASE_OBJECT* obj : psDestroyedObj)
-	{
+	cullAndRenderSceneObjects([](BASE_OBJECT *obj, size_t) {
 		/* Worth rendering the structure? */
 		if (obj->type != OBJ_STRUCTURE || (obj->died != 0 && obj->died < graphicsTime)
 			|| !quickClipXYToMaximumTilesFromCurrentPosition(obj->pos.x, obj->pos.y))
 		{
-			continue;
-		}
-		STRUCTURE* psStructure = castStructure(obj);
-
-		if (!clipStructureOnScreen(psStructure))
-		{
-			continue;
+			return false;
 		}
-
-		renderStructure(psStructure, viewMatrix, perspectiveViewMatrix);
-	}
+		return clipStructureOnScreen(castStructure(obj));
+	}, [&](BASE_OBJECT *obj) {
+		renderStructure(castStructure(obj), viewMatrix, perspectiveViewMatrix);
+	});
 
 //	pie_SetDepthOffset(0.0f);
 }
@@ -2328,33 +2352,26 @@ static void displayFeatures(const glm::mat4 &viewMatrix, const glm::mat4 &perspe
 	// player can only be 0 for the features.
 
 	/* Go through all the features */
-	for (BASE_OBJECT* obj : apsFeatureLists[0])
-	{
-		if (obj->type == OBJ_FEATURE
-			&& (obj->died == 0 || obj->died > graphicsTime)
-			&& quickClipXYToMaximumTilesFromCurrentPosition(obj->pos.x, obj->pos.y))
-		{
-			FEATURE* psFeature = castFeature(obj);
-			if (clipFeatureOnScreen(psFeature))
-			{
-				renderFeature(psFeature, viewMatrix, perspectiveViewMatrix);
-			}
-		}
-	}
+	sceneObjects.assign(apsFeatureLists[0].begin(), apsFeatureLists[0].end());
+	const size_t numLiveFeatures = sceneObjects.size();
 
 	// Walk through destroyed objects.
+	sceneObjects.insert(sceneObjects.end(), psDestroyedObj.begin(), psDestroyedObj.end());
 
-	/* Go through all the features */
-	for (BASE_OBJECT* obj : psDestroyedObj)
-	{
-		if (obj->type == OBJ_FEATURE
-			&& (obj->died == 0 || obj->died > graphicsTime)
-			&& clipXY(obj->pos.x, obj->pos.y))
+	cullAndRenderSceneObjects([numLiveFeatures](BASE_OBJECT *obj, size_t index) {
+		if (obj->type != OBJ_FEATURE || (obj->died != 0 && obj->died <= graphicsTime))
 		{
-			FEATURE* psFeature = castFeature(obj);
-			renderFeature(psFeature, viewMatrix, perspectiveViewMatrix);
+			return false;
 		}
-	}
+		if (index >= numLiveFeatures)
+		{
+			return clipXY(obj->pos.x, obj->pos.y);
+		}
+		return quickClipXYToMaximumTilesFromCurrentPosition(obj->pos.x, obj->pos.y)
+			&& clipFeatureOnScreen(castFeature(obj));
+	}, [&](BASE_OBJECT *obj) {
+		renderFeature(castFeature(obj), viewMatrix, perspectiveViewMatrix);
+	});
 }
 
 /// Draw the Proximity messages for the *SELECTED PLAYER ONLY*
@@ -2407,38 +2424,25 @@ static void displayDynamicObjects(const glm::mat4 &viewMatrix, const glm::mat4 &
 	/* Need to go through all the droid lists */
 	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 	{
-		for (DROID* psDroid : apsDroidLists[player])
-		{
-			if (!psDroid || (psDroid->died != 0 && psDroid->died < graphicsTime)
-			    || !quickClipXYToMaximumTilesFromCurrentPosition(psDroid->pos.x, psDroid->pos.y))
-			{
-				continue;
-			}
-
-			/* No point in adding it if you can't see it? */
-			if (psDroid->visibleForLocalDisplay())
-			{
-				displayComponentObject(psDroid, viewMatrix, perspectiveViewMatrix);
-			}
-		}
+		sceneObjects.insert(sceneObjects.end(), apsDroidLists[player].begin(), apsDroidLists[player].end());
 	}
 
 	// Walk through destroyed objects.
-	for (const auto& obj : psDestroyedObj)
-	{
-		DROID* psDroid = castDroid(obj);
-		if (!psDroid || (obj->died != 0 && obj->died < graphicsTime)
-			|| !quickClipXYToMaximumTilesFromCurrentPosition(obj->pos.x, obj->pos.y))
+	sceneObjects.insert(sceneObjects.end(), psDestroyedObj.begin(), psDestroyedObj.end());
+
+	cullAndRenderSceneObjects([](BASE_OBJECT *obj, size_t) {
+		DROID *psDroid = castDroid(obj);
+		if (!psDroid || (psDroid->died != 0 && psDroid->died < graphicsTime)
+		    || !quickClipXYToMaximumTilesFromCurrentPosition(psDroid->pos.x, psDroid->pos.y))
 		{
-			continue;
+			return false;
 		}
 
 		/* No point in adding it if you can't see it? */
-		if (psDroid->visibleForLocalDisplay())
-		{
-			displayComponentObject(psDroid, viewMatrix, perspectiveViewMatrix);
-		}
-	}
+		return psDroid->visibleForLocalDisplay() != 0;
+	}, [&](BASE_OBJECT *obj) {
+		displayComponentObject(castDroid(obj), viewMatrix, perspectiveViewMatrix);
+	});
 }
 
 /// Sets the player's position and view angle - defaults player rotations as well
@@ -2369,19 +2369,8 @@ bool writeFXData(const char *fileName)
 		// Move on to reading the next effect
 	}
 
-	std::string jsonString;
-	try {
-		jsonString = mRoot.dump(4);
-	}
-	catch (const std::exception &e) {
-		ASSERT(false, "Failed to save JSON to %s with error: %s", fileName, e.what());
-		return false;
-	}
 	debug(LOG_SAVE, "%s %s", "Saving", fileName);
-	saveFile(fileName, jsonString.c_str(), jsonString.size());
-
-	// Everything is just fine!
-	return true;
+	return wzSaveJsonDocument(fileName, std::move(mRoot));
 }
 
 /** This will read in the effects data */
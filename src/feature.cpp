@@ -52,15 +52,20 @@
 #include "display3d.h"
 #include "random.h"
 
+#include <unordered_map>
+
 /* The statistics for the features */
 std::vector<FEATURE_STATS> asFeatureStats;
 
 //Value is stored for easy access to this feature in destroyDroid()/destroyStruct()
 FEATURE_STATS *oilResFeature = nullptr;
 
+static std::unordered_map<WzString, FEATURE_STATS *> lookupFeatureStatPtr;
+
 void featureInitVars()
 {
 	asFeatureStats.clear();
+	lookupFeatureStatPtr.clear();
 	oilResFeature = nullptr;
 }
 
@@ -136,6 +141,12 @@ bool loadFeatureStats(WzConfig &ini)
 		ini.endGroup();
 	}
 
+	lookupFeatureStatPtr.clear();
+	for (FEATURE_STATS &stats : asFeatureStats)
+	{
+		lookupFeatureStatPtr.insert(std::make_pair(stats.id, &stats));
+	}
+
 	return true;
 }
 
@@ -143,6 +154,7 @@ bool loadFeatureStats(WzConfig &ini)
 void featureStatsShutDown()
 {
 	asFeatureStats.clear();
+	lookupFeatureStatPtr.clear();
 }
 
 /** Deals with damage to a feature
@@ -324,6 +336,7 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave,
 				}
 
 				psTile->psObject = (BASE_OBJECT *)psFeature;
+				invalidateBuildableTile(b.map.x + width, b.map.y + breadth);
 
 				// if it's a tall feature then flag it in the map.
 				if (psFeature->sDisplay.imd->max.y > TALLOBJECT_YMAX)
@@ -421,6 +434,7 @@ bool removeFeature(FEATURE *psDel)
 				if (psTile->psObject == psDel)
 				{
 					psTile->psObject = nullptr;
+					invalidateBuildableTile(b.map.x + width, b.map.y + breadth);
 					auxClearBlocking(b.map.x + width, b.map.y + breadth, FEATURE_BLOCKED | AIR_BLOCKED);
 				}
 			}
@@ -550,6 +564,7 @@ bool destroyFeature(FEATURE *psDel, unsigned impactTime)
 				{
 					continue;
 				}
+				invalidateBuildableTile(x, y); // terrain changes
 				// stops water texture changing for underwater features
 				if (terrainType(psTile) != TER_WATER)
 				{
@@ -585,19 +600,24 @@ bool destroyFeature(FEATURE *psDel, unsigned impactTime)
 
 SDWORD getFeatureStatFromName(const WzString &name)
 {
-	FEATURE_STATS *psStat;
-
-	for (unsigned inc = 0, size = asFeatureStats.size(); inc < size; inc++)
+	FEATURE_STATS *psStat = getFeatureStatsFromName(name);
+	if (psStat)
 	{
-		psStat = &asFeatureStats[inc];
-		if (psStat->id.compare(name) == 0)
-		{
-			return inc;
-		}
+		return static_cast<SDWORD>(psStat - asFeatureStats.data());
 	}
 	return -1;
 }
 
+FEATURE_STATS *getFeatureStatsFromName(const WzString &name)
+{
+	auto it = lookupFeatureStatPtr.find(name);
+	if (it != lookupFeatureStatPtr.end())
+	{
+		return it->second;
+	}
+	return nullptr;
+}
+
 StructureBounds getStructureBounds(FEATURE const *object)
 {
 	return getStructureBounds(object->psStats, object->pos.xy());
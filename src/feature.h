@@ -55,6 +55,8 @@ bool destroyFeature(FEATURE *psDel, unsigned impactTime);
 
 /* get a feature stat id from its name */
 SDWORD getFeatureStatFromName(const WzString &name);
+/* get a feature's stats from its name */
+FEATURE_STATS *getFeatureStatsFromName(const WzString &name);
 
 int32_t featureDamage(FEATURE *psFeature, unsigned damage, WEAPON_CLASS weaponClass, WEAPON_SUBCLASS weaponSubClass, unsigned impactTime, bool isDamagePerSecond, int minDamage, bool empRadiusHit);
 
@@ -0,0 +1,509 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file fpathregion.cpp
+ *
+ * Reachability regions, per player and class of propulsion.
+ *
+ * The map is split into the same 8x8 tile sectors the aux map changes are tracked in (see auxMarkChanged()). Within
+ * each sector, the tiles a droid can stand on are grouped into nodes of tiles connected inside the sector. Nodes in
+ * neighbouring sectors are connected if any of their tiles are next to each other, and the connected components of
+ * that graph are the regions. The edges across each sector border are kept with the sector, so when blocking changes
+ * only the nodes and borders of the changed sectors are rebuilt, the regions are then recomputed from the (small) node
+ * graph without looking at any tiles.
+ *
+ * The path finding does not cut corners, so tiles are connected to their 4 orthogonal neighbours only.
+ */
+
+#include "lib/framework/frame.h"
+#include "fpathregion.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <vector>
+
+#include "map.h"
+#include "fpath.h"
+
+#define SECTOR_SIZE	(1 << AUX_SECTOR_SHIFT)
+#define NO_NODE		0xff
+
+namespace
+{
+	enum RegionClass
+	{
+		REGION_GROUND,
+		REGION_PROPELLOR,
+		REGION_HOVER,
+		REGION_CLASS_COUNT
+	};
+
+	struct RegionNode
+	{
+		Vector2i centre;	///< Centre of the node's tiles, in world coordinates
+		uint32_t region;
+		int sector;
+	};
+
+	/// Nodes on either side of a sector border that have tiles next to each other
+	struct RegionEdge
+	{
+		uint8_t node;	///< Node in this sector
+		uint8_t other;	///< Node in the sector to the right or below
+	};
+
+	struct RegionSector
+	{
+		std::vector<RegionNode> nodes;
+		uint32_t firstNode = 0;	///< Index of nodes[0] in the graph of all nodes
+		std::vector<RegionEdge> rightEdges;	///< Edges to the sector to the right
+		std::vector<RegionEdge> bottomEdges;	///< Edges to the sector below
+	};
+
+	struct RegionMap
+	{
+		const uint8_t *blockMap = nullptr;	///< To notice when the map was replaced, such as for an offworld mission
+		int width = 0, height = 0;
+		int minX = 0, minY = 0, maxX = 0, maxY = 0;
+		uint32_t generation = 0;
+		int sectorsX = 0, sectorsY = 0;
+		std::vector<uint8_t> tileNode;	///< Index of the tile's node in its sector, or NO_NODE if blocking
+		std::vector<RegionSector> sectors;
+		std::vector<RegionNode> nodes;	///< The nodes of all sectors
+	};
+
+	std::array<std::array<std::unique_ptr<RegionMap>, REGION_CLASS_COUNT>, MAX_PLAYERS> regionMaps;
+}
+
+static PROPULSION_TYPE regionPropulsion(RegionClass regionClass)
+{
+	switch (regionClass)
+	{
+	case REGION_PROPELLOR: return PROPULSION_TYPE_PROPELLOR;
+	case REGION_HOVER: return PROPULSION_TYPE_HOVER;
+	default: return PROPULSION_TYPE_WHEELED;
+	}
+}
+
+static void regionBuildSector(RegionMap &map, PROPULSION_TYPE propulsion, int player, int sectorX, int sectorY)
+{
+	RegionSector &sector = map.sectors[sectorX + sectorY * map.sectorsX];
+	const int x1 = sectorX * SECTOR_SIZE, y1 = sectorY * SECTOR_SIZE;
+	const int x2 = std::min(x1 + SECTOR_SIZE, map.width), y2 = std::min(y1 + SECTOR_SIZE, map.height);
+
+	sector.nodes.clear();
+	for (int y = y1; y < y2; ++y)
+	{
+		for (int x = x1; x < x2; ++x)
+		{
+			map.tileNode[x + y * map.width] = NO_NODE;
+		}
+	}
+
+	Vector2i stack[SECTOR_SIZE * SECTOR_SIZE];
+	for (int y = y1; y < y2; ++y)
+	{
+		for (int x = x1; x < x2; ++x)
+		{
+			if (map.tileNode[x + y * map.width] != NO_NODE || fpathBaseBlockingTile(x, y, propulsion, player, FMT_MOVE))
+			{
+				continue;
+			}
+			const uint8_t node = static_cast<uint8_t>(sector.nodes.size());
+			Vector2i sum(0, 0);
+			int numTiles = 0;
+			int stackSize = 0;
+			map.tileNode[x + y * map.width] = node;
+			stack[stackSize++] = Vector2i(x, y);
+			while (stackSize > 0)
+			{
+				const Vector2i tile = stack[--stackSize];
+				sum += tile;
+				++numTiles;
+				const Vector2i neighbours[4] = {tile + Vector2i(1, 0), tile + Vector2i(-1, 0), tile + Vector2i(0, 1), tile + Vector2i(0, -1)};
+				for (const Vector2i &next : neighbours)
+				{
+					if (next.x < x1 || next.x >= x2 || next.y < y1 || next.y >= y2 || map.tileNode[next.x + next.y * map.width] != NO_NODE
+					    || fpathBaseBlockingTile(next.x, next.y, propulsion, player, FMT_MOVE))
+					{
+						continue;
+					}
+					map.tileNode[next.x + next.y * map.width] = node;
+					stack[stackSize++] = next;
+				}
+			}
+			const Vector2i centre = world_coord(sum) / numTiles + Vector2i(TILE_UNITS / 2, TILE_UNITS / 2);
+			sector.nodes.push_back({centre, 0, sectorX + sectorY * map.sectorsX});
+		}
+	}
+}
+
+static uint32_t regionNodeAt(const RegionMap &map, int x, int y)
+{
+	const uint8_t node = map.tileNode[x + y * map.width];
+	if (node == NO_NODE)
+	{
+		return UINT32_MAX;
+	}
+	return map.sectors[(x / SECTOR_SIZE) + (y / SECTOR_SIZE) * map.sectorsX].firstNode + node;
+}
+
+/// Collect the edges between the nodes of a sector and those of the sectors to its right and below, needs to be redone
+/// when the nodes of either side were rebuilt
+static void regionBuildBorders(RegionMap &map, int sectorX, int sectorY)
+{
+	RegionSector &sector = map.sectors[sectorX + sectorY * map.sectorsX];
+	const int x1 = sectorX * SECTOR_SIZE, y1 = sectorY * SECTOR_SIZE;
+	const int x2 = std::min(x1 + SECTOR_SIZE, map.width), y2 = std::min(y1 + SECTOR_SIZE, map.height);
+	auto addEdges = [&map](std::vector<RegionEdge> &edges, Vector2i tile, Vector2i step, Vector2i across, int count) {
+		edges.clear();
+		for (int i = 0; i < count; ++i, tile += step)
+		{
+			const uint8_t node = map.tileNode[tile.x + tile.y * map.width];
+			const uint8_t other = map.tileNode[(tile.x + across.x) + (tile.y + across.y) * map.width];
+			if (node == NO_NODE || other == NO_NODE)
+			{
+				continue;
+			}
+			if (std::none_of(edges.begin(), edges.end(), [&](const RegionEdge &edge) { return edge.node == node && edge.other == other; }))
+			{
+				edges.push_back({node, other});
+			}
+		}
+	};
+	if (x2 < map.width)
+	{
+		addEdges(sector.rightEdges, Vector2i(x2 - 1, y1), Vector2i(0, 1), Vector2i(1, 0), y2 - y1);
+	}
+	else
+	{
+		sector.rightEdges.clear();
+	}
+	if (y2 < map.height)
+	{
+		addEdges(sector.bottomEdges, Vector2i(x1, y2 - 1), Vector2i(1, 0), Vector2i(0, 1), x2 - x1);
+	}
+	else
+	{
+		sector.bottomEdges.clear();
+	}
+}
+
+/// Call func(node, neighbourNode) for every edge of the node graph
+template <typename Func>
+static void regionForEachEdge(const RegionMap &map, Func func)
+{
+	for (int sectorIdx = 0; sectorIdx < static_cast<int>(map.sectors.size()); ++sectorIdx)
+	{
+		const RegionSector &sector = map.sectors[sectorIdx];
+		for (const RegionEdge &edge : sector.rightEdges)
+		{
+			func(sector.firstNode + edge.node, map.sectors[sectorIdx + 1].firstNode + edge.other);
+		}
+		for (const RegionEdge &edge : sector.bottomEdges)
+		{
+			func(sector.firstNode + edge.node, map.sectors[sectorIdx + map.sectorsX].firstNode + edge.other);
+		}
+	}
+}
+
+/// Call func(neighbourNode) for every node connected to the given one
+template <typename Func>
+static void regionForEachNeighbour(const RegionMap &map, uint32_t node, Func func)
+{
+	const int sectorIdx = map.nodes[node].sector;
+	const int sectorX = sectorIdx % map.sectorsX, sectorY = sectorIdx / map.sectorsX;
+	const RegionSector &sector = map.sectors[sectorIdx];
+	const uint8_t local = static_cast<uint8_t>(node - sector.firstNode);
+	for (const RegionEdge &edge : sector.rightEdges)
+	{
+		if (edge.node == local)
+		{
+			func(map.sectors[sectorIdx + 1].firstNode + edge.other);
+		}
+	}
+	for (const RegionEdge &edge : sector.bottomEdges)
+	{
+		if (edge.node == local)
+		{
+			func(map.sectors[sectorIdx + map.sectorsX].firstNode + edge.other);
+		}
+	}
+	if (sectorX > 0)
+	{
+		const RegionSector &left = map.sectors[sectorIdx - 1];
+		for (const RegionEdge &edge : left.rightEdges)
+		{
+			if (edge.other == local)
+			{
+				func(left.firstNode + edge.node);
+			}
+		}
+	}
+	if (sectorY > 0)
+	{
+		const RegionSector &above = map.sectors[sectorIdx - map.sectorsX];
+		for (const RegionEdge &edge : above.bottomEdges)
+		{
+			if (edge.other == local)
+			{
+				func(above.firstNode + edge.node);
+			}
+		}
+	}
+}
+
+static void regionBuildRegions(RegionMap &map)
+{
+	map.nodes.clear();
+	for (RegionSector &sector : map.sectors)
+	{
+		sector.firstNode = static_cast<uint32_t>(map.nodes.size());
+		map.nodes.insert(map.nodes.end(), sector.nodes.begin(), sector.nodes.end());
+	}
+
+	std::vector<uint32_t> parent(map.nodes.size());
+	std::iota(parent.begin(), parent.end(), 0);
+	auto find = [&parent](uint32_t node) {
+		while (parent[node] != node)
+		{
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+		return node;
+	};
+	regionForEachEdge(map, [&](uint32_t a, uint32_t b) {
+		a = find(a);
+		b = find(b);
+		if (a != b)
+		{
+			parent[std::max(a, b)] = std::min(a, b);
+		}
+	});
+
+	for (uint32_t node = 0; node < map.nodes.size(); ++node)
+	{
+		map.nodes[node].region = find(node);
+	}
+}
+
+static RegionMap *regionGetMap(PROPULSION_TYPE propulsion, int player)
+{
+	ASSERT_OR_RETURN(nullptr, player >= 0 && player < MAX_PLAYERS, "Bad player %d", player);
+	RegionClass regionClass = REGION_GROUND;
+	switch (propulsion)
+	{
+	case PROPULSION_TYPE_PROPELLOR: regionClass = REGION_PROPELLOR; break;
+	case PROPULSION_TYPE_HOVER: regionClass = REGION_HOVER; break;
+	case PROPULSION_TYPE_WHEELED:
+	case PROPULSION_TYPE_TRACKED:
+	case PROPULSION_TYPE_LEGGED:
+	case PROPULSION_TYPE_HALF_TRACKED: break;
+	default:
+		ASSERT(false, "No regions for propulsion %d", (int)propulsion);
+		return nullptr;
+	}
+
+	std::unique_ptr<RegionMap> &map = regionMaps[player][regionClass];
+	if (!map)
+	{
+		map = std::make_unique<RegionMap>();
+	}
+	const bool rebuildAll = map->blockMap != psBlockMap[AUX_MAP].get() || map->width != mapWidth || map->height != mapHeight
+	                        || map->minX != scrollMinX || map->minY != scrollMinY || map->maxX != scrollMaxX || map->maxY != scrollMaxY;
+	if (!rebuildAll && map->generation == auxMapGeneration)
+	{
+		return map.get();
+	}
+
+	if (rebuildAll)
+	{
+		map->blockMap = psBlockMap[AUX_MAP].get();
+		map->width = mapWidth;
+		map->height = mapHeight;
+		map->minX = scrollMinX;
+		map->minY = scrollMinY;
+		map->maxX = scrollMaxX;
+		map->maxY = scrollMaxY;
+		map->sectorsX = (mapWidth + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		map->sectorsY = (mapHeight + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		map->tileNode.assign(static_cast<size_t>(mapWidth) * mapHeight, NO_NODE);
+		map->sectors.assign(static_cast<size_t>(map->sectorsX) * map->sectorsY, RegionSector());
+	}
+	const PROPULSION_TYPE representative = regionPropulsion(regionClass);
+	std::vector<uint8_t> bordersChanged(map->sectors.size(), 0);
+	for (int sectorY = 0; sectorY < map->sectorsY; ++sectorY)
+	{
+		for (int sectorX = 0; sectorX < map->sectorsX; ++sectorX)
+		{
+			if (rebuildAll || auxSectorGeneration[sectorX + sectorY * AUX_SECTORS_X] > map->generation)
+			{
+				regionBuildSector(*map, representative, player, sectorX, sectorY);
+				// The borders to the left and above are stored in the neighbouring sectors
+				const int sectorIdx = sectorX + sectorY * map->sectorsX;
+				bordersChanged[sectorIdx] = 1;
+				if (sectorX > 0)
+				{
+					bordersChanged[sectorIdx - 1] = 1;
+				}
+				if (sectorY > 0)
+				{
+					bordersChanged[sectorIdx - map->sectorsX] = 1;
+				}
+			}
+		}
+	}
+	for (int sectorIdx = 0; sectorIdx < static_cast<int>(map->sectors.size()); ++sectorIdx)
+	{
+		if (bordersChanged[sectorIdx])
+		{
+			regionBuildBorders(*map, sectorIdx % map->sectorsX, sectorIdx / map->sectorsX);
+		}
+	}
+	regionBuildRegions(*map);
+	map->generation = auxMapGeneration;
+	return map.get();
+}
+
+/// The node of the passable tile nearest to pos, searching the 5x5 tiles around it like the path finding does
+static uint32_t regionFindNode(const RegionMap &map, Position pos)
+{
+	const Vector2i centreTile = map_coord(pos.xy());
+	uint32_t bestNode = UINT32_MAX;
+	int bestDistSq = INT32_MAX;
+	for (int y = -2; y <= 2; ++y)
+	{
+		for (int x = -2; x <= 2; ++x)
+		{
+			const Vector2i tile = centreTile + Vector2i(x, y);
+			if (tile.x < 0 || tile.y < 0 || tile.x >= map.width || tile.y >= map.height)
+			{
+				continue;
+			}
+			const Vector2i diff = world_coord(tile) + Vector2i(TILE_UNITS / 2, TILE_UNITS / 2) - pos.xy();
+			const int distSq = dot(diff, diff);
+			const uint32_t node = regionNodeAt(map, tile.x, tile.y);
+			if (distSq < bestDistSq && node != UINT32_MAX)
+			{
+				bestNode = node;
+				bestDistSq = distSq;
+			}
+		}
+	}
+	return bestNode;
+}
+
+bool fpathRegionCheck(Position orig, Position dest, PROPULSION_TYPE propulsion, int player)
+{
+	if (!worldOnMap(orig.xy()) || !worldOnMap(dest.xy()))
+	{
+		return false;
+	}
+	if (propulsion == PROPULSION_TYPE_LIFT)
+	{
+		return true;
+	}
+	const RegionMap *map = regionGetMap(propulsion, player);
+	if (map == nullptr)
+	{
+		return false;
+	}
+	const uint32_t origNode = regionFindNode(*map, orig);
+	const uint32_t destNode = regionFindNode(*map, dest);
+	return origNode != UINT32_MAX && destNode != UINT32_MAX && map->nodes[origNode].region == map->nodes[destNode].region;
+}
+
+int fpathRegionDistance(Position orig, Position dest, PROPULSION_TYPE propulsion, int player)
+{
+	if (!worldOnMap(orig.xy()) || !worldOnMap(dest.xy()))
+	{
+		return -1;
+	}
+	if (propulsion == PROPULSION_TYPE_LIFT)
+	{
+		return iHypot(dest.xy() - orig.xy());
+	}
+	const RegionMap *map = regionGetMap(propulsion, player);
+	if (map == nullptr)
+	{
+		return -1;
+	}
+	const uint32_t origNode = regionFindNode(*map, orig);
+	const uint32_t destNode = regionFindNode(*map, dest);
+	if (origNode == UINT32_MAX || destNode == UINT32_MAX || map->nodes[origNode].region != map->nodes[destNode].region)
+	{
+		return -1;
+	}
+	if (origNode == destNode)
+	{
+		return iHypot(dest.xy() - orig.xy());
+	}
+
+	// A* through the node graph, from centre to centre
+	const Vector2i destCentre = map->nodes[destNode].centre;
+	std::vector<int> dist(map->nodes.size(), INT32_MAX);
+	typedef std::pair<int, uint32_t> QueueEntry;  // estimated total distance, node
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open;
+	const Vector2i origCentre = map->nodes[origNode].centre;
+	dist[origNode] = 0;
+	open.push({iHypot(destCentre - origCentre), origNode});
+	while (!open.empty())
+	{
+		const uint32_t node = open.top().second;
+		const int estimate = open.top().first;
+		open.pop();
+		const RegionNode &current = map->nodes[node];
+		if (estimate > dist[node] + iHypot(destCentre - current.centre))
+		{
+			continue;  // Already reached with a shorter distance
+		}
+		if (node == destNode)
+		{
+			break;
+		}
+		regionForEachNeighbour(*map, node, [&](uint32_t next) {
+			const RegionNode &nextNode = map->nodes[next];
+			const int nextDist = dist[node] + iHypot(nextNode.centre - current.centre);
+			if (nextDist < dist[next])
+			{
+				dist[next] = nextDist;
+				open.push({nextDist + iHypot(destCentre - nextNode.centre), next});
+			}
+		});
+	}
+	if (dist[destNode] == INT32_MAX)
+	{
+		return -1;  // Should not happen, since both are in the same region
+	}
+	return iHypot(origCentre - orig.xy()) + dist[destNode] + iHypot(dest.xy() - destCentre);
+}
+
+void fpathRegionShutdown()
+{
+	for (auto &playerMaps : regionMaps)
+	{
+		for (auto &map : playerMaps)
+		{
+			map.reset();
+		}
+	}
+}
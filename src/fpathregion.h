@@ -0,0 +1,45 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Cached reachability regions, which unlike the map continents take structures into account.
+ */
+
+#ifndef __INCLUDED_SRC_FPATHREGION_H__
+#define __INCLUDED_SRC_FPATHREGION_H__
+
+#include "lib/framework/vector.h"
+#include "statsdef.h"
+
+/** Whether a droid of the given player and propulsion could move from orig to dest, going around structures that
+ *  block it, but through its own and allied gates (as FMT_MOVE). orig and dest are in world coordinates.
+ *  The regions are updated on demand, relabelling only the parts of the map where blocking changed since the last call,
+ *  after that the check is O(1). Not thread safe, since the cached regions are updated in place: only call it from
+ *  the game loop thread, as scripts and the AI do.
+ */
+bool fpathRegionCheck(Position orig, Position dest, PROPULSION_TYPE propulsion, int player);
+
+/** Estimate the length of the route fpathRegionCheck() would take, in world units, or -1 if dest cannot be reached.
+ *  Searches a coarse graph of the regions, so this is much cheaper than finding a path, but may be some tiles off.
+ */
+int fpathRegionDistance(Position orig, Position dest, PROPULSION_TYPE propulsion, int player);
+
+/** Free the cached regions. */
+void fpathRegionShutdown();
+
+#endif // __INCLUDED_SRC_FPATHREGION_H__
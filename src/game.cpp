@@ -128,18 +128,10 @@
 # include "emscripten_helpers.h"
 #endif
 
-bool saveJSONToFile(const nlohmann::json& obj, const char* pFileName)
+bool saveJSONToFile(nlohmann::json obj, const char* pFileName)
 {
-	std::string jsonString;
-	try {
-		jsonString = obj.dump(4);
-	}
-	catch (const std::exception &e) {
-		ASSERT(false, "Failed to save JSON to %s with error: %s", pFileName, e.what());
-		return false;
-	}
 	debug(LOG_SAVE, "%s %s", "Saving", pFileName);
-	return saveFile(pFileName, jsonString.c_str(), jsonString.size());
+	return wzSaveJsonDocument(pFileName, std::move(obj));
 }
 
 void gameScreenSizeDidChange(unsigned int oldWidth, unsigned int oldHeight, unsigned int newWidth, unsigned int newHeight)
@@ -2675,6 +2667,9 @@ bool loadGame(const GameLoadDetails& gameToLoad, bool keepObjects, bool freeMem)
 	/* Stop the game clock */
 	gameTimeStop();
 
+	// make sure a savegame still being written in the background is complete before reading anything
+	wzConfigWaitForBackgroundWrites();
+
 	if ((gameType == GTYPE_SAVE_START) ||
 	    (gameType == GTYPE_SAVE_MIDMISSION))
 	{
@@ -2704,6 +2699,9 @@ bool loadGame(const GameLoadDetails& gameToLoad, bool keepObjects, bool freeMem)
 			apsDroidLists[player].clear();
 			apsStructLists[player].clear();
 			apsFeatureLists[player].clear();
+			invalidateObjectListIndex(apsDroidLists, player);
+			invalidateObjectListIndex(apsStructLists, player);
+			invalidateObjectListIndex(apsFeatureLists, player);
 			apsFlagPosLists[player].clear();
 			//clear all the messages?
 			apsProxDisp[player].clear();
@@ -2723,6 +2721,9 @@ bool loadGame(const GameLoadDetails& gameToLoad, bool keepObjects, bool freeMem)
 			mission.apsDroidLists[player].clear();
 			mission.apsStructLists[player].clear();
 			mission.apsFeatureLists[player].clear();
+			invalidateObjectListIndex(mission.apsDroidLists, player);
+			invalidateObjectListIndex(mission.apsStructLists, player);
+			invalidateObjectListIndex(mission.apsFeatureLists, player);
 			mission.apsFlagPosLists[player].clear();
 			mission.apsExtractorLists[player].clear();
 		}
@@ -3475,6 +3476,7 @@ bool loadGame(const GameLoadDetails& gameToLoad, bool keepObjects, bool freeMem)
 			//the first transporter group sent off at Beta-end by reversing this very list.
 			ASSERT(selectedPlayer < MAX_PLAYERS, "selectedPlayer is out of bounds: %" PRIu32 "", selectedPlayer);
 			mission.apsDroidLists[selectedPlayer].reverse();
+			invalidateObjectListIndex(mission.apsDroidLists, selectedPlayer);
 		}
 	}
 
@@ -3539,6 +3541,27 @@ error:
 }
 // -----------------------------------------------------------------------------------------
 
+// Only autosaves are left to finish writing in the background. Any other save waits, so a failure reaches the caller
+// (which tells the user) - a failed autosave is reported by the next save, which has to wait for it first.
+static bool finishSaveGameWrites(bool isAutoSave)
+{
+	bool written = true;
+#if defined(__EMSCRIPTEN__)
+	written = wzConfigWaitForBackgroundWrites();
+	WZ_EmscriptenSyncPersistFSChanges(!isAutoSave); // NOTE: Will block main loop iterations until it finishes (asynchronously)
+#else
+	if (!isAutoSave)
+	{
+		written = wzConfigWaitForBackgroundWrites();
+	}
+#endif
+	if (!written)
+	{
+		debug(LOG_ERROR, "Failed to write some of the savegame files");
+	}
+	return written;
+}
+
 bool saveGame(const char *aFileName, GAME_TYPE saveType, bool isAutoSave)
 {
 	size_t			fileExtension;
@@ -3554,6 +3577,13 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType, bool isAutoSave)
 	gameTimeStop();
 	sanityUpdate();
 
+	// a previous save may still be writing in the background (and could be overwritten by this one)
+	if (!wzConfigWaitForBackgroundWrites())
+	{
+		debug(LOG_ERROR, "Previous savegame was not completely written");
+		addConsoleMessage(_("The last autosave could not be written!"), LEFT_JUSTIFY, NOTIFY_MESSAGE);
+	}
+
 	/* Write the data to the file */
 	if (!writeGameFile(CurrentFileName, saveType))
 	{
@@ -3583,6 +3613,10 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType, bool isAutoSave)
 	strcat(CurrentFileName, "gameinfo.json");
 	writeGameInfo(CurrentFileName);
 
+	// The remaining sections are serialised and written by the background write thread.
+	// (The above files are needed to list / identify the savegame, so they are always written immediately as JSON.)
+	wzConfigBeginBackgroundWrites((war_getBinarySaveGames()) ? WzConfigFormat::Binary : WzConfigFormat::JSON);
+
 	// Save labels
 	CurrentFileName[fileExtension] = '\0';
 	strcat(CurrentFileName, "labels.json");
@@ -3833,9 +3867,11 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType, bool isAutoSave)
 	// strip the last filename
 	CurrentFileName[fileExtension - 1] = '\0';
 
-#if defined(__EMSCRIPTEN__)
-	WZ_EmscriptenSyncPersistFSChanges(!isAutoSave); // NOTE: Will block main loop iterations until it finishes (asynchronously)
-#endif
+	wzConfigEndBackgroundWrites();
+	if (!finishSaveGameWrites(isAutoSave))
+	{
+		goto error;
+	}
 
 	/* Start the game clock */
 	triggerEvent(TRIGGER_GAME_SAVED);
@@ -3843,6 +3879,8 @@ bool saveGame(const char *aFileName, GAME_TYPE saveType, bool isAutoSave)
 	return true;
 
 error:
+	wzConfigEndBackgroundWrites();
+
 	/* Start the game clock */
 	gameTimeStart();
 
@@ -5173,12 +5211,12 @@ static bool writeGameFile(const char *fileName, SDWORD saveType)
 	auto saveInfoJson = saveInfoJsonOpt.value();
 	// new .json format
 	serializeSaveGameData_json(gamJson, saveInfoJson, gameName.c_str(), &saveGame);
-	if (!saveJSONToFile(gamJson, jsonFileName.c_str()))
+	if (!saveJSONToFile(std::move(gamJson), jsonFileName.c_str()))
 	{
 		debug(LOG_ERROR, "Failed to save: %s", jsonFileName.c_str());
 		return false;
 	}
-	if (!saveJSONToFile(saveInfoJson, saveInfoJsonFilename.c_str()))
+	if (!saveJSONToFile(std::move(saveInfoJson), saveInfoJsonFilename.c_str()))
 	{
 		debug(LOG_ERROR, "Failed to save: %s", saveInfoJsonFilename.c_str());
 		return false;
@@ -5230,7 +5268,7 @@ nonstd::optional<nlohmann::json> parseJsonFile(const char *filename)
 	}
 	nonstd::optional<nlohmann::json> result;
 	try {
-		result = nlohmann::json::parse(ppFileData);
+		result = wzParseJsonDocument(ppFileData, pFileSize);
 	}
 	catch (const std::exception &e) {
 		ASSERT(false, "JSON document from %s is invalid: %s", filename, e.what());
@@ -6131,7 +6169,7 @@ static bool writeDroidFile(const char *pFileName, const PerPlayerDroidLists& pps
 		}
 	}
 
-	return saveJSONToFile(mRoot, pFileName);
+	return saveJSONToFile(std::move(mRoot), pFileName);
 }
 
 
@@ -7328,7 +7366,7 @@ bool writeTemplateFile(const char *pFileName)
 	}
 	mRoot["localTemplates"] = std::move(localtemplates_array);
 
-	return saveJSONToFile(mRoot, pFileName);
+	return saveJSONToFile(std::move(mRoot), pFileName);
 }
 
 // Maps built into the game with custom tile types need to be excluded for overrides.
@@ -7779,7 +7817,7 @@ static bool writeResearchFile(char *pFileName)
 			mRoot[resKey.toStdString()] = std::move(resObj);
 		}
 	}
-	return saveJSONToFile(mRoot, pFileName);
+	return saveJSONToFile(std::move(mRoot), pFileName);
 }
 
 
@@ -8156,7 +8194,7 @@ static bool writeSaveGuideTopics(const char *pFileName)
 	options["disable_topic_popups"] = getGameGuideDisableTopicPopups();
 	mRoot["options"] = std::move(options);
 
-	return saveJSONToFile(mRoot, pFileName);
+	return saveJSONToFile(std::move(mRoot), pFileName);
 }
 
 static bool loadSaveGuideTopics(const char *pFileName)
@@ -104,7 +104,7 @@ const char *savegameWithoutExtension(const char *name);
 void gameScreenSizeDidChange(unsigned int oldWidth, unsigned int oldHeight, unsigned int newWidth, unsigned int newHeight);
 void gameDisplayScaleFactorDidChange(float newDisplayScaleFactor);
 nonstd::optional<nlohmann::json> parseJsonFile(const char *filename);
-bool saveJSONToFile(const nlohmann::json& obj, const char* pFileName);
+bool saveJSONToFile(nlohmann::json obj, const char* pFileName);
 
 #if defined(__EMSCRIPTEN__)
 void wz_emscripten_did_finish_render(unsigned int browserRenderDelta);
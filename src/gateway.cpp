@@ -30,6 +30,7 @@
 #include "wrappers.h"
 
 #include "gateway.h"
+#include "structure.h"
 
 /// the list of gateways on the current map
 static GATEWAY_LIST psGateways;
@@ -122,6 +123,7 @@ bool gwNewGateway(SDWORD x1, SDWORD y1, SDWORD x2, SDWORD y2)
 	psGateways.push_back(psNew);
 
 	// set the map flags
+	invalidateBuildableGateways();
 	if (psNew->x1 == psNew->x2)
 	{
 		// vertical gateway
@@ -161,6 +163,7 @@ static void gwFreeGateway(GATEWAY *psDel)
 	if (psMapTiles) // this lines fixes the bug where we were closing the gateways after freeing the map
 	{
 		// clear the map flags
+		invalidateBuildableGateways();
 		if (psDel->x1 == psDel->x2)
 		{
 			// vertical gateway
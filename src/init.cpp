@@ -32,6 +32,7 @@
 #include "lib/framework/physfs_ext.h"
 #include "3rdparty/physfs_memoryio.h"
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzconfig.h"
 #include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/piestate.h"
 #include "lib/ivis_opengl/screen.h"
@@ -61,6 +62,8 @@
 #include "effects.h"
 #include "formation.h"
 #include "fpath.h"
+#include "fpathregion.h"
+#include "scenejobs.h"
 #include "frend.h"
 #include "frontend.h"
 #include "game.h"
@@ -1120,6 +1123,8 @@ void systemShutdown()
 		closeLoadSaveOnShutdown(); // TODO: Ideally this would not be required here (refactor loadsave.cpp / frontend.cpp?)
 	}
 
+	wzConfigShutdownBackgroundWrites(); // finish writing any savegame still in progress
+
 	NETclose();
 
 	seqReleaseAll();
@@ -1160,6 +1165,7 @@ void systemShutdown()
 	notificationsShutDown();
 	widgShutDown();
 	fpathShutdown();
+	fpathRegionShutdown();
 	mapShutdown();
 	modelShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
@@ -1594,8 +1600,10 @@ bool stageTwoShutDown()
 	debug(LOG_WZ, "== stageTwoShutDown ==");
 
 	shutdown3DView_FullReset();
+	sceneJobsShutdown();
 
 	fpathShutdown();
+	fpathRegionShutdown();
 
 	cdAudio_Stop();
 
@@ -279,6 +279,7 @@ void rendering1999::LightingManager::ComputeFrameData(const LightingData& data,
 		endY = MAX(endY, 0);
 		endY = MIN(endY, mapHeight - 1);
 		startY = MIN(startY, endY);
+		markLightmapDirty(startX, startY, endX, endY);
 
 		for (int i = startX; i <= endX; i++)
 		{
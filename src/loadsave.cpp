@@ -35,6 +35,7 @@
 #include "lib/framework/stdio_ext.h"
 #include "lib/framework/wztime.h"
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzconfig.h"
 #include "lib/widget/button.h"
 #include "lib/widget/editbox.h"
 #include "lib/widget/widget.h"
@@ -556,6 +557,8 @@ void deleteSaveGame_classic(const char *gamFileName)
 
 void deleteSaveGame(std::string saveGameFolderPath)
 {
+	wzConfigWaitForBackgroundWrites(); // don't race with a savegame still being written
+
 	// Remove any trailing path separators (/)
 	while (!saveGameFolderPath.empty() && (saveGameFolderPath.rfind("/", std::string::npos) == (saveGameFolderPath.length() - 1)))
 	{
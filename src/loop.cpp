@@ -88,6 +88,7 @@
 #include "gamehistorylogger.h"
 #include "profiling.h"
 #include "wzapi.h"
+#include "stdinreader.h"
 
 #include "warzoneconfig.h"
 
@@ -131,6 +132,8 @@ static VIDEO_TIME_SKIP_STATE videoTimeSkipState;
 static size_t maxFastForwardTicks = WZ_DEFAULT_MAX_FASTFORWARD_TICKS;
 static bool fastForwardTicksFixedToNormalTickRate = true; // can be set to false to "catch-up" as quickly as possible (but this may result in more jerky behavior)
 static std::chrono::milliseconds sequenceMinSkipTime = std::chrono::milliseconds(800);
+static std::chrono::steady_clock::time_point replayCrunchStartTime;
+static uint32_t replayCrunchStartGameTime = 0;
 
 static unsigned numDroids[MAX_PLAYERS];
 static unsigned numMissionDroids[MAX_PLAYERS];
@@ -630,6 +633,27 @@ void setMaxFastForwardTicks(optional<size_t> value, bool fixedToNormalTickRate)
 	fastForwardTicksFixedToNormalTickRate = fixedToNormalTickRate;
 }
 
+void replayCrunchStart()
+{
+	replayCrunchStartTime = std::chrono::steady_clock::now();
+	replayCrunchStartGameTime = gameTime;
+}
+
+void replayCrunchFinish()
+{
+	double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayCrunchStartTime).count();
+	uint32_t simulatedTicks = (gameTime - replayCrunchStartGameTime) / GAME_TICKS_PER_UPDATE;
+	double ticksPerSecond = (elapsedSeconds > 0.0) ? (simulatedTicks / elapsedSeconds) : 0.0;
+
+	GameStoryLogger::instance().logGameOver();
+	stdOutGameSummary(0, false);
+	fprintf(stdout, "Replay crunch finished [gameTime: %" PRIu32 "]: %" PRIu32 " ticks simulated in %.2f s (%.1f ticks/s)\n", gameTime, simulatedTicks, elapsedSeconds, ticksPerSecond);
+	fflush(stdout);
+	wz_command_interface_output("WZEVENT: replayCrunchFinished: %" PRIu32 " %" PRIu32 " %.3f %.1f\n", gameTime, simulatedTicks, elapsedSeconds, ticksPerSecond);
+
+	wzQuit(0); // Trigger a *graceful* shutdown
+}
+
 static int renderBudget = 0;  // Scaled time spent rendering minus scaled time spent updating.
 const Rational renderFraction(2, 5);  // Minimum fraction of time spent rendering.
 const Rational updateFraction = Rational(1) - renderFraction;
@@ -77,9 +77,14 @@ bool scrollPaused();
 bool consolePaused();
 
 constexpr size_t WZ_DEFAULT_MAX_FASTFORWARD_TICKS = 1;
+constexpr size_t WZ_REPLAY_CRUNCH_MAX_FASTFORWARD_TICKS = 600; // one minute of game time per gameLoop() call
 size_t getMaxFastForwardTicks();
 void setMaxFastForwardTicks(optional<size_t> value = nullopt, bool fixedToNormalTickRate = true);
 
+// --replay-crunch: measure simulation throughput, and output the results + quit once the replay has ended
+void replayCrunchStart();
+void replayCrunchFinish();
+
 void setGameUpdatePause(bool state);
 void setAudioPause(bool state);
 void setScriptPause(bool state);
@@ -69,6 +69,7 @@
 #include "lib/ivis_opengl/piepalette.h"
 #include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/screen.h"
+#include "lib/ivis_opengl/tex.h"
 #include "lib/netplay/netplay.h"
 #include "lib/netplay/netreplay.h"
 #include "lib/sound/audio.h"
@@ -892,7 +893,13 @@ static bool startGameLoop()
 	setMaxFastForwardTicks(WZ_DEFAULT_MAX_FASTFORWARD_TICKS, true); // default value / spectator "catch-up" behavior
 	if (NETisReplay())
 	{
-		if (!headlessGameMode() && !autogame_enabled())
+		if (replay_crunch_enabled())
+		{
+			// simulate as quickly as possible, only returning to the main loop once per batch of ticks
+			setMaxFastForwardTicks(WZ_REPLAY_CRUNCH_MAX_FASTFORWARD_TICKS, false);
+			replayCrunchStart();
+		}
+		else if (!headlessGameMode() && !autogame_enabled())
 		{
 			// for replays, ensure we don't start off fast-forwarding
 			setMaxFastForwardTicks(0, true);
@@ -1174,6 +1181,7 @@ static void runTitleLoop()
 void mainLoop()
 {
 	frameUpdate(); // General housekeeping
+	pie_TexUpdateStreaming(); // Swap in streamed textures, for the models drawn in the last frame (in the 3D view or the UI)
 
 	pie_ScreenFrameRenderBegin();
 
@@ -2011,13 +2019,16 @@ int realmain(int argc, char *argv[])
 	{
 		gfxbackend = war_getGfxBackend();
 	}
-	if (!wzMainScreenSetup(gfxbackend, war_getAntialiasing(), war_getWindowMode(), war_GetVsync(), war_getLODDistanceBiasPercentage(), war_getShadowMapResolution()))
+	// --replay-crunch must not be throttled by the (headless) backend's frame pacing
+	int vsync = (replay_crunch_enabled()) ? 0 : war_GetVsync();
+	if (!wzMainScreenSetup(gfxbackend, war_getAntialiasing(), war_getWindowMode(), vsync, war_getLODDistanceBiasPercentage(), war_getShadowMapResolution()))
 	{
 		saveConfig(); // ensure any setting changes are persisted on failure
 		return EXIT_FAILURE;
 	}
 
 	initializeCrashHandlingContext(wzGetInitializedGfxBackend());
+	pie_SetTextureStreamingBudget(static_cast<size_t>(war_getTextureStreamingBudget()) * 1024 * 1024);
 
 	wzCmdInterfaceInit();
 
@@ -2088,6 +2099,12 @@ int realmain(int argc, char *argv[])
 	switch (GetGameMode())
 	{
 	case GS_TITLE_SCREEN:
+		if (precompress_textures_enabled())
+		{
+			size_t count = pie_PrecompressTextures();
+			fprintf(stdout, "Precompressed %zu textures\n", count);
+			wzQuit((count > 0) ? EXIT_SUCCESS : EXIT_FAILURE); // the title loop still gets set up, so shutdown is the usual one
+		}
 		// The usual case (unless command-line flags specify otherwise): Load into the title menu
 		startTitleLoop(true);
 		break;
@@ -51,6 +51,7 @@
 #include "astar.h"
 #include "fpath.h"
 #include "levels.h"
+#include "structure.h"
 #include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/pielighting.h"
 
@@ -114,6 +115,8 @@ SDWORD	mapWidth = 0, mapHeight = 0;
 std::unique_ptr<MAPTILE[]> psMapTiles;
 std::unique_ptr<uint8_t[]> psBlockMap[AUX_MAX];
 std::unique_ptr<uint8_t[]> psAuxMap[MAX_PLAYERS + AUX_MAX];        // yes, we waste one element... eyes wide open... makes API nicer
+uint32_t auxMapGeneration = 0;
+uint32_t auxSectorGeneration[AUX_SECTORS_X * AUX_SECTORS_Y] = {};
 
 #define WATER_MIN_DEPTH 500
 #define WATER_MAX_DEPTH (WATER_MIN_DEPTH + 400)
@@ -1073,6 +1076,7 @@ bool mapLoadFromWzMapData(std::shared_ptr<WzMap::MapData> loadedMap)
 
 	mapWidth = width;
 	mapHeight = height;
+	resetBuildableAreas();
 
 	// FIXME: the map preview code loads the map without setting the tileset
 	if (!tilesetDir)
@@ -1284,6 +1288,7 @@ bool mapShutdown()
 	mapDecals = nullptr;
 	psMapTiles = nullptr;
 	mapWidth = mapHeight = 0;
+	resetBuildableAreas();
 	numTile_names = 0;
 	Tile_names = nullptr;
 	if (tilesetDir)
@@ -115,6 +115,21 @@ size_t getNumGroundTypes();
 extern std::unique_ptr<uint8_t[]> psBlockMap[AUX_MAX];
 extern std::unique_ptr<uint8_t[]> psAuxMap[MAX_PLAYERS + AUX_MAX];	// yes, we waste one element... eyes wide open... makes API nicer
 
+/// Sectors of 8x8 tiles, for tracking which parts of the aux and blocking maps changed
+#define AUX_SECTOR_SHIFT	3
+#define AUX_SECTORS_X		(MAP_MAXWIDTH >> AUX_SECTOR_SHIFT)
+#define AUX_SECTORS_Y		(MAP_MAXHEIGHT >> AUX_SECTOR_SHIFT)
+
+/// Incremented whenever the aux or blocking bits of any tile change
+extern uint32_t auxMapGeneration;
+/// The value auxMapGeneration had when a tile in each sector last changed
+extern uint32_t auxSectorGeneration[AUX_SECTORS_X * AUX_SECTORS_Y];
+
+WZ_DECL_ALWAYS_INLINE static inline void auxMarkChanged(int x, int y)
+{
+	auxSectorGeneration[(x >> AUX_SECTOR_SHIFT) + (y >> AUX_SECTOR_SHIFT) * AUX_SECTORS_X] = ++auxMapGeneration;
+}
+
 /// Find aux bitfield for a given tile
 WZ_DECL_ALWAYS_INLINE static inline uint8_t auxTile(int x, int y, int player)
 {
@@ -160,6 +175,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAll(int x, int y, int state)
 {
 	int i;
 
+	auxMarkChanged(x, y);
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		psAuxMap[i][x + y * mapWidth] |= state;
@@ -171,6 +187,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAllied(int x, int y, int player,
 {
 	int i;
 
+	auxMarkChanged(x, y);
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (aiCheckAlliances(player, i))
@@ -185,6 +202,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetEnemy(int x, int y, int player, i
 {
 	int i;
 
+	auxMarkChanged(x, y);
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (!aiCheckAlliances(player, i))
@@ -205,6 +223,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 {
 	int i;
 
+	auxMarkChanged(x, y);
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		psAuxMap[i][x + y * mapWidth] &= ~state;
@@ -214,12 +233,14 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 /// Set blocking bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSetBlocking(int x, int y, int state)
 {
+	auxMarkChanged(x, y);
 	psBlockMap[0][x + y * mapWidth] |= state;
 }
 
 /// Clear blocking bits. Always set identically for all players. States not cleared are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxClearBlocking(int x, int y, int state)
 {
+	auxMarkChanged(x, y);
 	psBlockMap[0][x + y * mapWidth] &= ~state;
 }
 
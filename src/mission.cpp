@@ -266,6 +266,17 @@ bool missionLimboExpand()
 	return (mission.type == LEVEL_TYPE::LDS_EXPAND_LIMBO);
 }
 
+/// The current and mission object lists of player were replaced wholesale, so their type indices no longer apply
+static void invalidateMissionListIndices(unsigned player)
+{
+	invalidateObjectListIndex(apsDroidLists, player);
+	invalidateObjectListIndex(apsStructLists, player);
+	invalidateObjectListIndex(apsFeatureLists, player);
+	invalidateObjectListIndex(mission.apsDroidLists, player);
+	invalidateObjectListIndex(mission.apsStructLists, player);
+	invalidateObjectListIndex(mission.apsFeatureLists, player);
+}
+
 // mission initialisation game code
 void initMission()
 {
@@ -279,6 +290,7 @@ void initMission()
 		mission.apsFlagPosLists[inc].clear();
 		mission.apsExtractorLists[inc].clear();
 		apsLimboDroids[inc].clear();
+		invalidateMissionListIndices(inc);
 	}
 	mission.apsSensorList[0].clear();
 	mission.apsOilList[0].clear();
@@ -344,6 +356,7 @@ bool missionShutDown()
 			mission.apsStructLists[inc].clear();
 			apsFeatureLists[inc] = std::move(mission.apsFeatureLists[inc]);
 			mission.apsFeatureLists[inc].clear();
+			invalidateMissionListIndices(inc);
 			apsFlagPosLists[inc] = std::move(mission.apsFlagPosLists[inc]);
 			mission.apsFlagPosLists[inc].clear();
 			apsExtractorLists[inc] = std::move(mission.apsExtractorLists[inc]);
@@ -366,6 +379,7 @@ bool missionShutDown()
 			psAuxMap[i] = std::move(mission.psAuxMap[i]);
 		}
 		std::swap(mission.psGateways, gwGetGateways());
+		resetBuildableAreas();
 	}
 	keybindShutdown();
 	// sorry if this breaks something - but it looks like it's what should happen - John
@@ -788,6 +802,7 @@ static void saveMissionData()
 	mission.scrollMaxX = scrollMaxX;
 	mission.scrollMaxY = scrollMaxY;
 	std::swap(mission.psGateways, gwGetGateways());
+	resetBuildableAreas();
 	// save the selectedPlayer's LZ
 	mission.homeLZ_X = getLandingX(selectedPlayer);
 	mission.homeLZ_Y = getLandingY(selectedPlayer);
@@ -799,6 +814,7 @@ static void saveMissionData()
 		mission.apsFeatureLists[inc] = apsFeatureLists[inc];
 		mission.apsFlagPosLists[inc] = apsFlagPosLists[inc];
 		mission.apsExtractorLists[inc] = apsExtractorLists[inc];
+		invalidateMissionListIndices(inc);
 	}
 	mission.apsSensorList[0] = apsSensorList[0];
 	mission.apsOilList[0] = apsOilList[0];
@@ -861,6 +877,7 @@ void restoreMissionData()
 
 		apsFeatureLists[inc] = std::move(mission.apsFeatureLists[inc]);
 		mission.apsFeatureLists[inc].clear();
+		invalidateMissionListIndices(inc);
 
 		apsFlagPosLists[inc] = std::move(mission.apsFlagPosLists[inc]);
 		mission.apsFlagPosLists[inc].clear();
@@ -891,6 +908,7 @@ void restoreMissionData()
 	scrollMaxX = mission.scrollMaxX;
 	scrollMaxY = mission.scrollMaxY;
 	std::swap(mission.psGateways, gwGetGateways());
+	resetBuildableAreas();
 	//and clear the mission pointers
 	mission.psMapTiles	= nullptr;
 	mission.mapWidth	= 0;
@@ -936,6 +954,7 @@ void saveMissionLimboData()
 		return IterationResult::CONTINUE_ITERATION;
 	});
 	apsDroidLists[selectedPlayer].clear();
+	invalidateObjectListIndex(apsDroidLists, selectedPlayer);
 
 	// any selectedPlayer's factories/research need to be put on holdProduction/holdresearch
 	for (STRUCTURE* psStruct : apsStructLists[selectedPlayer])
@@ -1088,6 +1107,7 @@ void saveCampaignData()
 		// Reserve the droids for selected player for start of next campaign
 		mission.apsDroidLists[selectedPlayer] = std::move(apsDroidLists[selectedPlayer]);
 		apsDroidLists[selectedPlayer].clear();
+		invalidateMissionListIndices(selectedPlayer);
 		for (DROID* psDroid : mission.apsDroidLists[selectedPlayer])
 		{
 			//cam change add droid
@@ -1102,6 +1122,7 @@ void saveCampaignData()
 		/*now that every unit for the selected player has been moved into the
 		mission list - reverse it and fill the transporter with the first ten units*/
 		mission.apsDroidLists[selectedPlayer].reverse();
+		invalidateObjectListIndex(mission.apsDroidLists, selectedPlayer);
 
 		//find the *first* transporter
 		mutating_list_iterate(mission.apsDroidLists[selectedPlayer], [](DROID* psDroid)
@@ -1398,6 +1419,7 @@ void swapMissionPointers()
 	}
 	//swap gateway zones
 	std::swap(mission.psGateways, gwGetGateways());
+	resetBuildableAreas();
 	std::swap(scrollMinX, mission.scrollMinX);
 	std::swap(scrollMinY, mission.scrollMinY);
 	std::swap(scrollMaxX, mission.scrollMaxX);
@@ -1409,6 +1431,7 @@ void swapMissionPointers()
 		std::swap(apsFeatureLists[inc],   mission.apsFeatureLists[inc]);
 		std::swap(apsFlagPosLists[inc],   mission.apsFlagPosLists[inc]);
 		std::swap(apsExtractorLists[inc], mission.apsExtractorLists[inc]);
+		invalidateMissionListIndices(inc);
 	}
 	std::swap(apsSensorList[0], mission.apsSensorList[0]);
 	std::swap(apsOilList[0],    mission.apsOilList[0]);
@@ -2995,6 +3018,7 @@ void missionDestroyObjects()
 
 			//clear out the mission lists as well to make sure no Transporters exist
 			apsDroidLists[Player] = std::move(mission.apsDroidLists[Player]);
+			invalidateMissionListIndices(Player);
 
 			mutating_list_iterate(apsDroidLists[Player], [](DROID* psDroid)
 			{
@@ -3004,6 +3028,7 @@ void missionDestroyObjects()
 				return IterationResult::CONTINUE_ITERATION;
 			});
 			mission.apsDroidLists[Player].clear();
+			invalidateObjectListIndex(mission.apsDroidLists, Player);
 
 			mutating_list_iterate(apsStructLists[Player], [](STRUCTURE* s)
 			{
@@ -87,6 +87,7 @@
 #include "warzoneconfig.h"
 #include "stdinreader.h"
 #include "spectatorwidgets.h"
+#include "loop.h"
 #include "challenge.h"
 #include "multilobbycommands.h"
 #include "hci/teamstrategy.h"
@@ -1553,6 +1554,11 @@ bool recvMessage()
 					// ignore
 					break;
 				}
+				if (replay_crunch_enabled())
+				{
+					replayCrunchFinish();
+					break;
+				}
 				addConsoleMessage(_("REPLAY HAS ENDED"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
 				addConsoleMessage(_("(Press ESC to quit.)"), CENTRE_JUSTIFY, SYSTEM_MESSAGE, false, MAX_CONSOLE_MESSAGE_DURATION);
 				break;
@@ -46,6 +46,8 @@
 #include "wzcrashhandlingproviders.h"
 
 #include <algorithm>
+#include <unordered_map>
+#include <vector>
 
 // the initial value for the object ID
 #define OBJ_ID_INIT 20000
@@ -76,6 +78,242 @@ static void objListIntegCheck();
 #endif
 
 
+/* Indices of the object lists by type (and stats, for structures and features), so that scripts can enumerate
+ * the objects of one type without walking all objects. An index is built for a player's list when it is first
+ * queried, and is then kept up to date by the functions below that add and remove objects. Lists are also
+ * cleared, swapped with the mission lists and reversed directly; the index notices this by comparing the list
+ * with how it last saw it, and is then rebuilt on the next query. */
+using ObjectIndexKey = intptr_t;
+
+struct ObjectIndexKeys
+{
+	ObjectIndexKey key[2];
+	size_t count;
+};
+
+static inline ObjectIndexKeys objectIndexKeys(const DROID *psDroid)
+{
+	return {{static_cast<ObjectIndexKey>(psDroid->droidType), 0}, 1};
+}
+
+static inline ObjectIndexKeys objectIndexKeys(const STRUCTURE *psStruct)
+{
+	// type enum values and stats pointers don't overlap
+	return {{static_cast<ObjectIndexKey>(psStruct->pStructureType->type), reinterpret_cast<ObjectIndexKey>(psStruct->pStructureType)}, 2};
+}
+
+static inline ObjectIndexKeys objectIndexKeys(const FEATURE *psFeature)
+{
+	return {{reinterpret_cast<ObjectIndexKey>(psFeature->psStats), 0}, 1};
+}
+
+template <typename OBJECT>
+struct ObjectListIndex
+{
+	/// Objects by key, each in the order they were added. Sequence numbers grow towards the front of the list.
+	std::unordered_map<ObjectIndexKey, std::vector<std::pair<uint64_t, OBJECT *>>> buckets;
+	uint64_t nextSequence = 0;
+	// the list as last seen
+	size_t size = 0;
+	const void *front = nullptr;
+	const void *back = nullptr;
+
+	bool matches(const std::list<OBJECT *> &list) const
+	{
+		return list.size() == size && (list.empty() || (&list.front() == front && &list.back() == back));
+	}
+
+	void remember(const std::list<OBJECT *> &list)
+	{
+		size = list.size();
+		front = (list.empty()) ? nullptr : &list.front();
+		back = (list.empty()) ? nullptr : &list.back();
+	}
+
+	void add(OBJECT *object)
+	{
+		ObjectIndexKeys keys = objectIndexKeys(object);
+		for (size_t i = 0; i < keys.count; ++i)
+		{
+			buckets[keys.key[i]].emplace_back(nextSequence, object);
+		}
+		++nextSequence;
+	}
+
+	bool remove(const OBJECT *object)
+	{
+		ObjectIndexKeys keys = objectIndexKeys(object);
+		for (size_t i = 0; i < keys.count; ++i)
+		{
+			auto bucket = buckets.find(keys.key[i]);
+			if (bucket == buckets.end())
+			{
+				return false;
+			}
+			auto &entries = bucket->second;
+			auto it = std::find_if(entries.begin(), entries.end(), [object](const std::pair<uint64_t, OBJECT *> &entry) { return entry.second == object; });
+			if (it == entries.end())
+			{
+				return false;
+			}
+			entries.erase(it);
+		}
+		return true;
+	}
+
+	void rebuild(const std::list<OBJECT *> &list)
+	{
+		buckets.clear();
+		nextSequence = 0;
+		for (auto it = list.rbegin(); it != list.rend(); ++it)
+		{
+			add(*it);
+		}
+		remember(list);
+	}
+};
+
+template <typename OBJECT>
+using ObjectListIndices = std::unordered_map<const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> *, std::array<std::unique_ptr<ObjectListIndex<OBJECT>>, MAX_PLAYERS>>;
+
+template <typename OBJECT>
+static ObjectListIndices<OBJECT> &objectListIndices()
+{
+	static ObjectListIndices<OBJECT> indices;
+	return indices;
+}
+
+/// The index of a player's list, if there is one that is up to date (and thus can be updated along with the list)
+template <typename OBJECT>
+static ObjectListIndex<OBJECT> *currentObjectListIndex(const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> &list, unsigned player)
+{
+	auto &indices = objectListIndices<OBJECT>();
+	auto it = indices.find(&list);
+	if (it == indices.end() || player >= MAX_PLAYERS || !it->second[player])
+	{
+		return nullptr;
+	}
+	if (!it->second[player]->matches(list[player]))
+	{
+		ASSERT(false, "Object list of player %u changed without invalidateObjectListIndex()", player);
+		it->second[player].reset(); // changed behind our back
+		return nullptr;
+	}
+	return it->second[player].get();
+}
+
+template <typename OBJECT>
+static void indexAddedObject(ObjectListIndex<OBJECT> *index, const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> &list, OBJECT *object, unsigned player)
+{
+	if (index)
+	{
+		index->add(object);
+		index->remember(list[player]);
+	}
+}
+
+template <typename OBJECT>
+static void indexRemovedObject(ObjectListIndex<OBJECT> *index, const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> &list, OBJECT *object, unsigned player)
+{
+	if (index)
+	{
+		if (index->remove(object))
+		{
+			index->remember(list[player]);
+		}
+		else
+		{
+			objectListIndices<OBJECT>()[&list][player].reset(); // should not happen - start over
+		}
+	}
+}
+
+template <typename OBJECT>
+static void invalidateObjectListIndexImpl(const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> &list, unsigned player)
+{
+	ASSERT_OR_RETURN(, player < MAX_PLAYERS, "Invalid player %u", player);
+	auto &indices = objectListIndices<OBJECT>();
+	auto it = indices.find(&list);
+	if (it != indices.end())
+	{
+		it->second[player].reset();
+	}
+}
+
+/// Objects of a player's list with any of the given keys, in list order
+template <typename OBJECT>
+static std::vector<OBJECT *> objectsWithKeys(const PerPlayerObjectLists<OBJECT, MAX_PLAYERS> &list, unsigned player, std::initializer_list<ObjectIndexKey> keys)
+{
+	std::vector<OBJECT *> result;
+	ASSERT_OR_RETURN(result, player < MAX_PLAYERS, "Invalid player %u", player);
+	ObjectListIndex<OBJECT> *index = currentObjectListIndex(list, player);
+	if (!index)
+	{
+		auto &slot = objectListIndices<OBJECT>()[&list][player];
+		slot = std::make_unique<ObjectListIndex<OBJECT>>();
+		slot->rebuild(list[player]);
+		index = slot.get();
+	}
+	std::vector<std::pair<uint64_t, OBJECT *>> entries;
+	for (ObjectIndexKey key : keys)
+	{
+		auto bucket = index->buckets.find(key);
+		if (bucket != index->buckets.end())
+		{
+			entries.insert(entries.end(), bucket->second.begin(), bucket->second.end());
+		}
+	}
+	if (keys.size() > 1)
+	{
+		std::sort(entries.begin(), entries.end(), [](const std::pair<uint64_t, OBJECT *> &a, const std::pair<uint64_t, OBJECT *> &b) { return a.first < b.first; });
+	}
+	result.reserve(entries.size());
+	for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+	{
+		result.push_back(it->second);
+	}
+	return result;
+}
+
+std::vector<DROID *> objmemDroidsOfType(const PerPlayerDroidLists &list, unsigned player, DROID_TYPE type, DROID_TYPE altType)
+{
+	if (altType == type)
+	{
+		return objectsWithKeys(list, player, {static_cast<ObjectIndexKey>(type)});
+	}
+	return objectsWithKeys(list, player, {static_cast<ObjectIndexKey>(type), static_cast<ObjectIndexKey>(altType)});
+}
+
+std::vector<STRUCTURE *> objmemStructuresOfType(const PerPlayerStructureLists &list, unsigned player, STRUCTURE_TYPE type)
+{
+	return objectsWithKeys(list, player, {static_cast<ObjectIndexKey>(type)});
+}
+
+std::vector<STRUCTURE *> objmemStructuresOfStats(const PerPlayerStructureLists &list, unsigned player, const STRUCTURE_STATS *psStats)
+{
+	return objectsWithKeys(list, player, {reinterpret_cast<ObjectIndexKey>(psStats)});
+}
+
+std::vector<FEATURE *> objmemFeaturesOfStats(const PerPlayerFeatureLists &list, const FEATURE_STATS *psStats)
+{
+	return objectsWithKeys(list, 0, {reinterpret_cast<ObjectIndexKey>(psStats)});
+}
+
+void invalidateObjectListIndex(const PerPlayerDroidLists &list, unsigned player)
+{
+	invalidateObjectListIndexImpl(list, player);
+}
+
+void invalidateObjectListIndex(const PerPlayerStructureLists &list, unsigned player)
+{
+	invalidateObjectListIndexImpl(list, player);
+}
+
+void invalidateObjectListIndex(const PerPlayerFeatureLists &list, unsigned player)
+{
+	invalidateObjectListIndexImpl(list, player);
+}
+
 /* Initialise the object heaps */
 bool objmemInitialise()
 {
@@ -103,6 +341,9 @@ void objmemShutdown()
 	objMemShutdownContainerImpl(GlobalDroidContainer());
 	objMemShutdownContainerImpl(GlobalStructContainer());
 	objMemShutdownContainerImpl(GlobalFeatureContainer());
+	objectListIndices<DROID>().clear();
+	objectListIndices<STRUCTURE>().clear();
+	objectListIndices<FEATURE>().clear();
 }
 
 static const char* objTypeToStr(OBJECT_TYPE type)
@@ -368,8 +609,10 @@ static inline void addObjectToList(PerPlayerObjectLists<OBJECT, MAX_PLAYERS>& li
 {
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 
+	ObjectListIndex<OBJECT> *index = currentObjectListIndex(list, player);
 	// Prepend the object to the top of the list
 	list[player].emplace_front(object);
+	indexAddedObject(index, list, object, player);
 }
 
 /* Add the object to its list
@@ -401,7 +644,9 @@ static inline void destroyObject(PerPlayerObjectLists<OBJECT, MAX_PLAYERS>& list
 
 	if (it != list[object->player].end())
 	{
+		ObjectListIndex<OBJECT> *index = currentObjectListIndex(list, object->player);
 		list[object->player].erase(it);
+		indexRemovedObject(index, list, object, object->player);
 
 		// Prepend the object to the destruction list
 		psDestroyedObj.emplace_front((BASE_OBJECT*)object);
@@ -424,7 +669,9 @@ static inline void removeObjectFromList(PerPlayerObjectLists<OBJECT, MAX_PLAYERS
 
 	auto it = std::find(list[player].begin(), list[player].end(), object);
 	ASSERT_OR_RETURN(, it != list[player].end(), "Object %p not found in list", static_cast<void*>(object));
+	ObjectListIndex<OBJECT> *index = currentObjectListIndex(list, player);
 	list[player].erase(it);
+	indexRemovedObject(index, list, object, player);
 }
 
 /* Remove an object from the relevant function list. An object can only be in one function list at a time!
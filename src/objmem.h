@@ -28,6 +28,7 @@
 
 #include <array>
 #include <list>
+#include <vector>
 
 /* The lists of objects allocated */
 template <typename ObjectType, unsigned PlayerCount>
@@ -78,6 +79,20 @@ void objmemUpdate();
  * Hopefully by this time, no pointers still refer to it! */
 bool objmemDestroy(BASE_OBJECT* psObj, bool checkRefs);
 
+/// Objects of a player's list with the given droid type (or altType), in list order
+std::vector<DROID *> objmemDroidsOfType(const PerPlayerDroidLists &list, unsigned player, DROID_TYPE type, DROID_TYPE altType);
+/// Structures of a player's list with the given type, in list order
+std::vector<STRUCTURE *> objmemStructuresOfType(const PerPlayerStructureLists &list, unsigned player, STRUCTURE_TYPE type);
+/// Structures of a player's list with the given stats, in list order
+std::vector<STRUCTURE *> objmemStructuresOfStats(const PerPlayerStructureLists &list, unsigned player, const STRUCTURE_STATS *psStats);
+/// Features of the list with the given stats, in list order
+std::vector<FEATURE *> objmemFeaturesOfStats(const PerPlayerFeatureLists &list, const FEATURE_STATS *psStats);
+/// Drops the index behind the queries above for a player's list. Must be called whenever the list is changed
+/// other than by adding or removing single objects through objmem (assigned, moved, swapped, reversed or cleared)
+void invalidateObjectListIndex(const PerPlayerDroidLists &list, unsigned player);
+void invalidateObjectListIndex(const PerPlayerStructureLists &list, unsigned player);
+void invalidateObjectListIndex(const PerPlayerFeatureLists &list, unsigned player);
+
 /// Generates a new, (hopefully) unique object id.
 uint32_t generateNewObjectId();
 /// Generates a new, (hopefully) unique object id, which all clients agree on.
@@ -64,6 +64,7 @@
 #include "gamehistorylogger.h"
 #include "campaigninfo.h"
 #include "hci/quickchat.h"
+#include "scriptstatebinary.h"
 
 #include <set>
 #include <memory>
@@ -72,6 +73,7 @@
 #include <sstream>
 #include <iomanip>
 #include <queue>
+#include <algorithm>
 #include <limits>
 
 #include "wzscriptdebug.h"
@@ -234,6 +236,7 @@ uniqueTimerID scripting_engine::setTimer(wzapi::scripting_instance *caller, cons
 	node->timerID = newTimerID;
 	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
 	timerIDMap[newTimerID] = inserted_iter;
+	scheduleTimer(*inserted_iter, nextTimerSequence++);
 	return newTimerID;
 }
 
@@ -243,6 +246,21 @@ void scripting_engine::addTimerNode(std::shared_ptr<scripting_engine::timerNode>
 	ASSERT(timerIDMap.count(node->timerID) == 0, "Duplicate timerID found: %s", WzString::number(node->timerID).toUtf8().c_str());
 	auto inserted_iter = timers.emplace(timers.end(), std::move(node));
 	timerIDMap[(*inserted_iter)->timerID] = inserted_iter;
+	const auto &inserted = *inserted_iter;
+	if (inserted->type == TIMER_ONESHOT_DONE)
+	{
+		finishedOneShotTimers.push_back(inserted->timerID);
+	}
+	else if (inserted->type != TIMER_REMOVED)
+	{
+		scheduleTimer(inserted, nextTimerSequence++);
+	}
+}
+
+void scripting_engine::scheduleTimer(const std::shared_ptr<timerNode>& node, uint64_t sequence)
+{
+	timerQueue.push_back(timerQueueEntry{node->frameTime, sequence, node});
+	std::push_heap(timerQueue.begin(), timerQueue.end(), timerQueueEntryLater());
 }
 
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
@@ -270,13 +288,15 @@ typedef struct monitor_bin
 	int calls;
 	int overMaxTimeCalls;
 	int overHalfMaxTimeCalls;
+	int overTickShareCalls;
 	uint64_t time;
-	monitor_bin() : worst(0),  worstGameTime(0), calls(0), overMaxTimeCalls(0), overHalfMaxTimeCalls(0), time(0) {}
+	monitor_bin() : worst(0),  worstGameTime(0), calls(0), overMaxTimeCalls(0), overHalfMaxTimeCalls(0), overTickShareCalls(0), time(0) {}
 } MONITOR_BIN;
 typedef std::unordered_map<std::string, MONITOR_BIN> MONITOR;
 static std::unordered_map<wzapi::scripting_instance *, MONITOR *> monitors;
 
 static bool globalDialog = false;
+static bool scriptProfiling = false;
 
 bool bInTutorial = false;
 
@@ -379,6 +399,7 @@ void scriptRemoveObject(const BASE_OBJECT *psObj)
 	{
 		return (node.baseobj == psObj->id);
 	});
+	scriptRemoveObject_QuickJS(psObj);
 	scripting_engine::instance().groupRemoveObject(psObj);
 }
 
@@ -421,7 +442,7 @@ bool scripting_engine::shutdownScripts()
 		MONITOR *monitor = monitors.at(instance);
 		WzString scriptName = WzString::fromUtf8(instance->scriptName());
 		instance->dumpScriptLog("=== PERFORMANCE DATA ===\n");
-		instance->dumpScriptLog("    calls | avg (usec) | worst (usec) | worst call at | >=limit | >=limit/2 | function\n");
+		instance->dumpScriptLog("    calls | avg (usec) | worst (usec) | worst call at | >=limit | >=limit/2 | >=share | function\n");
 		for (MONITOR::const_iterator iter = monitor->begin(); iter != monitor->end(); ++iter)
 		{
 			const std::string &function = iter->first;
@@ -433,6 +454,7 @@ bool scripting_engine::shutdownScripts()
 			info << std::right << std::setw(13) << m.worstGameTime << " | ";
 			info << std::right << std::setw(7) << m.overMaxTimeCalls << " | ";
 			info << std::right << std::setw(9) << m.overHalfMaxTimeCalls << " | ";
+			info << std::right << std::setw(7) << m.overTickShareCalls << " | ";
 			info << function << "\n";
 			instance->dumpScriptLog(info.str());
 		}
@@ -443,6 +465,9 @@ bool scripting_engine::shutdownScripts()
 	timers.clear();
 	lastTimerID = 0;
 	timerIDMap.clear();
+	timerQueue.clear();
+	nextTimerSequence = 0;
+	finishedOneShotTimers.clear();
 	monitors.clear();
 	for (auto& script : scripts)
 	{
@@ -475,36 +500,102 @@ bool scripting_engine::updateScripts()
 		instance->updateGameTime(gameTime);
 	}
 	// Weed out dead timers
-	removeTimersIf([](const timerNode& node)
+	for (uniqueTimerID timerID : finishedOneShotTimers)
 	{
-		return (node.type == TIMER_ONESHOT_DONE);
-	});
+		auto it = timerIDMap.find(timerID);
+		if (it != timerIDMap.end() && (*it->second)->type == TIMER_ONESHOT_DONE)
+		{
+			removeTimer(timerID);
+		}
+	}
+	finishedOneShotTimers.clear();
+	// Drop entries of removed timers if they make up most of the schedule
+	if (timerQueue.size() > 2 * timers.size() + 64)
+	{
+		timerQueue.erase(std::remove_if(timerQueue.begin(), timerQueue.end(), [](const timerQueueEntry &entry) {
+			auto node = entry.node.lock();
+			return !node || node->type == TIMER_REMOVED;
+		}), timerQueue.end());
+		std::make_heap(timerQueue.begin(), timerQueue.end(), timerQueueEntryLater());
+	}
 	// Check for timers, and run them if applicable.
-	// TODO - load balancing
-	std::vector<std::shared_ptr<timerNode>> runlist; // make a new list here, since we might trample all over the timer list during execution
-	for (auto &node : timers)
+	std::vector<std::pair<uint64_t, std::shared_ptr<timerNode>>> runlist; // make a new list here, since we might trample all over the timer list during execution
+	while (!timerQueue.empty() && timerQueue.front().frameTime <= gameTime)
 	{
-		if (node->frameTime <= gameTime)
+		std::pop_heap(timerQueue.begin(), timerQueue.end(), timerQueueEntryLater());
+		timerQueueEntry entry = std::move(timerQueue.back());
+		timerQueue.pop_back();
+		auto node = entry.node.lock();
+		if (!node || node->type == TIMER_REMOVED || node->type == TIMER_ONESHOT_DONE || node->frameTime != entry.frameTime)
 		{
-			node->frameTime = node->ms + gameTime;	// update for next invokation
-			if (node->type == TIMER_ONESHOT_READY)
-			{
-				node->type = TIMER_ONESHOT_DONE; // unless there is none
-			}
-			node->calls++;
-			runlist.push_back(node);
+			continue; // stale entry
+		}
+		node->frameTime = node->ms + gameTime;	// update for next invokation
+		if (node->type == TIMER_ONESHOT_READY)
+		{
+			node->type = TIMER_ONESHOT_DONE; // unless there is none
+		}
+		else
+		{
+			scheduleTimer(node, entry.sequence);
+		}
+		node->calls++;
+		runlist.emplace_back(entry.sequence, std::move(node));
+	}
+	// Run due timers in creation order, independent of how late each one is
+	std::sort(runlist.begin(), runlist.end(), [](const std::pair<uint64_t, std::shared_ptr<timerNode>> &a, const std::pair<uint64_t, std::shared_ptr<timerNode>> &b) {
+		return a.first < b.first;
+	});
+	for (const auto &item : runlist)
+	{
+		if (item.second->type == TIMER_ONESHOT_DONE)
+		{
+			finishedOneShotTimers.push_back(item.second->timerID);
 		}
 	}
 
-	for (auto &node : runlist)
+	// Each instance that has timers due gets an equal share of the per-tick budget; note the timer functions that exceed it
+	std::unordered_map<wzapi::scripting_instance *, int> tickUsage;
+	for (const auto &item : runlist)
+	{
+		tickUsage[item.second->instance] = 0;
+	}
+	const int tickShare = (tickUsage.empty()) ? MAX_US : MAX_US / static_cast<int>(tickUsage.size());
+	using microDuration = std::chrono::duration<uint64_t, std::micro>;
+
+	for (auto &item : runlist)
 	{
+		auto &node = item.second;
 		// IMPORTANT: A queued function can delete a timer that is in the runlist!
 		// So we must verify that the node is not one of the deleted ones.
 		if (node->type == TIMER_REMOVED)
 		{
 			continue; // skip
 		}
+		auto time_begin = std::chrono::steady_clock::now();
 		node->function(node->timerID, IdToObject(node->baseobjtype, node->baseobj, node->player), node->additionalTimerFuncParam.get());
+		int ticks = static_cast<int>(std::chrono::duration_cast<microDuration>(std::chrono::steady_clock::now() - time_begin).count());
+		tickUsage[node->instance] += ticks;
+		if (ticks > tickShare)
+		{
+			auto monitor = monitors.find(node->instance);
+			if (monitor != monitors.end())
+			{
+				auto bin = monitor->second->find(node->timerName);
+				if (bin != monitor->second->end())
+				{
+					bin->second.overTickShareCalls++;
+				}
+			}
+		}
+	}
+
+	for (const auto &usage : tickUsage)
+	{
+		if (usage.second > tickShare)
+		{
+			debug(LOG_SCRIPT, "%s: timers took %dus at time %u, exceeding their %dus share of the tick", usage.first->scriptName().c_str(), usage.second, gameTime, tickShare);
+		}
 	}
 
 	return true;
@@ -677,6 +768,7 @@ wzapi::scripting_instance* scripting_engine::loadPlayerScript(const WzString& pa
 
 	// Register script
 	scripts.push_back(pNewInstance);
+	pNewInstance->setProfilingEnabled(scriptProfiling);
 
 	MONITOR *monitor = new MONITOR;
 	monitors[pNewInstance] = monitor;
@@ -695,19 +787,38 @@ bool saveScriptStates(const char *filename)
 	return scripting_engine::instance().saveScriptStates(filename);
 }
 
+/// The script globals are written to a binary file next to the script state file, see scriptstatebinary.h
+static std::string scriptGlobalsFilename(const char *filename)
+{
+	std::string result = filename;
+	const std::string extension = ".json";
+	if (result.size() >= extension.size() && result.compare(result.size() - extension.size(), extension.size(), extension) == 0)
+	{
+		result.resize(result.size() - extension.size());
+	}
+	return result + ".bin";
+}
+
 bool scripting_engine::saveScriptStates(const char *filename)
 {
 	WzConfig ini(filename, WzConfig::ReadAndWrite);
+	ScriptStateWriter globalsWriter;
 	for (int i = 0; i < scripts.size(); ++i)
 	{
 		wzapi::scripting_instance* instance = scripts.at(i);
 
+		// the globals go into the binary file, as value number i - without building json for them first
+		if (!instance->saveScriptGlobalsBinary(globalsWriter))
+		{
+			debug(LOG_ERROR, "Failed to save script globals for %s", instance->scriptName().c_str());
+			globalsWriter.writeJson(nlohmann::json::object()); // keep the numbering
+		}
+		// we have to save 'scriptName' and 'me' explicitly
 		nlohmann::json globalsResult = nlohmann::json::object();
-		instance->saveScriptGlobals(globalsResult);
-		// 'scriptName' and 'me' should be saved implicitly by the backend's saveScriptGlobals
-		ASSERT(globalsResult.contains("me"), "Missing required global \"me\"");
-		ASSERT(globalsResult.contains("scriptName"), "Missing required global \"scriptName\"");
-		ini.setValue("globals_" + WzString::number(i), globalsResult);
+		globalsResult["me"] = instance->player();
+		globalsResult["scriptName"] = instance->scriptName();
+		globalsResult["binaryGlobals"] = i;
+		ini.setValue("globals_" + WzString::number(i), std::move(globalsResult));
 
 		// we have to save 'scriptName' and 'me' explicitly
 		nlohmann::json groupsResult = nlohmann::json::object();
@@ -739,6 +850,13 @@ bool scripting_engine::saveScriptStates(const char *filename)
 		ini.setValue("triggers_" + WzString::number(timerIdx), std::move(nodeInfo));
 		++timerIdx;
 	}
+	const std::string globalsFilename = scriptGlobalsFilename(filename);
+	const std::vector<uint8_t> &globalsData = globalsWriter.data();
+	if (!saveFile(globalsFilename.c_str(), reinterpret_cast<const char *>(globalsData.data()), static_cast<UDWORD>(globalsData.size())))
+	{
+		debug(LOG_ERROR, "Failed to save script globals to %s", globalsFilename.c_str());
+		return false;
+	}
 	return true;
 }
 
@@ -768,6 +886,7 @@ bool scripting_engine::loadScriptStates(const char *filename)
 {
 	uniqueTimerID maxRestoredTimerID = 0;
 	WzConfig ini(filename, WzConfig::ReadOnly);
+	optional<std::vector<nlohmann::json>> binaryGlobals; // loaded when first needed (older saves keep the globals in the json)
 	std::vector<WzString> list = ini.childGroups();
 	debug(LOG_SAVE, "Loading script states for %zu script contexts", scripts.size());
 	for (size_t i = 0; i < list.size(); ++i)
@@ -844,7 +963,33 @@ bool scripting_engine::loadScriptStates(const char *filename)
 		}
 		else if (instance && list[i].startsWith("globals_"))
 		{
-			nlohmann::json result = ini.currentJsonValue();
+			nlohmann::json result;
+			if (ini.contains("binaryGlobals"))
+			{
+				if (!binaryGlobals.has_value())
+				{
+					binaryGlobals = std::vector<nlohmann::json>();
+					const std::string globalsFilename = scriptGlobalsFilename(filename);
+					std::vector<char> globalsData;
+					if (!loadFileToBufferVector(globalsFilename.c_str(), globalsData, false, false)
+						|| !readScriptStateBlocks(reinterpret_cast<const uint8_t *>(globalsData.data()), globalsData.size(), binaryGlobals.value()))
+					{
+						debug(LOG_ERROR, "Failed to load script globals from %s", globalsFilename.c_str());
+					}
+				}
+				size_t index = static_cast<size_t>(ini.value("binaryGlobals").toInt());
+				if (index >= binaryGlobals.value().size())
+				{
+					ASSERT(false, "Missing saved script globals for player %d, script %s", player, scriptName.toUtf8().c_str());
+					ini.endGroup();
+					continue;
+				}
+				result = std::move(binaryGlobals.value()[index]);
+			}
+			else
+			{
+				result = ini.currentJsonValue();
+			}
 			debug(LOG_SAVE, "Loading script globals for player %d, script %s -- found %zu values",
 				  instance->player(), instance->scriptName().c_str(), result.size());
 			// filter out "scriptName" and "me" variables
@@ -937,6 +1082,109 @@ void jsShowDebug()
 	jsDebugCreate(std::make_shared<make_shared_enabler>(), jsHandleDebugClosed, isSpectator);
 }
 
+void jsSetProfiling(bool enabled)
+{
+	scriptProfiling = enabled;
+	for (auto *instance : scripts)
+	{
+		instance->setProfilingEnabled(enabled);
+	}
+}
+
+bool jsProfilingEnabled()
+{
+	return scriptProfiling;
+}
+
+void jsResetProfile()
+{
+	for (auto *instance : scripts)
+	{
+		instance->debugResetProfileSamples();
+	}
+}
+
+static std::string profileScriptName(const wzapi::scripting_instance *instance)
+{
+	std::string result = instance->scriptName() + "." + std::to_string(instance->player());
+	std::replace(result.begin(), result.end(), ';', ':');
+	std::replace(result.begin(), result.end(), ' ', '_');
+	return result;
+}
+
+std::string jsProfileFoldedStacks()
+{
+	std::vector<std::string> lines;
+	for (const auto *instance : scripts)
+	{
+		const std::string script = profileScriptName(instance);
+		for (const auto &sample : instance->debugGetProfileSamples())
+		{
+			lines.push_back(script + ";" + sample.first + " " + std::to_string(sample.second) + "\n");
+		}
+	}
+	std::sort(lines.begin(), lines.end());
+	std::string result;
+	for (const auto &line : lines)
+	{
+		result += line;
+	}
+	return result;
+}
+
+std::string jsSaveProfile()
+{
+	std::string filename = "logs/scriptprofile-" + std::to_string(gameTime) + ".folded";
+	std::string data = jsProfileFoldedStacks();
+	if (!saveFile(filename.c_str(), data.c_str(), data.size()))
+	{
+		return std::string();
+	}
+	return filename;
+}
+
+std::vector<ScriptProfileEntry> jsProfileSummary()
+{
+	std::vector<ScriptProfileEntry> result;
+	for (const auto *instance : scripts)
+	{
+		const std::string script = profileScriptName(instance);
+		std::unordered_map<std::string, ScriptProfileEntry> functions;
+		for (const auto &sample : instance->debugGetProfileSamples())
+		{
+			std::set<std::string> seen; // count recursive functions once per stack
+			size_t begin = 0;
+			while (begin <= sample.first.size())
+			{
+				size_t end = sample.first.find(';', begin);
+				bool leaf = (end == std::string::npos);
+				std::string function = sample.first.substr(begin, (leaf) ? std::string::npos : end - begin);
+				ScriptProfileEntry &entry = functions[function];
+				if (seen.insert(function).second)
+				{
+					entry.totalTime += sample.second;
+				}
+				if (leaf)
+				{
+					entry.selfTime += sample.second;
+					break;
+				}
+				begin = end + 1;
+			}
+		}
+		for (auto &it : functions)
+		{
+			it.second.script = script;
+			it.second.function = it.first;
+			result.push_back(std::move(it.second));
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const ScriptProfileEntry &a, const ScriptProfileEntry &b) {
+		return (a.selfTime != b.selfTime) ? a.selfTime > b.selfTime : a.totalTime > b.totalTime;
+	});
+	return result;
+}
+
 // ----------------------------------------------------------------------------------------
 // Events
 
@@ -123,6 +123,26 @@ void jsShowDebug();
 /// Choose a specific autogame AI
 void jsAutogameSpecific(const WzString &name, int player, AIDifficulty difficulty);
 
+/// Start or stop sampling which script functions the time is spent in
+void jsSetProfiling(bool enabled);
+bool jsProfilingEnabled();
+/// Discard the profile samples of all scripts
+void jsResetProfile();
+/// Profile samples of all scripts as folded stacks ("script;outermost;...;innermost microseconds" per line, as read by flamegraph tools)
+std::string jsProfileFoldedStacks();
+/// Write jsProfileFoldedStacks() to a file in the logs directory, and return its path (empty on failure)
+std::string jsSaveProfile();
+
+struct ScriptProfileEntry
+{
+	std::string script;
+	std::string function;
+	uint64_t selfTime = 0;  ///< Microseconds spent in the function itself
+	uint64_t totalTime = 0; ///< Microseconds spent in the function and everything it called (for timers and events, the time of the whole call)
+};
+/// Profile samples of all scripts aggregated per function, most self time first
+std::vector<ScriptProfileEntry> jsProfileSummary();
+
 // ----------------------------------------------
 // Event functions
 
@@ -289,12 +309,32 @@ private:
 	typedef std::map<wzapi::scripting_instance *, GROUPMAP *> ENGINEMAP;
 	ENGINEMAP groups;
 
-	/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-	/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-	/// host, we do not need to worry about each peer simulating the world differently.
+	/// List of timer events for scripts, in creation order (which is also the order in which due timers are run).
+	/// Since scripts run on the host, we do not need to worry about each peer simulating the world differently.
 	std::list<std::shared_ptr<timerNode>> timers;
 	uniqueTimerID lastTimerID = 0;
 	std::unordered_map<uniqueTimerID, std::list<std::shared_ptr<timerNode>>::iterator> timerIDMap; // a map from uniqueTimerID -> entry in the timers list
+
+	/// Entry in the timer schedule. `sequence` is the timer's position in creation order, and is kept when a repeating
+	/// timer is rescheduled, so timers due at the same time (or in the same tick) run in the same order as in `timers`.
+	struct timerQueueEntry
+	{
+		int frameTime;
+		uint64_t sequence;
+		std::weak_ptr<timerNode> node;
+	};
+	struct timerQueueEntryLater
+	{
+		bool operator()(const timerQueueEntry &a, const timerQueueEntry &b) const
+		{
+			return (a.frameTime != b.frameTime) ? (a.frameTime > b.frameTime) : (a.sequence > b.sequence);
+		}
+	};
+	/// Min-heap of pending timers keyed by frameTime. Removed timers are dropped lazily, when they reach the top.
+	std::vector<timerQueueEntry> timerQueue;
+	uint64_t nextTimerSequence = 0;
+	/// One-shot timers that have fired, and are removed at the start of the next update
+	std::vector<uniqueTimerID> finishedOneShotTimers;
 private:
 	scripting_engine() { }
 public:
@@ -373,6 +413,7 @@ private:
 	uniqueTimerID getNextAvailableTimerID();
 	// internal-only function that adds a Timer node (used for restoring saved games)
 	void addTimerNode(std::shared_ptr<timerNode>&& node);
+	void scheduleTimer(const std::shared_ptr<timerNode>& node, uint64_t sequence);
 
 // MARK: triggering events (from wz game code)
 public:
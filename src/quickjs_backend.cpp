@@ -74,12 +74,21 @@
 #include "qtscript.h"
 #include "featuredef.h"
 #include "data.h"
+#include "version.h"
+#include "scriptstatebinary.h"
 
 
 #include <unordered_set>
 #include "lib/framework/file.h"
+#include "lib/framework/crc.h"
+#include "lib/framework/physfs_ext.h"
 #include <unordered_map>
+#include <array>
 #include <limits>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <chrono>
 
 #if !defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8
 #pragma GCC diagnostic push
@@ -139,6 +148,20 @@ static inline JSCFunctionListEntry QJS_CGETSET_DEF(const char *name, JSCFunction
 	entry.u.getset.set.setter = fsetter;
 	return entry;
 }
+// #define JS_CGETSET_MAGIC_DEF(name, fgetter, fsetter, magic) { name, JS_PROP_CONFIGURABLE, JS_DEF_CGETSET_MAGIC, magic, .u = { .getset = { .get = { .getter_magic = fgetter }, .set = { .setter_magic = fsetter } } } }
+typedef JSValue JSCFunctionGetterMagic(JSContext *ctx, JSValueConst this_val, int magic);
+typedef JSValue JSCFunctionSetterMagic(JSContext *ctx, JSValueConst this_val, JSValueConst val, int magic);
+static inline JSCFunctionListEntry QJS_CGETSET_MAGIC_DEF(const char *name, JSCFunctionGetterMagic *fgetter, JSCFunctionSetterMagic *fsetter, int16_t magic, uint8_t prop_flags = JS_PROP_CONFIGURABLE)
+{
+	JSCFunctionListEntry entry;
+	entry.name = name;
+	entry.prop_flags = prop_flags;
+	entry.def_type = JS_DEF_CGETSET_MAGIC;
+	entry.magic = magic;
+	entry.u.getset.get.getter_magic = fgetter;
+	entry.u.getset.set.setter_magic = fsetter;
+	return entry;
+}
 
 struct JSToJsonContext
 {
@@ -164,6 +187,8 @@ struct JSToJsonContext
 
 // NOTE: May throw if there is a circular reference!
 nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value); // forward-declare
+// Writes what wz_qjs_to_json() would return, without building the json. NOTE: May throw if there is a circular reference!
+void wz_qjs_to_binary(JSToJsonContext &c, JSValue value, ScriptStateWriter &writer); // forward-declare
 
 bool QuickJS_EnumerateObjectProperties(JSContext *ctx, JSValue obj, const std::function<void (const char *key, JSAtom& atom)>& func, bool enumerableOnly = true); // forward-declare
 
@@ -181,6 +206,97 @@ static void QJSRuntimeFree_LeakHandler_Error(const char* msg)
   #define QUICKJS_HAS_FEATURE(x) 0
 #endif
 
+/// Properties of the script representation of a game object (see convObj, convDroid, convStructure and convFeature)
+enum class GameObjectField : int16_t
+{
+	// Base object
+	id, x, y, z, player, armour, thermal, type, selected, name, born, group,
+	// Droids and structures
+	action, range, order, cost, hasIndirect, bodySize, cargoCapacity, cargoLeft, cargoCount,
+	isRadarDetector, isCB, isSensor, canHitAir, canHitGround, isVTOL, isFlying, droidType, experience, health,
+	body, propulsion, armed, weapons, cargoSize, status, direction, stattype, modules,
+	// Features
+	damageable,
+	count
+};
+static const char *const gameObjectFieldNames[] = {
+	"id", "x", "y", "z", "player", "armour", "thermal", "type", "selected", "name", "born", "group",
+	"action", "range", "order", "cost", "hasIndirect", "bodySize", "cargoCapacity", "cargoLeft", "cargoCount",
+	"isRadarDetector", "isCB", "isSensor", "canHitAir", "canHitGround", "isVTOL", "isFlying", "droidType", "experience", "health",
+	"body", "propulsion", "armed", "weapons", "cargoSize", "status", "direction", "stattype", "modules",
+	"damageable"
+};
+static_assert(sizeof(gameObjectFieldNames) / sizeof(gameObjectFieldNames[0]) == static_cast<size_t>(GameObjectField::count), "gameObjectFieldNames does not match GameObjectField");
+static_assert(static_cast<size_t>(GameObjectField::count) <= 64, "GameObjectField must fit in a 64-bit mask");
+
+// The properties of each type of object, in the order they are defined in
+static const GameObjectField baseObjectFields[] = {
+	GameObjectField::id, GameObjectField::x, GameObjectField::y, GameObjectField::z, GameObjectField::player,
+	GameObjectField::armour, GameObjectField::thermal, GameObjectField::type, GameObjectField::selected,
+	GameObjectField::name, GameObjectField::born, GameObjectField::group
+};
+static const GameObjectField droidFields[] = {
+	GameObjectField::action, GameObjectField::range, GameObjectField::order, GameObjectField::cost,
+	GameObjectField::hasIndirect, GameObjectField::bodySize, GameObjectField::cargoCapacity, GameObjectField::cargoLeft,
+	GameObjectField::cargoCount, GameObjectField::isRadarDetector, GameObjectField::isCB, GameObjectField::isSensor,
+	GameObjectField::canHitAir, GameObjectField::canHitGround, GameObjectField::isVTOL, GameObjectField::isFlying,
+	GameObjectField::droidType, GameObjectField::experience, GameObjectField::health, GameObjectField::body,
+	GameObjectField::propulsion, GameObjectField::armed, GameObjectField::weapons, GameObjectField::cargoSize
+};
+static const GameObjectField structureFields[] = {
+	GameObjectField::isCB, GameObjectField::isSensor, GameObjectField::canHitAir, GameObjectField::canHitGround,
+	GameObjectField::hasIndirect, GameObjectField::isRadarDetector, GameObjectField::range, GameObjectField::status,
+	GameObjectField::health, GameObjectField::cost, GameObjectField::direction, GameObjectField::stattype,
+	GameObjectField::modules, GameObjectField::weapons
+};
+static const GameObjectField featureFields[] = {
+	GameObjectField::health, GameObjectField::damageable, GameObjectField::stattype
+};
+
+static inline uint64_t gameObjectFieldBit(GameObjectField field)
+{
+	return uint64_t(1) << static_cast<int>(field);
+}
+
+/// Properties only defined for transporters
+static inline bool isTransporterOnlyField(GameObjectField field)
+{
+	return field == GameObjectField::cargoCapacity || field == GameObjectField::cargoLeft || field == GameObjectField::cargoCount;
+}
+
+/// Properties that lazily-converted objects set up front, as they identify the object
+static inline bool isEagerGameObjectField(GameObjectField field)
+{
+	return field == GameObjectField::id || field == GameObjectField::type || field == GameObjectField::player;
+}
+
+/// Weapon capabilities of a droid or structure, shared by several of its script properties
+struct GameObjectWeaponSummary
+{
+	bool canHitAir = false;
+	bool canHitGround = false;
+	bool hasIndirect = false;
+	int range = -1;
+};
+
+class quickjs_scripting_instance;
+
+/// Native state of a game object returned from an enum* function. Those are created with only "id", "type" and "player"
+/// set; every other property is resolved from the object on first access (and then kept, as with the eagerly converted
+/// objects). Anything left unresolved is resolved when the script call that created the object returns, or when the
+/// game object is removed, so values never come from a later point in the game than they would have otherwise.
+struct LazyGameObject
+{
+	quickjs_scripting_instance *instance = nullptr; ///< Set while the object is in the instance's pending list
+	const BASE_OBJECT *psObj = nullptr;
+	JSValue object = JS_UNDEFINED;                  ///< Not owned - the JS object owns this
+	uint64_t pendingFields = 0;                     ///< Bitmask of the GameObjectFields not resolved yet
+	LazyGameObject *prev = nullptr;
+	LazyGameObject *next = nullptr;
+};
+
+static JSClassID js_gameobject_class_id = 0;
+
 class quickjs_scripting_instance : public wzapi::scripting_instance
 {
 public:
@@ -212,6 +328,7 @@ public:
 		ASSERT(ctx != nullptr, "JS_NewContext failed?");
 
 		global_obj = JS_GetGlobalObject(ctx);
+		initGameObjectClass();
 
 		engineToInstanceMap.insert(std::pair<JSContext*, quickjs_scripting_instance*>(ctx, this));
 	}
@@ -227,6 +344,18 @@ public:
 			compiledScriptObj = JS_UNINITIALIZED;
 		}
 
+		for (auto &it : eventHandlerAtoms)
+		{
+			JS_FreeAtom(ctx, it.second.base);
+			for (JSAtom atom : it.second.namespaced)
+			{
+				JS_FreeAtom(ctx, atom);
+			}
+		}
+		eventHandlerAtoms.clear();
+
+		freeGameObjectClass();
+
 		JS_FreeValue(ctx, global_obj);
 		ASSERT(ctx != nullptr, "context is null??");
 		if (ctx)
@@ -251,6 +380,7 @@ public:
 	// save / restore state
 	virtual bool saveScriptGlobals(nlohmann::json &result) override;
 	virtual bool loadScriptGlobals(const nlohmann::json &result) override;
+	virtual bool saveScriptGlobalsBinary(ScriptStateWriter &writer) override;
 
 	virtual nlohmann::json saveTimerFunction(uniqueTimerID timerID, std::string timerName, const timerAdditionalData* additionalParam) override;
 
@@ -264,6 +394,23 @@ public:
 
 	bool debugEvaluateCommand(const std::string &text) override;
 
+	void setProfilingEnabled(bool enabled) override;
+	std::unordered_map<std::string, uint64_t> debugGetProfileSamples() const override { return profileSamples; }
+	void debugResetProfileSamples() override { profileSamples.clear(); }
+
+	/// Bracket each call into the script, so the profiler attributes all of its time (see profileSample())
+	void profileCallBegin();
+	void profileCallEnd(const std::string &function);
+
+private:
+	static int profileInterruptHandler(JSRuntime *rt, void *opaque);
+	void profileSample();
+
+	bool profiling = false;
+	int profileCallDepth = 0;
+	std::chrono::steady_clock::time_point lastProfileSample;
+	std::unordered_map<std::string, uint64_t> profileSamples;
+
 public:
 
 	void updateGameTime(uint32_t gameTime) override;
@@ -305,6 +452,51 @@ public: // temporary
 	std::vector<std::string> eventNamespaces;
 	JSValue Get_Global_Obj() const { return global_obj; }
 
+	/// The global names an event (or timer) function is looked up by, as atoms - so dispatching doesn't create them from strings every time
+	struct EventHandlerAtoms
+	{
+		JSAtom base = JS_ATOM_NULL;         ///< The function name itself
+		std::vector<JSAtom> namespaced;     ///< The function name prefixed with each of eventNamespaces (in order)
+	};
+	EventHandlerAtoms& getEventHandlerAtoms(const std::string &function);
+	/// Whether the script currently defines the function (or any namespaced variant of it)
+	bool hasEventHandler(const std::string &function);
+
+private:
+	std::unordered_map<std::string, EventHandlerAtoms> eventHandlerAtoms;
+
+public:
+	/// Create a game object whose properties (apart from "id", "type" and "player") are resolved on access
+	JSValue newLazyGameObject(const BASE_OBJECT *psObj);
+	/// Define a game object property on value, with the same flags as the other conversions use
+	void defineGameObjectField(JSValue value, const BASE_OBJECT *psObj, GameObjectField field);
+	/// Resolve one property of a lazily-converted game object, and return (a new reference to) its value
+	JSValue resolveGameObjectField(LazyGameObject &lazy, GameObjectField field);
+	/// Resolve all remaining properties of a lazily-converted game object
+	void resolveGameObject(LazyGameObject &lazy);
+	/// Resolve all remaining properties of pending lazily-converted game objects (only those of psObj, if set)
+	void resolvePendingGameObjects(const BASE_OBJECT *psObj = nullptr);
+	void unlinkGameObject(LazyGameObject &lazy);
+	/// The names of the properties of a lazily-converted game object that are not resolved yet (for enumeration)
+	int pendingGameObjectFieldNames(const LazyGameObject &lazy, JSPropertyEnum **ptab, uint32_t *plen);
+	/// Describes a property that is not resolved yet as an accessor that resolves it, returns false if prop isn't one
+	bool pendingGameObjectField(const LazyGameObject &lazy, JSPropertyDescriptor *desc, JSAtom prop);
+
+private:
+	void initGameObjectClass();
+	void freeGameObjectClass();
+	JSValue gameObjectFieldValue(const BASE_OBJECT *psObj, GameObjectField field);
+	const GameObjectWeaponSummary& gameObjectWeaponSummary(const BASE_OBJECT *psObj);
+
+	std::array<JSAtom, static_cast<size_t>(GameObjectField::count)> gameObjectFieldAtoms;
+	std::array<JSValue, static_cast<size_t>(GameObjectField::count)> gameObjectFieldGetters;
+	JSValue droidPrototype = JS_UNDEFINED;
+	JSValue structurePrototype = JS_UNDEFINED;
+	JSValue featurePrototype = JS_UNDEFINED;
+	LazyGameObject *pendingGameObjects = nullptr;
+	/// Weapon summaries computed during the current script call, by object id
+	std::unordered_map<uint32_t, GameObjectWeaponSummary> weaponSummaryMemo;
+
 public:
 	// MARK: General events
 
@@ -865,73 +1057,12 @@ JSValue convResearch(const RESEARCH *psResearch, JSContext *ctx, int player)
 //;;
 JSValue convStructure(const STRUCTURE *psStruct, JSContext *ctx)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	for (int i = 0; i < psStruct->numWeaps; i++)
-	{
-		if (psStruct->asWeaps[i].nStat)
-		{
-			WEAPON_STATS *psWeap = psStruct->getWeaponStats(i);
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(*psWeap, psStruct->player), range);
-		}
-	}
 	JSValue value = convObj(psStruct, ctx);
-	QuickJS_DefinePropertyValue(ctx, value, "isCB", JS_NewBool(ctx, structCBSensor(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isSensor", JS_NewBool(ctx, structStandardSensor(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitAir", JS_NewBool(ctx, aa), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitGround", JS_NewBool(ctx, ga), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "hasIndirect", JS_NewBool(ctx, indirect), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isRadarDetector", JS_NewBool(ctx, objRadarDetector(psStruct)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "range", JS_NewInt32(ctx, range), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "status", JS_NewInt32(ctx, (int)psStruct->status), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewInt32(ctx, 100 * psStruct->body / MAX(1, psStruct->structureBody())), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cost", JS_NewInt32(ctx, psStruct->pStructureType->powerToBuild), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "direction", JS_NewInt32(ctx, static_cast<int32_t>(UNDEG(psStruct->rot.direction))), JS_PROP_ENUMERABLE);
-	int stattype = 0;
-	switch (psStruct->pStructureType->type) // don't bleed our source insanities into the scripting world
-	{
-	case REF_WALL:
-	case REF_WALLCORNER:
-	case REF_GATE:
-		stattype = (int)REF_WALL;
-		break;
-	case REF_FORTRESS:
-	case REF_DEFENSE:
-		stattype = (int)REF_DEFENSE;
-		break;
-	default:
-		stattype = (int)psStruct->pStructureType->type;
-		break;
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "stattype", JS_NewInt32(ctx, stattype), JS_PROP_ENUMERABLE);
-	if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
-	    || psStruct->pStructureType->type == REF_VTOL_FACTORY
-	    || psStruct->pStructureType->type == REF_RESEARCH
-	    || psStruct->pStructureType->type == REF_POWER_GEN)
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "modules", JS_NewUint32(ctx, psStruct->capacity), JS_PROP_ENUMERABLE);
-	}
-	else
+	quickjs_scripting_instance *instance = engineToInstanceMap.at(ctx);
+	for (GameObjectField field : structureFields)
 	{
-		QuickJS_DefinePropertyValue(ctx, value, "modules", JS_NULL, JS_PROP_ENUMERABLE);
-	}
-	JSValue weaponlist = JS_NewArray(ctx);
-	for (int j = 0; j < psStruct->numWeaps; j++)
-	{
-		JSValue weapon = JS_NewObject(ctx);
-		const WEAPON_STATS *psStats = psStruct->getWeaponStats(j);
-		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
-		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psStruct->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
-		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
+		instance->defineGameObjectField(value, psStruct, field);
 	}
-	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
 	return value;
 }
 
@@ -947,10 +1078,11 @@ JSValue convStructure(const STRUCTURE *psStruct, JSContext *ctx)
 JSValue convFeature(const FEATURE *psFeature, JSContext *ctx)
 {
 	JSValue value = convObj(psFeature, ctx);
-	const FEATURE_STATS *psStats = psFeature->psStats;
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewUint32(ctx, 100 * psStats->body / MAX(1, psFeature->body)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "damageable", JS_NewBool(ctx, psStats->damageable), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "stattype", JS_NewInt32(ctx, psStats->subType), JS_PROP_ENUMERABLE);
+	quickjs_scripting_instance *instance = engineToInstanceMap.at(ctx);
+	for (GameObjectField field : featureFields)
+	{
+		instance->defineGameObjectField(value, psFeature, field);
+	}
 	return value;
 }
 
@@ -1019,88 +1151,17 @@ JSValue convFeature(const FEATURE *psFeature, JSContext *ctx)
 //;;
 JSValue convDroid(const DROID *psDroid, JSContext *ctx)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	const BODY_STATS *psBodyStats = psDroid->getBodyStats();
-
-	for (int i = 0; i < psDroid->numWeaps; i++)
+	JSValue value = convObj(psDroid, ctx);
+	quickjs_scripting_instance *instance = engineToInstanceMap.at(ctx);
+	const bool isTransporter = psDroid->isTransporter();
+	for (GameObjectField field : droidFields)
 	{
-		if (psDroid->asWeaps[i].nStat)
+		if (!isTransporter && isTransporterOnlyField(field))
 		{
-			ASSERT(psDroid->asWeaps[i].nStat < asWeaponStats.size(), "Invalid nStat (%d) referenced for asWeaps[%d]; numWeaponStats (%zu); droid: \"%s\" (numWeaps: %u)", psDroid->asWeaps[i].nStat, i, asWeaponStats.size(), psDroid->aName, psDroid->numWeaps);
-			WEAPON_STATS *psWeap = psDroid->getWeaponStats(i);
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(*psWeap, psDroid->player), range);
+			continue;
 		}
+		instance->defineGameObjectField(value, psDroid, field);
 	}
-	DROID_TYPE type = psDroid->droidType;
-	JSValue value = convObj(psDroid, ctx);
-	QuickJS_DefinePropertyValue(ctx, value, "action", JS_NewInt32(ctx, (int)psDroid->action), JS_PROP_ENUMERABLE);
-	if (range >= 0)
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "range", JS_NewInt32(ctx, range), JS_PROP_ENUMERABLE);
-	}
-	else
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "range", JS_NULL, JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "order", JS_NewInt32(ctx, (int)psDroid->order.type), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cost", JS_NewUint32(ctx, calcDroidPower(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "hasIndirect", JS_NewBool(ctx, indirect), JS_PROP_ENUMERABLE);
-	switch (psDroid->droidType) // hide some engine craziness
-	{
-	case DROID_CYBORG_CONSTRUCT:
-		type = DROID_CONSTRUCT; break;
-	case DROID_CYBORG_SUPER:
-		type = DROID_CYBORG; break;
-	case DROID_DEFAULT:
-		type = DROID_WEAPON; break;
-	case DROID_CYBORG_REPAIR:
-		type = DROID_REPAIR; break;
-	default:
-		break;
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "bodySize", JS_NewInt32(ctx, psBodyStats->size), JS_PROP_ENUMERABLE);
-	if (psDroid->isTransporter())
-	{
-		QuickJS_DefinePropertyValue(ctx, value, "cargoCapacity", JS_NewInt32(ctx, TRANSPORTER_CAPACITY), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, value, "cargoLeft", JS_NewInt32(ctx, calcRemainingCapacity(psDroid)), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, value, "cargoCount", JS_NewUint32(ctx, psDroid->psGroup != nullptr? psDroid->psGroup->getNumMembers() : 0), JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "isRadarDetector", JS_NewBool(ctx, objRadarDetector(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isCB", JS_NewBool(ctx, cbSensorDroid(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isSensor", JS_NewBool(ctx, standardSensorDroid(psDroid)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitAir", JS_NewBool(ctx, aa), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "canHitGround", JS_NewBool(ctx, ga), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isVTOL", JS_NewBool(ctx, psDroid->isVtol()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "isFlying", JS_NewBool(ctx, psDroid->isFlying()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "droidType", JS_NewInt32(ctx, (int)type), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "experience", JS_NewFloat64(ctx, (double)psDroid->experience / 65536.0), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "health", JS_NewFloat64(ctx, 100.0 / (double)psDroid->originalBody * (double)psDroid->body), JS_PROP_ENUMERABLE);
-
-	QuickJS_DefinePropertyValue(ctx, value, "body", JS_NewString(ctx, psDroid->getBodyStats()->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "propulsion", JS_NewString(ctx, psDroid->getPropulsionStats()->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "armed", JS_NewFloat64(ctx, 0.0), JS_PROP_ENUMERABLE); // deprecated!
-
-	JSValue weaponlist = JS_NewArray(ctx);
-	for (int j = 0; j < psDroid->numWeaps; j++)
-	{
-		int armed = droidReloadBar(psDroid, &psDroid->asWeaps[j], j);
-		JSValue weapon = JS_NewObject(ctx);
-		const WEAPON_STATS *psStats = psDroid->getWeaponStats(j);
-		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
-		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psDroid->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
-		QuickJS_DefinePropertyValue(ctx, weapon, "armed", JS_NewInt32(ctx, armed), JS_PROP_ENUMERABLE);
-		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
-	}
-	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "cargoSize", JS_NewInt32(ctx, transporterSpaceRequired(psDroid)), JS_PROP_ENUMERABLE);
 	return value;
 }
 
@@ -1128,26 +1189,10 @@ JSValue convObj(const BASE_OBJECT *psObj, JSContext *ctx)
 {
 	JSValue value = JS_NewObject(ctx);
 	ASSERT_OR_RETURN(value, psObj, "No object for conversion");
-	QuickJS_DefinePropertyValue(ctx, value, "id", JS_NewUint32(ctx, psObj->id), 0);
-	QuickJS_DefinePropertyValue(ctx, value, "x", JS_NewInt32(ctx, map_coord(psObj->pos.x)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "y", JS_NewInt32(ctx, map_coord(psObj->pos.y)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "z", JS_NewInt32(ctx, map_coord(psObj->pos.z)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "player", JS_NewUint32(ctx, psObj->player), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "armour", JS_NewInt32(ctx, objArmour(psObj, WC_KINETIC)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "thermal", JS_NewInt32(ctx, objArmour(psObj, WC_HEAT)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "type", JS_NewInt32(ctx, psObj->type), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "selected", JS_NewUint32(ctx, psObj->selected), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "name", JS_NewString(ctx, objInfo(psObj)), JS_PROP_ENUMERABLE);
-	QuickJS_DefinePropertyValue(ctx, value, "born", JS_NewUint32(ctx, psObj->born), JS_PROP_ENUMERABLE);
-	scripting_engine::GROUPMAP *psMap = scripting_engine::instance().getGroupMap(engineToInstanceMap.at(ctx));
-	if (psMap != nullptr && psMap->map().count(psObj) > 0) // FIXME:
-	{
-		int group = psMap->map().at(psObj); // FIXME:
-		QuickJS_DefinePropertyValue(ctx, value, "group", JS_NewInt32(ctx, group), JS_PROP_ENUMERABLE);
-	}
-	else
+	quickjs_scripting_instance *instance = engineToInstanceMap.at(ctx);
+	for (GameObjectField field : baseObjectFields)
 	{
-		QuickJS_DefinePropertyValue(ctx, value, "group", JS_NULL, JS_PROP_ENUMERABLE);
+		instance->defineGameObjectField(value, psObj, field);
 	}
 	return value;
 }
@@ -1189,25 +1234,630 @@ JSValue convTemplate(const DROID_TEMPLATE *psTempl, JSContext *ctx)
 	JSValue weaponlist = JS_NewArray(ctx);
 	for (int j = 0; j < psTempl->numWeaps; j++)
 	{
-		JS_DefinePropertyValueUint32(ctx, weaponlist, j, JS_NewString(ctx, psTempl->getWeaponStats(j)->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+		JS_DefinePropertyValueUint32(ctx, weaponlist, j, JS_NewString(ctx, psTempl->getWeaponStats(j)->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+	}
+	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
+	return value;
+}
+
+JSValue convMax(const BASE_OBJECT *psObj, JSContext *ctx)
+{
+	if (!psObj)
+	{
+		return JS_NULL;
+	}
+	switch (psObj->type)
+	{
+	case OBJ_DROID: return convDroid((const DROID *)psObj, ctx);
+	case OBJ_STRUCTURE: return convStructure((const STRUCTURE *)psObj, ctx);
+	case OBJ_FEATURE: return convFeature((const FEATURE *)psObj, ctx);
+	default: ASSERT(false, "No such supported object type: %d", static_cast<int>(psObj->type)); return convObj(psObj, ctx);
+	}
+}
+
+// MARK: - Game object conversion
+
+const GameObjectWeaponSummary& quickjs_scripting_instance::gameObjectWeaponSummary(const BASE_OBJECT *psObj)
+{
+	auto it = weaponSummaryMemo.find(psObj->id);
+	if (it != weaponSummaryMemo.end())
+	{
+		return it->second;
+	}
+	GameObjectWeaponSummary summary;
+	for (int i = 0; i < psObj->numWeaps; i++)
+	{
+		if (psObj->asWeaps[i].nStat)
+		{
+			ASSERT(psObj->asWeaps[i].nStat < asWeaponStats.size(), "Invalid nStat (%d) referenced for asWeaps[%d]; numWeaponStats (%zu); object: \"%s\" (numWeaps: %u)", psObj->asWeaps[i].nStat, i, asWeaponStats.size(), objInfo(psObj), psObj->numWeaps);
+			WEAPON_STATS *psWeap = psObj->getWeaponStats(i);
+			summary.canHitAir = summary.canHitAir || psWeap->surfaceToAir & SHOOT_IN_AIR;
+			summary.canHitGround = summary.canHitGround || psWeap->surfaceToAir & SHOOT_ON_GROUND;
+			summary.hasIndirect = summary.hasIndirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
+			summary.range = MAX(proj_GetLongRange(*psWeap, psObj->player), summary.range);
+		}
+	}
+	return weaponSummaryMemo.emplace(psObj->id, summary).first->second;
+}
+
+static JSValue convDroidWeapons(const DROID *psDroid, JSContext *ctx)
+{
+	JSValue weaponlist = JS_NewArray(ctx);
+	for (int j = 0; j < psDroid->numWeaps; j++)
+	{
+		int armed = droidReloadBar(psDroid, &psDroid->asWeaps[j], j);
+		JSValue weapon = JS_NewObject(ctx);
+		const WEAPON_STATS *psStats = psDroid->getWeaponStats(j);
+		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
+		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psDroid->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "armed", JS_NewInt32(ctx, armed), JS_PROP_ENUMERABLE);
+		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
+	}
+	return weaponlist;
+}
+
+static JSValue convStructureWeapons(const STRUCTURE *psStruct, JSContext *ctx)
+{
+	JSValue weaponlist = JS_NewArray(ctx);
+	for (int j = 0; j < psStruct->numWeaps; j++)
+	{
+		JSValue weapon = JS_NewObject(ctx);
+		const WEAPON_STATS *psStats = psStruct->getWeaponStats(j);
+		QuickJS_DefinePropertyValue(ctx, weapon, "fullname", JS_NewString(ctx, psStats->name.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "name", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE); // will be changed to contain full name
+		QuickJS_DefinePropertyValue(ctx, weapon, "id", JS_NewString(ctx, psStats->id.toUtf8().c_str()), JS_PROP_ENUMERABLE);
+		QuickJS_DefinePropertyValue(ctx, weapon, "lastFired", JS_NewUint32(ctx, psStruct->asWeaps[j].lastFired), JS_PROP_ENUMERABLE);
+		JS_DefinePropertyValueUint32(ctx, weaponlist, j, weapon, JS_PROP_ENUMERABLE);
+	}
+	return weaponlist;
+}
+
+JSValue quickjs_scripting_instance::gameObjectFieldValue(const BASE_OBJECT *psObj, GameObjectField field)
+{
+	switch (field)
+	{
+	case GameObjectField::id: return JS_NewUint32(ctx, psObj->id);
+	case GameObjectField::x: return JS_NewInt32(ctx, map_coord(psObj->pos.x));
+	case GameObjectField::y: return JS_NewInt32(ctx, map_coord(psObj->pos.y));
+	case GameObjectField::z: return JS_NewInt32(ctx, map_coord(psObj->pos.z));
+	case GameObjectField::player: return JS_NewUint32(ctx, psObj->player);
+	case GameObjectField::armour: return JS_NewInt32(ctx, objArmour(psObj, WC_KINETIC));
+	case GameObjectField::thermal: return JS_NewInt32(ctx, objArmour(psObj, WC_HEAT));
+	case GameObjectField::type: return JS_NewInt32(ctx, psObj->type);
+	case GameObjectField::selected: return JS_NewUint32(ctx, psObj->selected);
+	case GameObjectField::name: return JS_NewString(ctx, objInfo(psObj));
+	case GameObjectField::born: return JS_NewUint32(ctx, psObj->born);
+	case GameObjectField::group:
+	{
+		scripting_engine::GROUPMAP *psMap = scripting_engine::instance().getGroupMap(this);
+		if (psMap != nullptr)
+		{
+			auto it = psMap->map().find(psObj);
+			if (it != psMap->map().end())
+			{
+				return JS_NewInt32(ctx, it->second);
+			}
+		}
+		return JS_NULL;
+	}
+	default:
+		break;
+	}
+
+	if (psObj->type == OBJ_DROID)
+	{
+		const DROID *psDroid = static_cast<const DROID *>(psObj);
+		switch (field)
+		{
+		case GameObjectField::action: return JS_NewInt32(ctx, (int)psDroid->action);
+		case GameObjectField::range:
+		{
+			int range = gameObjectWeaponSummary(psDroid).range;
+			return (range >= 0) ? JS_NewInt32(ctx, range) : JS_NULL;
+		}
+		case GameObjectField::order: return JS_NewInt32(ctx, (int)psDroid->order.type);
+		case GameObjectField::cost: return JS_NewUint32(ctx, calcDroidPower(psDroid));
+		case GameObjectField::hasIndirect: return JS_NewBool(ctx, gameObjectWeaponSummary(psDroid).hasIndirect);
+		case GameObjectField::bodySize: return JS_NewInt32(ctx, psDroid->getBodyStats()->size);
+		case GameObjectField::cargoCapacity: return JS_NewInt32(ctx, TRANSPORTER_CAPACITY);
+		case GameObjectField::cargoLeft: return JS_NewInt32(ctx, calcRemainingCapacity(psDroid));
+		case GameObjectField::cargoCount: return JS_NewUint32(ctx, psDroid->psGroup != nullptr? psDroid->psGroup->getNumMembers() : 0);
+		case GameObjectField::isRadarDetector: return JS_NewBool(ctx, objRadarDetector(psDroid));
+		case GameObjectField::isCB: return JS_NewBool(ctx, cbSensorDroid(psDroid));
+		case GameObjectField::isSensor: return JS_NewBool(ctx, standardSensorDroid(psDroid));
+		case GameObjectField::canHitAir: return JS_NewBool(ctx, gameObjectWeaponSummary(psDroid).canHitAir);
+		case GameObjectField::canHitGround: return JS_NewBool(ctx, gameObjectWeaponSummary(psDroid).canHitGround);
+		case GameObjectField::isVTOL: return JS_NewBool(ctx, psDroid->isVtol());
+		case GameObjectField::isFlying: return JS_NewBool(ctx, psDroid->isFlying());
+		case GameObjectField::droidType:
+		{
+			DROID_TYPE type = psDroid->droidType;
+			switch (psDroid->droidType) // hide some engine craziness
+			{
+			case DROID_CYBORG_CONSTRUCT:
+				type = DROID_CONSTRUCT; break;
+			case DROID_CYBORG_SUPER:
+				type = DROID_CYBORG; break;
+			case DROID_DEFAULT:
+				type = DROID_WEAPON; break;
+			case DROID_CYBORG_REPAIR:
+				type = DROID_REPAIR; break;
+			default:
+				break;
+			}
+			return JS_NewInt32(ctx, (int)type);
+		}
+		case GameObjectField::experience: return JS_NewFloat64(ctx, (double)psDroid->experience / 65536.0);
+		case GameObjectField::health: return JS_NewFloat64(ctx, 100.0 / (double)psDroid->originalBody * (double)psDroid->body);
+		case GameObjectField::body: return JS_NewString(ctx, psDroid->getBodyStats()->id.toUtf8().c_str());
+		case GameObjectField::propulsion: return JS_NewString(ctx, psDroid->getPropulsionStats()->id.toUtf8().c_str());
+		case GameObjectField::armed: return JS_NewFloat64(ctx, 0.0); // deprecated!
+		case GameObjectField::weapons: return convDroidWeapons(psDroid, ctx);
+		case GameObjectField::cargoSize: return JS_NewInt32(ctx, transporterSpaceRequired(psDroid));
+		default:
+			break;
+		}
+	}
+	else if (psObj->type == OBJ_STRUCTURE)
+	{
+		const STRUCTURE *psStruct = static_cast<const STRUCTURE *>(psObj);
+		switch (field)
+		{
+		case GameObjectField::isCB: return JS_NewBool(ctx, structCBSensor(psStruct));
+		case GameObjectField::isSensor: return JS_NewBool(ctx, structStandardSensor(psStruct));
+		case GameObjectField::canHitAir: return JS_NewBool(ctx, gameObjectWeaponSummary(psStruct).canHitAir);
+		case GameObjectField::canHitGround: return JS_NewBool(ctx, gameObjectWeaponSummary(psStruct).canHitGround);
+		case GameObjectField::hasIndirect: return JS_NewBool(ctx, gameObjectWeaponSummary(psStruct).hasIndirect);
+		case GameObjectField::isRadarDetector: return JS_NewBool(ctx, objRadarDetector(psStruct));
+		case GameObjectField::range: return JS_NewInt32(ctx, gameObjectWeaponSummary(psStruct).range);
+		case GameObjectField::status: return JS_NewInt32(ctx, (int)psStruct->status);
+		case GameObjectField::health: return JS_NewInt32(ctx, 100 * psStruct->body / MAX(1, psStruct->structureBody()));
+		case GameObjectField::cost: return JS_NewInt32(ctx, psStruct->pStructureType->powerToBuild);
+		case GameObjectField::direction: return JS_NewInt32(ctx, static_cast<int32_t>(UNDEG(psStruct->rot.direction)));
+		case GameObjectField::stattype:
+			switch (psStruct->pStructureType->type) // don't bleed our source insanities into the scripting world
+			{
+			case REF_WALL:
+			case REF_WALLCORNER:
+			case REF_GATE:
+				return JS_NewInt32(ctx, (int)REF_WALL);
+			case REF_FORTRESS:
+			case REF_DEFENSE:
+				return JS_NewInt32(ctx, (int)REF_DEFENSE);
+			default:
+				return JS_NewInt32(ctx, (int)psStruct->pStructureType->type);
+			}
+		case GameObjectField::modules:
+			if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
+			    || psStruct->pStructureType->type == REF_VTOL_FACTORY
+			    || psStruct->pStructureType->type == REF_RESEARCH
+			    || psStruct->pStructureType->type == REF_POWER_GEN)
+			{
+				return JS_NewUint32(ctx, psStruct->capacity);
+			}
+			return JS_NULL;
+		case GameObjectField::weapons: return convStructureWeapons(psStruct, ctx);
+		default:
+			break;
+		}
+	}
+	else if (psObj->type == OBJ_FEATURE)
+	{
+		const FEATURE *psFeature = static_cast<const FEATURE *>(psObj);
+		const FEATURE_STATS *psStats = psFeature->psStats;
+		switch (field)
+		{
+		case GameObjectField::health: return JS_NewUint32(ctx, 100 * psStats->body / MAX(1, psFeature->body));
+		case GameObjectField::damageable: return JS_NewBool(ctx, psStats->damageable);
+		case GameObjectField::stattype: return JS_NewInt32(ctx, psStats->subType);
+		default:
+			break;
+		}
+	}
+	ASSERT(false, "Property %s is not defined for object type %d", gameObjectFieldNames[static_cast<int>(field)], static_cast<int>(psObj->type));
+	return JS_UNDEFINED;
+}
+
+void quickjs_scripting_instance::defineGameObjectField(JSValue value, const BASE_OBJECT *psObj, GameObjectField field)
+{
+	int flags = (field == GameObjectField::id) ? 0 : JS_PROP_ENUMERABLE;
+	JS_DefinePropertyValue(ctx, value, gameObjectFieldAtoms[static_cast<size_t>(field)], gameObjectFieldValue(psObj, field), flags);
+}
+
+static JSValue js_gameobject_get(JSContext *ctx, JSValueConst this_val, int magic)
+{
+	LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(this_val, js_gameobject_class_id));
+	if (lazy == nullptr || lazy->instance == nullptr)
+	{
+		return JS_UNDEFINED; // not a game object (e.g. the prototype itself), or one whose object is gone
+	}
+	return lazy->instance->resolveGameObjectField(*lazy, static_cast<GameObjectField>(magic));
+}
+
+static JSValue js_gameobject_getter(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic)
+{
+	return js_gameobject_get(ctx, this_val, magic);
+}
+
+// Object.keys(), spread, Object.assign() etc. only see own properties, and the ones not resolved yet are only getters
+// on the prototype. These hooks report them as own accessor properties, whose getter resolves them. They must not
+// resolve anything themselves: QuickJS calls them in the middle of collecting the (other) own properties.
+static int js_gameobject_get_own_property_names(JSContext *ctx, JSPropertyEnum **ptab, uint32_t *plen, JSValueConst obj)
+{
+	*ptab = nullptr;
+	*plen = 0;
+	LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(obj, js_gameobject_class_id));
+	if (lazy == nullptr || lazy->instance == nullptr)
+	{
+		return 0;
+	}
+	return lazy->instance->pendingGameObjectFieldNames(*lazy, ptab, plen);
+}
+
+static int js_gameobject_get_own_property(JSContext *ctx, JSPropertyDescriptor *desc, JSValueConst obj, JSAtom prop)
+{
+	LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(obj, js_gameobject_class_id));
+	if (lazy == nullptr || lazy->instance == nullptr)
+	{
+		return 0;
+	}
+	return lazy->instance->pendingGameObjectField(*lazy, desc, prop) ? 1 : 0;
+}
+
+int quickjs_scripting_instance::pendingGameObjectFieldNames(const LazyGameObject &lazy, JSPropertyEnum **ptab, uint32_t *plen)
+{
+	uint32_t count = 0;
+	for (size_t i = 0; i < static_cast<size_t>(GameObjectField::count); ++i)
+	{
+		count += (lazy.pendingFields & gameObjectFieldBit(static_cast<GameObjectField>(i))) ? 1 : 0;
+	}
+	if (count == 0)
+	{
+		return 0;
+	}
+	// freed by QuickJS
+	JSPropertyEnum *tab = static_cast<JSPropertyEnum *>(js_malloc(ctx, sizeof(JSPropertyEnum) * count));
+	if (tab == nullptr)
+	{
+		return -1;
+	}
+	uint32_t index = 0;
+	for (size_t i = 0; i < static_cast<size_t>(GameObjectField::count); ++i)
+	{
+		if (lazy.pendingFields & gameObjectFieldBit(static_cast<GameObjectField>(i)))
+		{
+			tab[index].is_enumerable = true;
+			tab[index].atom = JS_DupAtom(ctx, gameObjectFieldAtoms[i]);
+			++index;
+		}
+	}
+	*ptab = tab;
+	*plen = count;
+	return 0;
+}
+
+bool quickjs_scripting_instance::pendingGameObjectField(const LazyGameObject &lazy, JSPropertyDescriptor *desc, JSAtom prop)
+{
+	for (size_t i = 0; i < static_cast<size_t>(GameObjectField::count); ++i)
+	{
+		if (gameObjectFieldAtoms[i] != prop)
+		{
+			continue;
+		}
+		if (!(lazy.pendingFields & gameObjectFieldBit(static_cast<GameObjectField>(i))))
+		{
+			return false;
+		}
+		if (desc != nullptr)
+		{
+			desc->flags = JS_PROP_GETSET | JS_PROP_ENUMERABLE | JS_PROP_CONFIGURABLE;
+			desc->value = JS_UNDEFINED;
+			desc->getter = JS_DupValue(ctx, gameObjectFieldGetters[i]);
+			desc->setter = JS_UNDEFINED;
+		}
+		return true;
+	}
+	return false;
+}
+
+static JSValue js_gameobject_toJSON(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv)
+{
+	// JSON.stringify() only looks at own properties, so resolve them all first
+	LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(this_val, js_gameobject_class_id));
+	if (lazy != nullptr && lazy->instance != nullptr)
+	{
+		lazy->instance->resolveGameObject(*lazy);
+	}
+	return JS_DupValue(ctx, this_val);
+}
+
+static void js_gameobject_finalizer(JSRuntime *rt, JSValue val)
+{
+	LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(val, js_gameobject_class_id));
+	if (lazy != nullptr)
+	{
+		if (lazy->instance != nullptr)
+		{
+			lazy->instance->unlinkGameObject(*lazy);
+		}
+		delete lazy;
+	}
+}
+
+void quickjs_scripting_instance::initGameObjectClass()
+{
+	for (size_t i = 0; i < gameObjectFieldAtoms.size(); ++i)
+	{
+		gameObjectFieldAtoms[i] = JS_NewAtom(ctx, gameObjectFieldNames[i]);
+	}
+
+	if (js_gameobject_class_id == 0)
+	{
+#if defined(QUICKJS_NG)
+		JS_NewClassID(rt, &js_gameobject_class_id);
+#else
+		JS_NewClassID(&js_gameobject_class_id);
+#endif
+	}
+	for (size_t i = 0; i < gameObjectFieldGetters.size(); ++i)
+	{
+		gameObjectFieldGetters[i] = JS_NewCFunctionMagic(ctx, js_gameobject_getter, gameObjectFieldNames[i], 0, JS_CFUNC_generic_magic, static_cast<int>(i));
+	}
+
+	static JSClassExoticMethods exoticMethods = {};
+	exoticMethods.get_own_property = js_gameobject_get_own_property;
+	exoticMethods.get_own_property_names = js_gameobject_get_own_property_names;
+	JSClassDef classDef = {};
+	classDef.class_name = "GameObject";
+	classDef.finalizer = js_gameobject_finalizer;
+	classDef.exotic = &exoticMethods;
+	int ret = JS_NewClass(rt, js_gameobject_class_id, &classDef);
+	ASSERT(ret == 0, "Failed to register the GameObject class");
+
+	// One prototype per object type, with a getter for each property that is resolved on access
+	auto createPrototype = [this](const GameObjectField *fields, size_t numFields) -> JSValue {
+		std::vector<JSCFunctionListEntry> entries;
+		for (GameObjectField field : baseObjectFields)
+		{
+			if (!isEagerGameObjectField(field))
+			{
+				entries.push_back(QJS_CGETSET_MAGIC_DEF(gameObjectFieldNames[static_cast<int>(field)], js_gameobject_get, nullptr, static_cast<int16_t>(field), JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE));
+			}
+		}
+		for (size_t i = 0; i < numFields; ++i)
+		{
+			if (!isTransporterOnlyField(fields[i]))
+			{
+				entries.push_back(QJS_CGETSET_MAGIC_DEF(gameObjectFieldNames[static_cast<int>(fields[i])], js_gameobject_get, nullptr, static_cast<int16_t>(fields[i]), JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE));
+			}
+		}
+		entries.push_back(QJS_CFUNC_DEF("toJSON", 1, js_gameobject_toJSON));
+		JSValue proto = JS_NewObject(ctx);
+		JS_SetPropertyFunctionList(ctx, proto, entries.data(), static_cast<int>(entries.size()));
+		return proto;
+	};
+	droidPrototype = createPrototype(droidFields, sizeof(droidFields) / sizeof(droidFields[0]));
+	structurePrototype = createPrototype(structureFields, sizeof(structureFields) / sizeof(structureFields[0]));
+	featurePrototype = createPrototype(featureFields, sizeof(featureFields) / sizeof(featureFields[0]));
+}
+
+void quickjs_scripting_instance::freeGameObjectClass()
+{
+	// any objects still around are finalized with the runtime - make sure they don't refer back to us
+	while (pendingGameObjects != nullptr)
+	{
+		unlinkGameObject(*pendingGameObjects);
+	}
+	weaponSummaryMemo.clear();
+	JS_FreeValue(ctx, droidPrototype);
+	JS_FreeValue(ctx, structurePrototype);
+	JS_FreeValue(ctx, featurePrototype);
+	droidPrototype = structurePrototype = featurePrototype = JS_UNDEFINED;
+	for (JSValue &getter : gameObjectFieldGetters)
+	{
+		JS_FreeValue(ctx, getter);
+		getter = JS_UNDEFINED;
+	}
+	for (JSAtom atom : gameObjectFieldAtoms)
+	{
+		JS_FreeAtom(ctx, atom);
+	}
+}
+
+JSValue quickjs_scripting_instance::newLazyGameObject(const BASE_OBJECT *psObj)
+{
+	JSValue proto;
+	uint64_t pendingFields = 0;
+	auto addFields = [&pendingFields](const GameObjectField *fields, size_t numFields) {
+		for (size_t i = 0; i < numFields; ++i)
+		{
+			if (!isEagerGameObjectField(fields[i]) && !isTransporterOnlyField(fields[i]))
+			{
+				pendingFields |= gameObjectFieldBit(fields[i]);
+			}
+		}
+	};
+	addFields(baseObjectFields, sizeof(baseObjectFields) / sizeof(baseObjectFields[0]));
+	switch (psObj->type)
+	{
+	case OBJ_DROID:
+		proto = droidPrototype;
+		addFields(droidFields, sizeof(droidFields) / sizeof(droidFields[0]));
+		break;
+	case OBJ_STRUCTURE:
+		proto = structurePrototype;
+		addFields(structureFields, sizeof(structureFields) / sizeof(structureFields[0]));
+		break;
+	case OBJ_FEATURE:
+		proto = featurePrototype;
+		addFields(featureFields, sizeof(featureFields) / sizeof(featureFields[0]));
+		break;
+	default:
+		return convMax(psObj, ctx);
+	}
+
+	JSValue value = JS_NewObjectProtoClass(ctx, proto, js_gameobject_class_id);
+	if (JS_IsException(value))
+	{
+		return value;
+	}
+	for (GameObjectField field : baseObjectFields)
+	{
+		if (isEagerGameObjectField(field))
+		{
+			defineGameObjectField(value, psObj, field);
+		}
+	}
+	if (psObj->type == OBJ_DROID && static_cast<const DROID *>(psObj)->isTransporter())
+	{
+		for (GameObjectField field : droidFields)
+		{
+			if (isTransporterOnlyField(field))
+			{
+				defineGameObjectField(value, psObj, field);
+			}
+		}
+	}
+
+	LazyGameObject *lazy = new LazyGameObject();
+	lazy->instance = this;
+	lazy->psObj = psObj;
+	lazy->object = value;
+	lazy->pendingFields = pendingFields;
+	lazy->next = pendingGameObjects;
+	if (pendingGameObjects != nullptr)
+	{
+		pendingGameObjects->prev = lazy;
+	}
+	pendingGameObjects = lazy;
+	JS_SetOpaque(value, lazy);
+	return value;
+}
+
+void quickjs_scripting_instance::unlinkGameObject(LazyGameObject &lazy)
+{
+	ASSERT_OR_RETURN(, lazy.instance == this, "Game object is not pending in this instance");
+	if (lazy.prev != nullptr)
+	{
+		lazy.prev->next = lazy.next;
+	}
+	else
+	{
+		pendingGameObjects = lazy.next;
+	}
+	if (lazy.next != nullptr)
+	{
+		lazy.next->prev = lazy.prev;
+	}
+	lazy.prev = lazy.next = nullptr;
+	lazy.instance = nullptr;
+	lazy.psObj = nullptr;
+	lazy.pendingFields = 0;
+}
+
+JSValue quickjs_scripting_instance::resolveGameObjectField(LazyGameObject &lazy, GameObjectField field)
+{
+	JSValue value = gameObjectFieldValue(lazy.psObj, field);
+	// keep the value as an own property (with the same flags as eagerly converted objects), so the getter isn't called again
+	JS_DefinePropertyValue(ctx, lazy.object, gameObjectFieldAtoms[static_cast<size_t>(field)], JS_DupValue(ctx, value), JS_PROP_ENUMERABLE);
+	lazy.pendingFields &= ~gameObjectFieldBit(field);
+	if (lazy.pendingFields == 0)
+	{
+		unlinkGameObject(lazy);
+	}
+	return value;
+}
+
+void quickjs_scripting_instance::resolveGameObject(LazyGameObject &lazy)
+{
+	// hold a reference, so a garbage collection while resolving can't finalize the object
+	JSValue object = JS_DupValue(ctx, lazy.object);
+	for (size_t i = 0; i < static_cast<size_t>(GameObjectField::count) && lazy.instance != nullptr; ++i)
+	{
+		GameObjectField field = static_cast<GameObjectField>(i);
+		if (lazy.pendingFields & gameObjectFieldBit(field))
+		{
+			JS_FreeValue(ctx, resolveGameObjectField(lazy, field));
+		}
+	}
+	if (lazy.instance != nullptr)
+	{
+		unlinkGameObject(lazy);
+	}
+	JS_FreeValue(ctx, object);
+}
+
+void quickjs_scripting_instance::resolvePendingGameObjects(const BASE_OBJECT *psObj /*= nullptr*/)
+{
+	if (psObj == nullptr)
+	{
+		while (pendingGameObjects != nullptr)
+		{
+			resolveGameObject(*pendingGameObjects);
+		}
+		weaponSummaryMemo.clear();
+		return;
+	}
+	std::vector<JSValue> objects;
+	for (LazyGameObject *lazy = pendingGameObjects; lazy != nullptr; lazy = lazy->next)
+	{
+		if (lazy->psObj == psObj)
+		{
+			objects.push_back(JS_DupValue(ctx, lazy->object));
+		}
+	}
+	for (JSValue &object : objects)
+	{
+		LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(object, js_gameobject_class_id));
+		if (lazy != nullptr && lazy->instance != nullptr)
+		{
+			resolveGameObject(*lazy);
+		}
+		JS_FreeValue(ctx, object);
 	}
-	QuickJS_DefinePropertyValue(ctx, value, "weapons", weaponlist, JS_PROP_ENUMERABLE);
-	return value;
 }
 
-JSValue convMax(const BASE_OBJECT *psObj, JSContext *ctx)
+void scriptRemoveObject_QuickJS(const BASE_OBJECT *psObj)
 {
-	if (!psObj)
+	for (auto &it : engineToInstanceMap)
 	{
-		return JS_NULL;
+		it.second->resolvePendingGameObjects(psObj);
 	}
-	switch (psObj->type)
+}
+
+quickjs_scripting_instance::EventHandlerAtoms& quickjs_scripting_instance::getEventHandlerAtoms(const std::string &function)
+{
+	auto it = eventHandlerAtoms.find(function);
+	if (it == eventHandlerAtoms.end())
 	{
-	case OBJ_DROID: return convDroid((const DROID *)psObj, ctx);
-	case OBJ_STRUCTURE: return convStructure((const STRUCTURE *)psObj, ctx);
-	case OBJ_FEATURE: return convFeature((const FEATURE *)psObj, ctx);
-	default: ASSERT(false, "No such supported object type: %d", static_cast<int>(psObj->type)); return convObj(psObj, ctx);
+		it = eventHandlerAtoms.emplace(function, EventHandlerAtoms()).first;
+		it->second.base = JS_NewAtomLen(ctx, function.c_str(), function.size());
+	}
+	EventHandlerAtoms &atoms = it->second;
+	while (atoms.namespaced.size() < eventNamespaces.size()) // namespace() may have been called since
+	{
+		std::string funcName = eventNamespaces[atoms.namespaced.size()] + function;
+		atoms.namespaced.push_back(JS_NewAtomLen(ctx, funcName.c_str(), funcName.size()));
+	}
+	return atoms;
+}
+
+bool quickjs_scripting_instance::hasEventHandler(const std::string &function)
+{
+	const EventHandlerAtoms &atoms = getEventHandlerAtoms(function);
+	auto isFunction = [this](JSAtom atom) -> bool {
+		JSValue value = JS_GetProperty(ctx, global_obj, atom);
+		bool result = JS_IsFunction(ctx, value);
+		JS_FreeValue(ctx, value);
+		return result;
+	};
+	if (isFunction(atoms.base))
+	{
+		return true;
 	}
+	return std::any_of(atoms.namespaced.begin(), atoms.namespaced.end(), isFunction);
 }
 
 // Call a function by name
@@ -1215,22 +1865,29 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 {
 	const auto instance = engineToInstanceMap.at(ctx);
 	JSValue global_obj = instance->Get_Global_Obj();
+	JSValue value;
 	if (event)
 	{
 		// recurse into variants, if any
-		for (const std::string &s : instance->eventNamespaces)
+		// (atoms is a reference to a map value, so stays valid - but its vector may grow if a handler calls namespace())
+		auto &atoms = instance->getEventHandlerAtoms(function);
+		const size_t numNamespaces = atoms.namespaced.size();
+		for (size_t i = 0; i < numNamespaces; ++i)
 		{
-			std::string funcName = s + function;
-			JSValue value = JS_GetPropertyStr(ctx, global_obj, funcName.c_str());
-			if (JS_IsFunction(ctx, value))
+			JSValue variantValue = JS_GetProperty(ctx, global_obj, atoms.namespaced[i]);
+			if (JS_IsFunction(ctx, variantValue))
 			{
-				callFunction(ctx, funcName, args, event);
+				callFunction(ctx, instance->eventNamespaces[i] + function, args, event);
 			}
-			JS_FreeValue(ctx, value);
+			JS_FreeValue(ctx, variantValue);
 		}
+		value = JS_GetProperty(ctx, global_obj, atoms.base);
+	}
+	else
+	{
+		value = JS_GetPropertyStr(ctx, global_obj, function.c_str());
 	}
 	code_part level = event ? LOG_SCRIPT : LOG_ERROR;
-	JSValue value = JS_GetPropertyStr(ctx, global_obj, function.c_str());
 	auto free_func_ref = gsl::finally([ctx, value] { JS_FreeValue(ctx, value); });  // establish exit action
 	if (!JS_IsFunction(ctx, value))
 	{
@@ -1241,8 +1898,11 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 	}
 
 	JSValue result;
-	scripting_engine::instance().executeWithPerformanceMonitoring(instance, function, [ctx, &result, value, &args](){
+	scripting_engine::instance().executeWithPerformanceMonitoring(instance, function, [ctx, instance, &result, value, &args, &function](){
+		instance->profileCallBegin();
 		result = JS_Call(ctx, value, JS_UNDEFINED, (int)args.size(), args.data());
+		instance->profileCallEnd(function);
+		instance->resolvePendingGameObjects(); // game state may change once we return
 	});
 
 	if (JS_IsException(result))
@@ -2055,6 +2715,46 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 			return result;
 		}
 
+		// Lists of game objects (as returned by enumDroid, enumStruct, enumRange, etc.) are converted lazily,
+		// as scripts typically only look at a few properties of each
+		template<typename ObjectType>
+		JSValue boxGameObjectList(const std::vector<const ObjectType *>& value, JSContext* ctx)
+		{
+			quickjs_scripting_instance *instance = engineToInstanceMap.at(ctx);
+			JSValue result = JS_NewArray(ctx);
+			for (uint32_t i = 0; i < value.size(); i++)
+			{
+				JSValue item = (value[i] != nullptr) ? instance->newLazyGameObject(value[i]) : JS_NULL;
+				int ret = JS_DefinePropertyValueUint32(ctx, result, i, item, JS_PROP_C_W_E);
+				if (ret != 1)
+				{
+					// Failed to define property value??
+					debug(LOG_ERROR, "Failed to define property value vector[%" PRIu32 "]", i);
+				}
+			}
+			return result;
+		}
+
+		JSValue box(const std::vector<const BASE_OBJECT *>& value, JSContext* ctx)
+		{
+			return boxGameObjectList(value, ctx);
+		}
+
+		JSValue box(const std::vector<const DROID *>& value, JSContext* ctx)
+		{
+			return boxGameObjectList(value, ctx);
+		}
+
+		JSValue box(const std::vector<const STRUCTURE *>& value, JSContext* ctx)
+		{
+			return boxGameObjectList(value, ctx);
+		}
+
+		JSValue box(const std::vector<const FEATURE *>& value, JSContext* ctx)
+		{
+			return boxGameObjectList(value, ctx);
+		}
+
 		template<typename ContainedType>
 		JSValue box(const std::list<ContainedType>& value, JSContext* ctx)
 		{
@@ -2277,6 +2977,12 @@ static JSValue callFunction(JSContext *ctx, const std::string &function, std::ve
 		template <typename... Args>
 		bool wrap_event_handler__(const std::string &functionName, JSContext *context, Args&&... args)
 		{
+			if (!engineToInstanceMap.at(context)->hasEventHandler(functionName))
+			{
+				// not handled by this script - don't bother converting the arguments
+				debug(LOG_SCRIPT, "called function (%s) not defined", functionName.c_str());
+				return true;
+			}
 			std::vector<JSValue> args_list;
 			using expander = int[];
 //			WZ_DECL_UNUSED int dummy[] = { 0, ((void) append_value_list(args_list, std::forward<Args>(args), engine),0)... };
@@ -2392,6 +3098,225 @@ static std::string QuickJS_DumpError(JSContext *ctx)
 	return result;
 }
 
+// MARK: - Compiled script cache
+
+// Compiled script bytecode is cached (in memory, and in the config dir), keyed by a hash of the build, file path and source.
+// Every scripting instance has its own runtime, so the bytecode must still be read into each instance - but that is much
+// faster than parsing and compiling the same source again (for every AI player, every include, and every game start).
+#define QUICKJS_BYTECODE_CACHE_DIR "cache/jsbytecode"
+#define QUICKJS_BYTECODE_CACHE_EXTENSION ".qjsc"
+#define QUICKJS_BYTECODE_CACHE_MAX_FILES 256
+static const uint32_t quickjsBytecodeCacheVersion = 2; // increment if the way scripts are compiled (or cached) changes
+
+static std::mutex quickjsBytecodeCacheMutex;
+static std::unordered_map<std::string, std::shared_ptr<const std::vector<uint8_t>>> quickjsBytecodeCache;
+static bool quickjsBytecodeCacheDirInitialized = false;
+
+static std::string QuickJS_BytecodeCacheKey(const char *source, size_t size, const std::string &filename)
+{
+	std::string keyData = version_getBuildIdentifierReleaseString() + "\n" + std::to_string(quickjsBytecodeCacheVersion) + "\n" + filename + "\n";
+	keyData.append(source, size);
+	return sha256Sum(keyData.data(), keyData.size()).toString();
+}
+
+// must be called with quickjsBytecodeCacheMutex held
+static void QuickJS_InitBytecodeCacheDir()
+{
+	if (quickjsBytecodeCacheDirInitialized)
+	{
+		return;
+	}
+	quickjsBytecodeCacheDirInitialized = true;
+	PHYSFS_mkdir(QUICKJS_BYTECODE_CACHE_DIR);
+	// bound the size of the cache (stale entries from old builds / changed scripts are never used again)
+	WZ_PHYSFS_cleanupOldFilesInFolder(QUICKJS_BYTECODE_CACHE_DIR, QUICKJS_BYTECODE_CACHE_EXTENSION, QUICKJS_BYTECODE_CACHE_MAX_FILES, [](const char *fileName) {
+		if (PHYSFS_delete(fileName) == 0)
+		{
+			debug(LOG_WARNING, "Failed to delete old script cache file: %s", fileName);
+			return false;
+		}
+		return true;
+	});
+}
+
+// Cache files are: | magic (8 bytes) | header fields (little-endian uint32s) | engine identifier | SHA-256 of the bytecode | bytecode |
+// QuickJS trusts the bytecode it reads, so anything that does not match exactly is discarded and the source compiled again.
+static const char quickjsBytecodeCacheMagic[8] = {'W', 'Z', 'Q', 'J', 'S', 'B', 'C', '\0'};
+
+static std::string QuickJS_EngineIdentifier()
+{
+#if defined(QJS_VERSION_STR)
+	return std::string("QuickJS ") + QJS_VERSION_STR + "\n" + version_getBuildIdentifierReleaseString();
+#else
+	// the bundled QuickJS does not export a version - it is pinned to the build
+	return std::string("quickjs-wz\n") + version_getBuildIdentifierReleaseString();
+#endif
+}
+
+static void QuickJS_AppendUint32(std::vector<uint8_t> &output, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		output.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+static bool QuickJS_ReadUint32(const std::vector<char> &input, size_t &pos, uint32_t &value)
+{
+	if (input.size() - pos < 4)
+	{
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		value |= static_cast<uint32_t>(static_cast<uint8_t>(input[pos + i])) << (8 * i);
+	}
+	pos += 4;
+	return true;
+}
+
+static std::vector<uint8_t> QuickJS_SerializeCacheFile(const std::vector<uint8_t> &bytecode)
+{
+	const std::string engineIdentifier = QuickJS_EngineIdentifier();
+	const Sha256 checksum = sha256Sum(bytecode.data(), bytecode.size());
+	std::vector<uint8_t> output;
+	output.reserve(sizeof(quickjsBytecodeCacheMagic) + 12 + engineIdentifier.size() + Sha256::Bytes + bytecode.size());
+	output.insert(output.end(), quickjsBytecodeCacheMagic, quickjsBytecodeCacheMagic + sizeof(quickjsBytecodeCacheMagic));
+	QuickJS_AppendUint32(output, quickjsBytecodeCacheVersion);
+	QuickJS_AppendUint32(output, static_cast<uint32_t>(engineIdentifier.size()));
+	QuickJS_AppendUint32(output, static_cast<uint32_t>(bytecode.size()));
+	output.insert(output.end(), engineIdentifier.begin(), engineIdentifier.end());
+	output.insert(output.end(), checksum.bytes, checksum.bytes + Sha256::Bytes);
+	output.insert(output.end(), bytecode.begin(), bytecode.end());
+	return output;
+}
+
+// Returns the bytecode in the cache file, or nullptr if the file is truncated, corrupted or from another engine
+static std::shared_ptr<const std::vector<uint8_t>> QuickJS_DeserializeCacheFile(const std::vector<char> &fileData)
+{
+	if (fileData.size() < sizeof(quickjsBytecodeCacheMagic) || memcmp(fileData.data(), quickjsBytecodeCacheMagic, sizeof(quickjsBytecodeCacheMagic)) != 0)
+	{
+		return nullptr;
+	}
+	size_t pos = sizeof(quickjsBytecodeCacheMagic);
+	uint32_t cacheVersion = 0, engineIdentifierSize = 0, bytecodeSize = 0;
+	if (!QuickJS_ReadUint32(fileData, pos, cacheVersion) || !QuickJS_ReadUint32(fileData, pos, engineIdentifierSize) || !QuickJS_ReadUint32(fileData, pos, bytecodeSize))
+	{
+		return nullptr;
+	}
+	if (cacheVersion != quickjsBytecodeCacheVersion || fileData.size() - pos != static_cast<size_t>(engineIdentifierSize) + Sha256::Bytes + bytecodeSize)
+	{
+		return nullptr;
+	}
+	if (std::string(fileData.data() + pos, engineIdentifierSize) != QuickJS_EngineIdentifier())
+	{
+		return nullptr;
+	}
+	pos += engineIdentifierSize;
+	Sha256 storedChecksum;
+	memcpy(storedChecksum.bytes, fileData.data() + pos, Sha256::Bytes);
+	pos += Sha256::Bytes;
+	auto bytecode = std::make_shared<const std::vector<uint8_t>>(fileData.begin() + pos, fileData.end());
+	if (sha256Sum(bytecode->data(), bytecode->size()) != storedChecksum)
+	{
+		return nullptr;
+	}
+	return bytecode;
+}
+
+static std::shared_ptr<const std::vector<uint8_t>> QuickJS_FindCachedBytecode(const std::string &key)
+{
+	std::lock_guard<std::mutex> guard(quickjsBytecodeCacheMutex);
+	auto it = quickjsBytecodeCache.find(key);
+	if (it != quickjsBytecodeCache.end())
+	{
+		return it->second;
+	}
+	QuickJS_InitBytecodeCacheDir();
+	std::string cacheFilePath = std::string(QUICKJS_BYTECODE_CACHE_DIR "/") + key + QUICKJS_BYTECODE_CACHE_EXTENSION;
+	if (!PHYSFS_exists(cacheFilePath.c_str()))
+	{
+		return nullptr;
+	}
+	std::vector<char> fileData;
+	if (!loadFileToBufferVector(cacheFilePath.c_str(), fileData, false, false))
+	{
+		return nullptr;
+	}
+	auto bytecode = QuickJS_DeserializeCacheFile(fileData);
+	if (!bytecode)
+	{
+		debug(LOG_WARNING, "Discarding invalid script cache file: %s", cacheFilePath.c_str());
+		PHYSFS_delete(cacheFilePath.c_str());
+		return nullptr;
+	}
+	quickjsBytecodeCache[key] = bytecode;
+	return bytecode;
+}
+
+static void QuickJS_StoreCachedBytecode(const std::string &key, std::shared_ptr<const std::vector<uint8_t>> bytecode)
+{
+	std::lock_guard<std::mutex> guard(quickjsBytecodeCacheMutex);
+	QuickJS_InitBytecodeCacheDir();
+	std::string cacheFilePath = std::string(QUICKJS_BYTECODE_CACHE_DIR "/") + key + QUICKJS_BYTECODE_CACHE_EXTENSION;
+	const std::vector<uint8_t> fileData = QuickJS_SerializeCacheFile(*bytecode);
+	if (!saveFileAtomic(cacheFilePath.c_str(), reinterpret_cast<const char *>(fileData.data()), static_cast<UDWORD>(fileData.size())))
+	{
+		debug(LOG_WARNING, "Failed to write script cache file: %s", cacheFilePath.c_str());
+	}
+	quickjsBytecodeCache[key] = std::move(bytecode);
+}
+
+static void QuickJS_InvalidateCachedBytecode(const std::string &key)
+{
+	std::lock_guard<std::mutex> guard(quickjsBytecodeCacheMutex);
+	quickjsBytecodeCache.erase(key);
+	std::string cacheFilePath = std::string(QUICKJS_BYTECODE_CACHE_DIR "/") + key + QUICKJS_BYTECODE_CACHE_EXTENSION;
+	PHYSFS_delete(cacheFilePath.c_str());
+}
+
+// Equivalent to: JS_Eval_BypassLimitedContext(ctx, source, size, filename, JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY)
+// But uses (and fills) the compiled script cache
+static JSValue QuickJS_CompileScriptCached(JSContext *ctx, const char *source, size_t size, const std::string &filename)
+{
+	const std::string key = QuickJS_BytecodeCacheKey(source, size, filename);
+	auto cachedBytecode = QuickJS_FindCachedBytecode(key);
+	if (cachedBytecode)
+	{
+		JSValue compiledObj = JS_ReadObject(ctx, cachedBytecode->data(), cachedBytecode->size(), JS_READ_OBJ_BYTECODE);
+		if (!JS_IsException(compiledObj))
+		{
+			return compiledObj;
+		}
+		// corrupt / incompatible cache entry - just compile the source
+		JS_FreeValue(ctx, JS_GetException(ctx));
+		debug(LOG_WARNING, "Discarding invalid script cache entry for: %s", filename.c_str());
+		QuickJS_InvalidateCachedBytecode(key);
+	}
+
+	JSValue compiledObj = JS_Eval_BypassLimitedContext(ctx, source, size, filename.c_str(), JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+	if (JS_IsException(compiledObj))
+	{
+		return compiledObj;
+	}
+	size_t bytecodeSize = 0;
+	uint8_t *pBytecode = JS_WriteObject(ctx, &bytecodeSize, compiledObj, JS_WRITE_OBJ_BYTECODE);
+	if (pBytecode != nullptr)
+	{
+		if (bytecodeSize <= static_cast<size_t>(std::numeric_limits<UDWORD>::max()) - 4096) // leave room for the cache file header
+		{
+			QuickJS_StoreCachedBytecode(key, std::make_shared<const std::vector<uint8_t>>(pBytecode, pBytecode + bytecodeSize));
+		}
+		js_free(ctx, pBytecode);
+	}
+	else
+	{
+		JS_FreeValue(ctx, JS_GetException(ctx));
+	}
+	return compiledObj;
+}
+
 //-- ## include(filePath)
 //--
 //-- Includes another source code file at this point. You should generally only specify the filename,
@@ -2413,7 +3338,7 @@ static JSValue js_include(JSContext *ctx, JSValueConst this_val, int argc, JSVal
 		JS_ThrowReferenceError(ctx, "Failed to read include file \"%s\"", filePath.c_str());
 		return JS_FALSE;
 	}
-	JSValue compiledFuncObj = JS_Eval_BypassLimitedContext(ctx, bytes, size, loadedFilePath.c_str(), JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+	JSValue compiledFuncObj = QuickJS_CompileScriptCached(ctx, bytes, size, loadedFilePath);
 	free(bytes);
 	if (JS_IsException(compiledFuncObj))
 	{
@@ -2781,7 +3706,7 @@ bool quickjs_scripting_instance::loadScript(const WzString& path, int player, in
 		calcDataHash(reinterpret_cast<const uint8_t *>(bytes), size, DATA_SCRIPT);
 	}
 	m_path = path.toUtf8();
-	compiledScriptObj = JS_Eval_BypassLimitedContext(ctx, bytes, size, path.toUtf8().c_str(), JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+	compiledScriptObj = QuickJS_CompileScriptCached(ctx, bytes, size, path.toUtf8());
 	free(bytes);
 	if (JS_IsException(compiledScriptObj))
 	{
@@ -2822,6 +3747,7 @@ bool quickjs_scripting_instance::readyInstanceForExecution()
 	ASSERT_OR_RETURN(false, !JS_IsUninitialized(compiledScriptObj), "compiledScriptObj is uninitialized");
 	JSValue result = JS_EvalFunction(ctx, compiledScriptObj);
 	compiledScriptObj = JS_UNINITIALIZED;
+	resolvePendingGameObjects();
 	if (JS_IsException(result))
 	{
 		// compilation error / syntax error
@@ -2868,6 +3794,42 @@ bool quickjs_scripting_instance::saveScriptGlobals(nlohmann::json &result)
 	return true;
 }
 
+bool quickjs_scripting_instance::saveScriptGlobalsBinary(ScriptStateWriter &writer)
+{
+	auto toJsonContext = JSToJsonContext(ctx, true);
+
+	// same globals as saveScriptGlobals()
+	writer.beginObject();
+	QuickJS_EnumerateObjectProperties(ctx, global_obj, [this, &writer, &toJsonContext](const char *key, JSAtom &atom) {
+		JSValue jsVal = JS_GetProperty(ctx, global_obj, atom);
+		std::string nameStr = key;
+		if (!JS_IsException(jsVal))
+		{
+			if (internalNamespace.count(nameStr) == 0 && !JS_IsFunction(ctx, jsVal)
+				&& !JS_IsConstructor(ctx, jsVal))
+			{
+				auto checkpoint = writer.checkpoint();
+				try {
+					writer.writeKey(nameStr);
+					wz_qjs_to_binary(toJsonContext, jsVal, writer);
+					ASSERT(toJsonContext.isReset(), "JSToJsonContext has non-empty stack!");
+				} catch (const std::runtime_error &e) {
+					debug(LOG_ERROR, "%s: Failed to convert global \"%s\" with error: %s", m_path.c_str(), nameStr.c_str(), e.what());
+					writer.rollback(checkpoint);
+				}
+				toJsonContext.reset();
+			}
+		}
+		else
+		{
+			debug(LOG_INFO, "Got an exception trying to get the value of \"%s\"?", nameStr.c_str());
+		}
+		JS_FreeValue(ctx, jsVal);
+	});
+	writer.end();
+	return true;
+}
+
 bool quickjs_scripting_instance::loadScriptGlobals(const nlohmann::json &result)
 {
 	ASSERT_OR_RETURN(false, result.is_object(), "Can't load script globals from non-json-object");
@@ -2991,6 +3953,7 @@ bool quickjs_scripting_instance::debugEvaluateCommand(const std::string &text)
 	}
 	JSValue result = JS_EvalFunction(ctx, compiledFuncObj);
 	compiledFuncObj = JS_UNINITIALIZED;
+	resolvePendingGameObjects();
 	if (JS_IsException(result))
 	{
 		// compilation error / syntax error
@@ -3006,6 +3969,97 @@ bool quickjs_scripting_instance::debugEvaluateCommand(const std::string &text)
 	return true;
 }
 
+// Minimum time between two profile samples - QuickJS polls the interrupt handler far more often than that
+#define PROFILE_SAMPLE_INTERVAL std::chrono::milliseconds(1)
+
+void quickjs_scripting_instance::setProfilingEnabled(bool enabled)
+{
+	profiling = enabled;
+	JS_SetInterruptHandler(rt, (enabled) ? profileInterruptHandler : nullptr, this);
+}
+
+int quickjs_scripting_instance::profileInterruptHandler(JSRuntime *rt, void *opaque)
+{
+	auto instance = static_cast<quickjs_scripting_instance *>(opaque);
+	if (instance->profileCallDepth > 0)
+	{
+		instance->profileSample();
+	}
+	return 0; // continue execution
+}
+
+static std::string profileFrameName(const char *name)
+{
+	// function names form a folded stack, so they can't contain the separators
+	std::string result = (name && *name) ? name : "<anonymous>";
+	std::replace(result.begin(), result.end(), ';', ':');
+	std::replace(result.begin(), result.end(), ' ', '_');
+	return result;
+}
+
+/// Attribute the time since the last sample to the script call stack as it is now. Time spent in native (API)
+/// functions ends up with the script function that called them, as the interrupt handler only runs in script code.
+void quickjs_scripting_instance::profileSample()
+{
+	auto now = std::chrono::steady_clock::now();
+	if (now - lastProfileSample < PROFILE_SAMPLE_INTERVAL)
+	{
+		return;
+	}
+	JSValue frames = js_debugger_build_backtrace(ctx, nullptr);
+	std::vector<std::string> names;
+	for (uint32_t i = 0; ; ++i)
+	{
+		JSValue frame = JS_GetPropertyUint32(ctx, frames, i);
+		if (!JS_IsObject(frame))
+		{
+			JS_FreeValue(ctx, frame);
+			break;
+		}
+		JSValue name = JS_GetPropertyStr(ctx, frame, "name");
+		const char *name_str = JS_ToCString(ctx, name);
+		names.push_back(profileFrameName(name_str));
+		JS_FreeCString(ctx, name_str);
+		JS_FreeValue(ctx, name);
+		JS_FreeValue(ctx, frame);
+	}
+	JS_FreeValue(ctx, frames);
+	if (names.empty())
+	{
+		return; // leave the time to profileCallEnd()
+	}
+	std::string stack;
+	for (auto it = names.rbegin(); it != names.rend(); ++it) // innermost frame comes first
+	{
+		if (!stack.empty())
+		{
+			stack += ';';
+		}
+		stack += *it;
+	}
+	profileSamples[stack] += std::chrono::duration_cast<std::chrono::microseconds>(now - lastProfileSample).count();
+	lastProfileSample = now;
+}
+
+void quickjs_scripting_instance::profileCallBegin()
+{
+	if (profileCallDepth++ == 0)
+	{
+		lastProfileSample = std::chrono::steady_clock::now();
+	}
+}
+
+void quickjs_scripting_instance::profileCallEnd(const std::string &function)
+{
+	if (--profileCallDepth > 0 || !profiling)
+	{
+		return;
+	}
+	// whatever ran since the last sample (all of it, for short calls) goes to the function that was called
+	auto now = std::chrono::steady_clock::now();
+	profileSamples[profileFrameName(function.c_str())] += std::chrono::duration_cast<std::chrono::microseconds>(now - lastProfileSample).count();
+}
+
 void quickjs_scripting_instance::updateGameTime(uint32_t newGameTime)
 {
 	int ret = JS_DefinePropertyValueStr(ctx, global_obj, "gameTime", JS_NewUint32(ctx, newGameTime), JS_PROP_WRITABLE | JS_PROP_ENUMERABLE);
@@ -3118,9 +4172,13 @@ IMPL_EVENT_HANDLER(eventBeaconRemoved, int, int)
 IMPL_EVENT_HANDLER(eventGroupLoss, const BASE_OBJECT *, int, int)
 bool quickjs_scripting_instance::handle_eventArea(const std::string& label, const DROID *psDroid)
 {
+	std::string funcname = std::string("eventArea") + label;
+	if (!hasEventHandler(funcname))
+	{
+		return true;
+	}
 	std::vector<JSValue> args;
 	args.push_back(convDroid(psDroid, ctx));
-	std::string funcname = std::string("eventArea") + label;
 	debug(LOG_SCRIPT, "Triggering %s for %s", funcname.c_str(), scriptName().c_str());
 	callFunction(ctx, funcname, args);
 	std::for_each(args.begin(), args.end(), [this](JSValue& val) { JS_FreeValue(ctx, val); });
@@ -3206,6 +4264,7 @@ IMPL_JS_FUNC(console, wzapi::console)
 IMPL_JS_FUNC(distBetweenTwoPoints, wzapi::distBetweenTwoPoints)
 IMPL_JS_FUNC(droidCanReach, wzapi::droidCanReach)
 IMPL_JS_FUNC(propulsionCanReach, wzapi::propulsionCanReach)
+IMPL_JS_FUNC(droidRouteDistance, wzapi::droidRouteDistance)
 IMPL_JS_FUNC(terrainType, wzapi::terrainType)
 IMPL_JS_FUNC(tileIsBurning, wzapi::tileIsBurning)
 IMPL_JS_FUNC(orderDroid, wzapi::orderDroid)
@@ -3596,8 +4655,9 @@ bool quickjs_scripting_instance::registerFunctions(const std::string& scriptName
 	JS_REGISTER_FUNC2(isStructureAvailable, 1, 2); // WZAPI
 	JS_REGISTER_FUNC2(pickStructLocation, 4, 5); // WZAPI
 	JS_REGISTER_FUNC2(structureCanFit, 3, 4); // WZAPI
-	JS_REGISTER_FUNC(droidCanReach, 3); // WZAPI
-	JS_REGISTER_FUNC(propulsionCanReach, 5); // WZAPI
+	JS_REGISTER_FUNC2(droidCanReach, 3, 4); // WZAPI
+	JS_REGISTER_FUNC2(propulsionCanReach, 5, 6); // WZAPI
+	JS_REGISTER_FUNC(droidRouteDistance, 3); // WZAPI
 	JS_REGISTER_FUNC(terrainType, 2); // WZAPI
 	JS_REGISTER_FUNC(tileIsBurning, 2); // WZAPI
 	JS_REGISTER_FUNC2(orderDroidBuild, 5, 6); // WZAPI
@@ -3689,8 +4749,11 @@ bool quickjs_scripting_instance::registerFunctions(const std::string& scriptName
 
 // Enable JSON support for custom types
 
+// Emits value to sink - a ScriptStateWriter or a ScriptStateJsonBuilder - so the saved binary state and the json
+// always hold the same values.
 // NOTE: May throw if there is a circular reference!
-nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
+template <typename Sink>
+static void wz_qjs_emit_value(JSToJsonContext &c, JSValue value, Sink &sink)
 {
 	// IMPORTANT: This largely follows the Qt documentation on QJsonValue::fromVariant
 	// See: http://doc.qt.io/qt-5/qjsonvalue.html#fromVariant
@@ -3703,14 +4766,23 @@ nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
 	//		 so check value.isNull() instead.
 	if (JS_IsNull(value))
 	{
-		return nlohmann::json(); // null value
+		sink.writeNull();
+		return;
 	}
 
 	if (JS_IsObject(value))
 	{
 		if (JS_IsConstructor(c.ctx, value))
 		{
-			return (!c.skip_constructors) ? "<constructor>" : nlohmann::json() /* null value */;
+			if (!c.skip_constructors)
+			{
+				sink.writeString("<constructor>");
+			}
+			else
+			{
+				sink.writeNull();
+			}
+			return;
 		}
 
 		if (std::any_of(c.stack.begin(), c.stack.end(), [ctx = c.ctx, &value](JSValue& stackVal) -> bool { return JS_SameValueZero(ctx, stackVal, value) != 0; }))
@@ -3719,60 +4791,67 @@ nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
 			throw std::runtime_error("Circular reference detected!");
 		}
 
-		nlohmann::json j;
 		c.stack.push_back(value);
 
 		if (WZ_QJS_IsArray(c.ctx, value))
 		{
 			// Handle array
-			j = nlohmann::json::array();
+			sink.beginArray();
 			uint64_t length = 0;
 			if (QuickJS_GetArrayLength(c.ctx, value, length))
 			{
 				for (uint64_t k = 0; k < length; k++) // TODO: uint64_t isn't correct here, as we call GetUint32...
 				{
 					JSValue jsVal = JS_GetPropertyUint32(c.ctx, value, k);
-					nlohmann::json jsonValue = wz_qjs_to_json(c, jsVal);
-					j.push_back(jsonValue);
-					JS_FreeValue(c.ctx, jsVal);
+					auto freeValue = gsl::finally([&c, jsVal] { JS_FreeValue(c.ctx, jsVal); }); // also if this throws
+					wz_qjs_emit_value(c, jsVal, sink);
 				}
 			}
+			sink.end();
 		}
 		else
 		{
 			// Handle actual objects
-			j = nlohmann::json::object();
-			QuickJS_EnumerateObjectProperties(c.ctx, value, [&c, value, &j](const char *key, JSAtom &atom) {
+			LazyGameObject *lazy = static_cast<LazyGameObject *>(JS_GetOpaque(value, js_gameobject_class_id));
+			if (lazy != nullptr && lazy->instance != nullptr)
+			{
+				lazy->instance->resolveGameObject(*lazy); // only own properties are enumerated
+			}
+			sink.beginObject();
+			QuickJS_EnumerateObjectProperties(c.ctx, value, [&c, value, &sink](const char *key, JSAtom &atom) {
 				JSValue jsVal = JS_GetProperty(c.ctx, value, atom);
-				std::string nameStr = key;
+				auto freeValue = gsl::finally([&c, jsVal] { JS_FreeValue(c.ctx, jsVal); }); // also if this throws
 				if (!JS_IsException(jsVal))
 				{
 					if (!JS_IsConstructor(c.ctx, jsVal))
 					{
-						j[nameStr] = wz_qjs_to_json(c, jsVal);
+						sink.writeKey(key, strlen(key));
+						wz_qjs_emit_value(c, jsVal, sink);
 					}
 					else if (!c.skip_constructors)
 					{
-						j[nameStr] = "<constructor>";
+						sink.writeKey(key, strlen(key));
+						sink.writeString("<constructor>");
 					}
 				}
 				else
 				{
-					debug(LOG_INFO, "Got an exception trying to get the value of \"%s\"?", nameStr.c_str());
+					debug(LOG_INFO, "Got an exception trying to get the value of \"%s\"?", key);
 				}
-				JS_FreeValue(c.ctx, jsVal);
 			}, false);
+			sink.end();
 		}
 
 		c.stack.pop_back();
-		return j;
+		return;
 	}
 
 	int tag = JS_VALUE_GET_NORM_TAG(value);
 	switch (tag)
 	{
 		case JS_TAG_BOOL:
-			return static_cast<bool>(JS_ToBool(c.ctx, value) != 0);
+			sink.writeBool(JS_ToBool(c.ctx, value) != 0);
+			return;
 		case JS_TAG_INT:
 		{
 			int32_t intVal = 0;
@@ -3781,7 +4860,8 @@ nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
 				// Failed
 				debug(LOG_SCRIPT, "Failed to convert to int32_t");
 			}
-			return intVal;
+			sink.writeInt(intVal);
+			return;
 		}
 		case JS_TAG_FLOAT64:
 		{
@@ -3791,41 +4871,41 @@ nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
 				// Failed
 				debug(LOG_SCRIPT, "Failed to convert to double");
 			}
-			return dblVal;
+			sink.writeDouble(dblVal);
+			return;
 		}
 		case JS_TAG_UNDEFINED:
-			return nlohmann::json(); // null value // ???
-		case JS_TAG_STRING:
-		{
-			const char* pStr = JS_ToCString(c.ctx, value);
-			auto j = json(pStr ? pStr : "");
-			JS_FreeCString(c.ctx, pStr);
-			return j;
-		}
+			sink.writeNull(); // ???
+			return;
 		default:
 		{
-			// In every other case, a conversion to a string will be attempted
+			// Strings - and in every other case, a conversion to a string will be attempted.
+			// If the returned string is empty, a null value will be stored, otherwise the string.
 			const char* pStr = JS_ToCString(c.ctx, value);
-			// If the returned string is empty, a Null QJsonValue will be stored, otherwise a String value using the returned QString.
-			auto j = nlohmann::json();
-			if (pStr)
+			size_t len = (pStr) ? strlen(pStr) : 0;
+			if (tag == JS_TAG_STRING || len > 0)
 			{
-				std::string str(pStr);
-				if (str.empty())
-				{
-					j = nlohmann::json(); // null value
-				}
-				else
-				{
-					j = str;
-				}
-				JS_FreeCString(c.ctx, pStr);
+				sink.writeString((pStr) ? pStr : "", len);
 			}
 			else
 			{
-				j = nlohmann::json(); // null value
+				sink.writeNull();
 			}
-			return j;
+			JS_FreeCString(c.ctx, pStr);
+			return;
 		}
 	}
 }
+
+// NOTE: May throw if there is a circular reference!
+nlohmann::json wz_qjs_to_json(JSToJsonContext &c, JSValue value)
+{
+	ScriptStateJsonBuilder builder;
+	wz_qjs_emit_value(c, value, builder);
+	return std::move(builder.result());
+}
+
+void wz_qjs_to_binary(JSToJsonContext &c, JSValue value, ScriptStateWriter &writer)
+{
+	wz_qjs_emit_value(c, value, writer);
+}
@@ -25,5 +25,7 @@
 
 wzapi::scripting_instance* createQuickJSScriptInstance(const WzString& path, int player, int difficulty);
 ScriptMapData runMapScript_QuickJS(WzString const &path, uint64_t seed, bool preview);
+/// Resolve any lazily-converted script objects that refer to psObj, before it goes away
+void scriptRemoveObject_QuickJS(const BASE_OBJECT *psObj);
 
 #endif
@@ -63,6 +63,7 @@
 #define RADAR_FRAME_SKIP	10
 
 static void applyMinimapOverlay();
+static void invalidateRadarTiles();
 
 bool bEnemyAllyRadarColor = false;     			/**< Enemy/ally radar color. */
 RADAR_DRAW_MODE	radarDrawMode = RADAR_MODE_DEFAULT;	/**< Current mini-map mode. */
@@ -73,6 +74,14 @@ static PIELIGHT		colRadarAlly, colRadarMe, colRadarEnemy;
 static PIELIGHT		tileColours[MAX_TILES];
 static iV_Image		radarBitmap;
 static UDWORD		*radarOverlayBuffer = nullptr;
+/// Colours of the tiles, without objects, and what they were calculated from
+static std::vector<PIELIGHT>	radarTileColours;
+static std::vector<uint64_t>	radarTileKeys;
+static uint32_t		radarTileSettings = UINT32_MAX;
+/// The objects overlay the radar bitmap currently shows
+static std::vector<UDWORD>	radarShownOverlay;
+/// Rows of the radar bitmap that changed since the last upload
+static std::vector<uint8_t>	radarChangedRows;
 static Vector3i		playerpos = {0, 0, 0};
 
 class RadarWidget : public WIDGET {
@@ -268,6 +277,10 @@ bool resizeRadar()
 	radarBitmap.allocate(radarTexWidth, radarTexHeight, 4, true);
 	radarOverlayBuffer = (uint32_t*)malloc(radarBufferSize);
 	memset(radarOverlayBuffer, 0, radarBufferSize);
+	radarTileColours.assign(radarTexWidth * radarTexHeight, WZCOL_BLACK);
+	radarShownOverlay.assign(radarTexWidth * radarTexHeight, 0);
+	radarChangedRows.assign(radarTexHeight, 1);
+	invalidateRadarTiles();
 	frameSkip = 0;
 	if (rotateRadar)
 	{
@@ -289,6 +302,10 @@ bool ShutdownRadar()
 	radarBitmap.clear();
 	free(radarOverlayBuffer);
 	radarOverlayBuffer = nullptr;
+	radarTileColours.clear();
+	radarTileKeys.clear();
+	radarShownOverlay.clear();
+	radarChangedRows.clear();
 	frameSkip = 0;
 	if (pRadarWidget)
 	{
@@ -379,7 +396,8 @@ void drawRadar()
 		DrawRadarTiles();
 		DrawRadarObjects();
 		applyMinimapOverlay();
-		pie_DownLoadRadar(radarBitmap);
+		pie_DownLoadRadarRows(radarBitmap, radarChangedRows);
+		std::fill(radarChangedRows.begin(), radarChangedRows.end(), 0);
 		frameSkip = RADAR_FRAME_SKIP;
 	}
 	frameSkip--;
@@ -494,34 +512,63 @@ static PIELIGHT inline appliedRadarColour(RADAR_DRAW_MODE drawMode, MAPTILE *WTi
 	return WScr;
 }
 
-/** Draw the map tiles on the radar. */
+static void invalidateRadarTiles()
+{
+	radarTileKeys.assign(radarTexWidth * radarTexHeight, 0);
+}
+
+/// What appliedRadarColour() depends on for a tile, other than radarTileSettings
+static inline uint64_t radarTileKey(MAPTILE *psTile)
+{
+	return (uint64_t(1) << 63)
+	       | (uint64_t(psTile->texture) << 40)
+	       | (uint64_t(psTile->height & 0xffffff) << 16)
+	       | (uint64_t(psTile->illumination) << 8)
+	       | (uint64_t(TEST_TILE_VISIBLE_TO_SELECTEDPLAYER(psTile) ? 1 : 0) << 1)
+	       | uint64_t(hasSensorOnTile(psTile, selectedPlayer) ? 1 : 0);
+}
+
+/** Update the colours of the map tiles on the radar, where anything they depend on changed. */
 static void DrawRadarTiles()
 {
-	SDWORD	x, y;
-	size_t radarBufferSize2 = radarBitmap.size_in_bytes();
-	unsigned char* pRaderBuffer = radarBitmap.bmp_w();
+	const uint32_t settings = static_cast<uint32_t>(radarDrawMode) | (getRevealStatus() ? 0x100 : 0) | (selectedPlayer << 16);
+	if (settings != radarTileSettings)
+	{
+		radarTileSettings = settings;
+		invalidateRadarTiles();
+	}
 
-	for (x = scrollMinX; x < scrollMaxX; x++)
+	const uint64_t borderKey = 1;
+	for (SDWORD y = scrollMinY; y < scrollMaxY; y++)
 	{
-		for (y = scrollMinY; y < scrollMaxY; y++)
+		const size_t rowStart = radarTexWidth * (y - scrollMinY);
+		ASSERT_OR_RETURN(, rowStart + (scrollMaxX - scrollMinX) <= radarTileKeys.size(), "Buffer overrun");
+		bool rowChanged = false;
+		for (SDWORD x = scrollMinX; x < scrollMaxX; x++)
 		{
-			MAPTILE	*psTile = mapTile(x, y);
-			size_t pixelStartPos = (radarTexWidth * (y - scrollMinY) + (x - scrollMinX)) * 4;
-
-			ASSERT(pixelStartPos < radarBufferSize2, "Buffer overrun");
+			const size_t pos = rowStart + (x - scrollMinX);
 			if (y == scrollMinY || x == scrollMinX || y == scrollMaxY - 1 || x == scrollMaxX - 1)
 			{
-				pRaderBuffer[pixelStartPos] = WZCOL_BLACK.byte.r;
-				pRaderBuffer[pixelStartPos + 1] = WZCOL_BLACK.byte.g;
-				pRaderBuffer[pixelStartPos + 2] = WZCOL_BLACK.byte.b;
-				pRaderBuffer[pixelStartPos + 3] = WZCOL_BLACK.byte.a;
+				if (radarTileKeys[pos] != borderKey)
+				{
+					radarTileKeys[pos] = borderKey;
+					radarTileColours[pos] = WZCOL_BLACK;
+					rowChanged = true;
+				}
 				continue;
 			}
-			auto radarColor = appliedRadarColour(radarDrawMode, psTile);
-			pRaderBuffer[pixelStartPos] = radarColor.byte.r;
-			pRaderBuffer[pixelStartPos + 1] = radarColor.byte.g;
-			pRaderBuffer[pixelStartPos + 2] = radarColor.byte.b;
-			pRaderBuffer[pixelStartPos + 3] = radarColor.byte.a;
+			MAPTILE	*psTile = mapTile(x, y);
+			const uint64_t key = radarTileKey(psTile);
+			if (radarTileKeys[pos] != key)
+			{
+				radarTileKeys[pos] = key;
+				radarTileColours[pos] = appliedRadarColour(radarDrawMode, psTile);
+				rowChanged = true;
+			}
+		}
+		if (rowChanged)
+		{
+			radarChangedRows[y - scrollMinY] = 1;
 		}
 	}
 }
@@ -596,9 +643,9 @@ static void DrawRadarObjects()
 	}
 
 	/* Do the same for structures */
-	for (SDWORD x = scrollMinX; x < scrollMaxX; x++)
+	for (SDWORD y = scrollMinY; y < scrollMaxY; y++)
 	{
-		for (SDWORD y = scrollMinY; y < scrollMaxY; y++)
+		for (SDWORD x = scrollMinX; x < scrollMaxX; x++)
 		{
 			MAPTILE		*psTile = mapTile(x, y);
 			STRUCTURE	*psStruct;
@@ -656,25 +703,38 @@ static void DrawRadarObjects()
 		lastBlink = gameTime;
 }
 
+/** Combine the tile colours and the objects overlay into the radar bitmap, for the rows where either changed. */
 static void applyMinimapOverlay()
 {
-	size_t radarTexCount = radarTexWidth * radarTexHeight;
 	size_t radarBufferSize2 = radarBitmap.size_in_bytes();
 	unsigned char* pRaderBuffer = radarBitmap.bmp_w();
-	ASSERT(radarTexCount * static_cast<size_t>(radarBitmap.channels()) <= radarBufferSize2, "Buffer overrun");
-	ASSERT(radarTexCount * static_cast<size_t>(radarBitmap.channels()) <= radarBufferSize, "Buffer overrun");
-	for (size_t i = 0; i < radarTexCount; i++)
+	ASSERT_OR_RETURN(, radarTexWidth * radarTexHeight * static_cast<size_t>(radarBitmap.channels()) <= radarBufferSize2, "Buffer overrun");
+	ASSERT_OR_RETURN(, radarTexWidth * radarTexHeight * sizeof(*radarOverlayBuffer) <= radarBufferSize, "Buffer overrun");
+	for (size_t y = 0; y < radarTexHeight; y++)
 	{
-		if (radarOverlayBuffer[i] == 0)
+		const size_t rowStart = y * radarTexWidth;
+		if (memcmp(&radarOverlayBuffer[rowStart], &radarShownOverlay[rowStart], radarTexWidth * sizeof(*radarOverlayBuffer)) != 0)
+		{
+			memcpy(&radarShownOverlay[rowStart], &radarOverlayBuffer[rowStart], radarTexWidth * sizeof(*radarOverlayBuffer));
+			radarChangedRows[y] = 1;
+		}
+		if (!radarChangedRows[y])
+		{
 			continue;
-		size_t pixelStartPos = (i * 4);
-		PIELIGHT baseColor = pal_RGBA(pRaderBuffer[pixelStartPos], pRaderBuffer[pixelStartPos + 1], pRaderBuffer[pixelStartPos + 2], pRaderBuffer[pixelStartPos + 3]);
-		PIELIGHT overColor = PLfromUDWORD(radarOverlayBuffer[i]);
-		PIELIGHT mixedColor = mix(overColor, baseColor);
-		pRaderBuffer[pixelStartPos] = mixedColor.byte.r;
-		pRaderBuffer[pixelStartPos + 1] = mixedColor.byte.g;
-		pRaderBuffer[pixelStartPos + 2] = mixedColor.byte.b;
-		pRaderBuffer[pixelStartPos + 3] = mixedColor.byte.a;
+		}
+		for (size_t i = rowStart; i < rowStart + radarTexWidth; i++)
+		{
+			size_t pixelStartPos = (i * 4);
+			PIELIGHT colour = radarTileColours[i];
+			if (radarOverlayBuffer[i] != 0)
+			{
+				colour = mix(PLfromUDWORD(radarOverlayBuffer[i]), colour);
+			}
+			pRaderBuffer[pixelStartPos] = colour.byte.r;
+			pRaderBuffer[pixelStartPos + 1] = colour.byte.g;
+			pRaderBuffer[pixelStartPos + 2] = colour.byte.b;
+			pRaderBuffer[pixelStartPos + 3] = colour.byte.a;
+		}
 	}
 }
 
@@ -823,6 +883,7 @@ void radarColour(UDWORD tileNumber, uint8_t r, uint8_t g, uint8_t b)
 	tileColours[tileNumber].byte.g = g;
 	tileColours[tileNumber].byte.b = b;
 	tileColours[tileNumber].byte.a = 255;
+	invalidateRadarTiles();
 }
 
 
@@ -0,0 +1,146 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file scenejobs.cpp
+ *
+ * A few long lived threads that help the main thread with the per-object work of building the 3D scene.
+ * Each frame the work is split into one contiguous range per thread, so the results stay in the order of the input.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+
+#include "scenejobs.h"
+#include "profiling.h"
+
+#include <memory>
+
+#define MAX_SCENE_THREADS 3
+
+struct SceneThreadInfo
+{
+	SceneThreadInfo()
+	{
+		semaphore = wzSemaphoreCreate(0);
+	}
+
+	~SceneThreadInfo()
+	{
+		wzSemaphoreDestroy(semaphore);
+		semaphore = nullptr;
+	}
+
+	WZ_SEMAPHORE *semaphore;
+	size_t begin = 0;
+	size_t end = 0;
+};
+
+static std::vector<WZ_THREAD *> sceneThreads;
+static std::vector<std::unique_ptr<SceneThreadInfo>> sceneThreadsInfo;
+static WZ_SEMAPHORE *sceneJobsDone = nullptr;
+static const std::function<void (size_t, size_t)> *sceneJob = nullptr;
+static volatile bool sceneQuit = false;
+
+static int sceneThreadFunc(void *data)
+{
+	SceneThreadInfo *threadInfo = static_cast<SceneThreadInfo *>(data);
+
+	while (true)
+	{
+		wzSemaphoreWait(threadInfo->semaphore);  // Wait until needed.
+		if (sceneQuit)
+		{
+			break;
+		}
+		{
+			WZ_PROFILE_SCOPE(sceneJob);
+			(*sceneJob)(threadInfo->begin, threadInfo->end);
+		}
+		wzSemaphorePost(sceneJobsDone);
+	}
+	return 0;
+}
+
+static void sceneJobsInitialise()
+{
+	const size_t logicalCPUCount = wzGetLogicalCPUCount();
+	// subtract one for the main thread
+	const size_t numThreads = (logicalCPUCount > 1) ? std::min<size_t>(logicalCPUCount - 1, MAX_SCENE_THREADS) : 0;
+	sceneQuit = false;
+	sceneJobsDone = wzSemaphoreCreate(0);
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		sceneThreadsInfo.push_back(std::make_unique<SceneThreadInfo>());
+		sceneThreads.push_back(wzThreadCreate(sceneThreadFunc, sceneThreadsInfo.back().get(), "wzScene"));
+		wzThreadStart(sceneThreads.back());
+	}
+}
+
+void sceneParallelFor(size_t count, size_t minPerJob, const std::function<void (size_t begin, size_t end)> &job)
+{
+	if (sceneJobsDone == nullptr)
+	{
+		sceneJobsInitialise();
+	}
+	minPerJob = std::max<size_t>(minPerJob, 1);
+	const size_t numJobs = std::min(sceneThreads.size() + 1, count / minPerJob);
+	if (numJobs < 2)
+	{
+		job(0, count);
+		return;
+	}
+
+	// The main thread takes the first range, the workers the rest
+	const size_t perJob = count / numJobs;
+	sceneJob = &job;
+	for (size_t i = 1; i < numJobs; ++i)
+	{
+		SceneThreadInfo &info = *sceneThreadsInfo[i - 1];
+		info.begin = i * perJob;
+		info.end = (i + 1 == numJobs) ? count : (i + 1) * perJob;
+		wzSemaphorePost(info.semaphore);
+	}
+	job(0, perJob);
+	for (size_t i = 1; i < numJobs; ++i)
+	{
+		wzSemaphoreWait(sceneJobsDone);
+	}
+	sceneJob = nullptr;
+}
+
+void sceneJobsShutdown()
+{
+	if (sceneJobsDone == nullptr)
+	{
+		return;
+	}
+	sceneQuit = true;
+	for (auto &info : sceneThreadsInfo)
+	{
+		wzSemaphorePost(info->semaphore);  // Wake up a thread
+	}
+	for (auto *thread : sceneThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	sceneThreads.clear();
+	sceneThreadsInfo.clear();
+	wzSemaphoreDestroy(sceneJobsDone);
+	sceneJobsDone = nullptr;
+}
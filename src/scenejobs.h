@@ -0,0 +1,39 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Worker threads for the per-object work of building the 3D scene.
+ */
+
+#ifndef __INCLUDED_SRC_SCENEJOBS_H__
+#define __INCLUDED_SRC_SCENEJOBS_H__
+
+#include <cstddef>
+#include <functional>
+
+/** Split [0, count) into contiguous ranges and call job(begin, end) for each, on the scene worker threads and the
+ *  calling thread, returning once all ranges are done. Runs everything on the calling thread if count is below
+ *  minPerJob * 2. job may only read shared state, and only write to the elements of its own range.
+ *  Must be called from the main thread.
+ */
+void sceneParallelFor(size_t count, size_t minPerJob, const std::function<void (size_t begin, size_t end)> &job);
+
+/** Stop the scene worker threads. */
+void sceneJobsShutdown();
+
+#endif // __INCLUDED_SRC_SCENEJOBS_H__
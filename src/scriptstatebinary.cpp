@@ -0,0 +1,488 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file scriptstatebinary.cpp
+ *
+ * Binary encoding of saved script globals.
+ *
+ * The data starts with the magic "WZSG" and a version byte, followed by the values. Each value starts with a tag byte.
+ * Integers are stored as (zigzag-encoded, if signed) LEB128 varints, doubles as their 8 little-endian bytes.
+ * A string is either a new string (its length and UTF-8 bytes - it gets the next string index), or the index of a
+ * string that came before. Arrays and objects are their values (for objects: a key string, then the value) up to an
+ * END tag.
+ */
+
+#include "lib/framework/frame.h"
+#include "scriptstatebinary.h"
+
+#include <cstring>
+
+namespace
+{
+	const char magic[4] = {'W', 'Z', 'S', 'G'};
+	const uint8_t formatVersion = 1;
+	const int maxNestingDepth = 256;
+
+	enum Tag : uint8_t
+	{
+		TAG_END = 0,
+		TAG_NULL,
+		TAG_FALSE,
+		TAG_TRUE,
+		TAG_INT,
+		TAG_UNSIGNED,
+		TAG_DOUBLE,
+		TAG_STRING_NEW,
+		TAG_STRING_REF,
+		TAG_ARRAY,
+		TAG_OBJECT
+	};
+}
+
+ScriptStateWriter::ScriptStateWriter()
+{
+	buffer.insert(buffer.end(), magic, magic + sizeof(magic));
+	buffer.push_back(formatVersion);
+}
+
+void ScriptStateWriter::writeVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		buffer.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void ScriptStateWriter::writeNull()
+{
+	writeTag(TAG_NULL);
+}
+
+void ScriptStateWriter::writeBool(bool value)
+{
+	writeTag((value) ? TAG_TRUE : TAG_FALSE);
+}
+
+void ScriptStateWriter::writeInt(int64_t value)
+{
+	writeTag(TAG_INT);
+	writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void ScriptStateWriter::writeUnsigned(uint64_t value)
+{
+	writeTag(TAG_UNSIGNED);
+	writeVarint(value);
+}
+
+void ScriptStateWriter::writeDouble(double value)
+{
+	uint64_t bits = 0;
+	static_assert(sizeof(bits) == sizeof(value), "Unexpected size of double");
+	memcpy(&bits, &value, sizeof(bits));
+	writeTag(TAG_DOUBLE);
+	for (int i = 0; i < 8; ++i)
+	{
+		buffer.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+	}
+}
+
+void ScriptStateWriter::writeString(const char *str, size_t length)
+{
+	auto result = strings.emplace(std::string(str, length), static_cast<uint32_t>(strings.size()));
+	if (!result.second)
+	{
+		writeTag(TAG_STRING_REF);
+		writeVarint(result.first->second);
+		return;
+	}
+	writeTag(TAG_STRING_NEW);
+	writeVarint(length);
+	buffer.insert(buffer.end(), str, str + length);
+}
+
+void ScriptStateWriter::beginArray()
+{
+	writeTag(TAG_ARRAY);
+}
+
+void ScriptStateWriter::beginObject()
+{
+	writeTag(TAG_OBJECT);
+}
+
+void ScriptStateWriter::end()
+{
+	writeTag(TAG_END);
+}
+
+void ScriptStateWriter::writeJson(const nlohmann::json &value)
+{
+	switch (value.type())
+	{
+		case nlohmann::json::value_t::boolean:
+			writeBool(value.get<bool>());
+			break;
+		case nlohmann::json::value_t::number_integer:
+			writeInt(value.get<int64_t>());
+			break;
+		case nlohmann::json::value_t::number_unsigned:
+			writeUnsigned(value.get<uint64_t>());
+			break;
+		case nlohmann::json::value_t::number_float:
+			writeDouble(value.get<double>());
+			break;
+		case nlohmann::json::value_t::string:
+			writeString(value.get_ref<const std::string&>());
+			break;
+		case nlohmann::json::value_t::array:
+			beginArray();
+			for (const auto &item : value)
+			{
+				writeJson(item);
+			}
+			end();
+			break;
+		case nlohmann::json::value_t::object:
+			beginObject();
+			for (auto it = value.begin(); it != value.end(); ++it)
+			{
+				writeKey(it.key());
+				writeJson(it.value());
+			}
+			end();
+			break;
+		default:
+			writeNull();
+			break;
+	}
+}
+
+ScriptStateWriter::Checkpoint ScriptStateWriter::checkpoint() const
+{
+	return {buffer.size(), static_cast<uint32_t>(strings.size())};
+}
+
+void ScriptStateWriter::rollback(const Checkpoint &point)
+{
+	buffer.resize(point.size);
+	for (auto it = strings.begin(); it != strings.end();)
+	{
+		if (it->second >= point.numStrings)
+		{
+			it = strings.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+nlohmann::json &ScriptStateJsonBuilder::put(nlohmann::json &&item)
+{
+	if (containers.empty())
+	{
+		value = std::move(item);
+		return value;
+	}
+	// Only the innermost container grows, so the pointers to the outer ones stay valid
+	nlohmann::json &container = *containers.back();
+	if (container.is_array())
+	{
+		container.push_back(std::move(item));
+		return container.back();
+	}
+	nlohmann::json &slot = container[key];
+	slot = std::move(item);
+	return slot;
+}
+
+void ScriptStateJsonBuilder::writeNull()
+{
+	put(nlohmann::json());
+}
+
+void ScriptStateJsonBuilder::writeBool(bool v)
+{
+	put(v);
+}
+
+void ScriptStateJsonBuilder::writeInt(int64_t v)
+{
+	put(v);
+}
+
+void ScriptStateJsonBuilder::writeUnsigned(uint64_t v)
+{
+	put(v);
+}
+
+void ScriptStateJsonBuilder::writeDouble(double v)
+{
+	put(v);
+}
+
+void ScriptStateJsonBuilder::writeString(const char *str, size_t length)
+{
+	put(std::string(str, length));
+}
+
+void ScriptStateJsonBuilder::beginArray()
+{
+	containers.push_back(&put(nlohmann::json::array()));
+}
+
+void ScriptStateJsonBuilder::beginObject()
+{
+	containers.push_back(&put(nlohmann::json::object()));
+}
+
+void ScriptStateJsonBuilder::writeKey(const char *str, size_t length)
+{
+	key.assign(str, length);
+}
+
+void ScriptStateJsonBuilder::end()
+{
+	ASSERT_OR_RETURN(, !containers.empty(), "end() without an array or object");
+	containers.pop_back();
+}
+
+namespace
+{
+	class ScriptStateReader
+	{
+	public:
+		ScriptStateReader(const uint8_t *data, size_t size)
+		: pos(data)
+		, endPos(data + size)
+		{ }
+
+		bool atEnd() const { return pos == endPos; }
+
+		bool readHeader()
+		{
+			if (endPos - pos < static_cast<ptrdiff_t>(sizeof(magic) + 1) || memcmp(pos, magic, sizeof(magic)) != 0)
+			{
+				return false;
+			}
+			pos += sizeof(magic);
+			return *pos++ == formatVersion;
+		}
+
+		bool readValue(nlohmann::json &result, int depth = 0)
+		{
+			uint8_t tag;
+			return readTag(tag) && readValue(tag, result, depth);
+		}
+
+	private:
+		bool readTag(uint8_t &tag)
+		{
+			if (pos == endPos)
+			{
+				return false;
+			}
+			tag = *pos++;
+			return true;
+		}
+
+		bool readVarint(uint64_t &value)
+		{
+			value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				if (pos == endPos)
+				{
+					return false;
+				}
+				uint8_t byte = *pos++;
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool readString(uint8_t tag, std::string &result)
+		{
+			uint64_t value = 0;
+			if (!readVarint(value))
+			{
+				return false;
+			}
+			if (tag == TAG_STRING_REF)
+			{
+				if (value >= strings.size())
+				{
+					return false;
+				}
+				result = strings[value];
+				return true;
+			}
+			if (value > static_cast<uint64_t>(endPos - pos))
+			{
+				return false;
+			}
+			result.assign(reinterpret_cast<const char *>(pos), value);
+			pos += value;
+			strings.push_back(result);
+			return true;
+		}
+
+		bool readValue(uint8_t tag, nlohmann::json &result, int depth)
+		{
+			if (depth > maxNestingDepth)
+			{
+				return false;
+			}
+			switch (tag)
+			{
+				case TAG_NULL:
+					result = nlohmann::json();
+					return true;
+				case TAG_FALSE:
+				case TAG_TRUE:
+					result = (tag == TAG_TRUE);
+					return true;
+				case TAG_INT:
+				{
+					uint64_t value = 0;
+					if (!readVarint(value))
+					{
+						return false;
+					}
+					result = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+					return true;
+				}
+				case TAG_UNSIGNED:
+				{
+					uint64_t value = 0;
+					if (!readVarint(value))
+					{
+						return false;
+					}
+					result = value;
+					return true;
+				}
+				case TAG_DOUBLE:
+				{
+					if (endPos - pos < 8)
+					{
+						return false;
+					}
+					uint64_t bits = 0;
+					for (int i = 0; i < 8; ++i)
+					{
+						bits |= static_cast<uint64_t>(*pos++) << (i * 8);
+					}
+					double value;
+					memcpy(&value, &bits, sizeof(value));
+					result = value;
+					return true;
+				}
+				case TAG_STRING_NEW:
+				case TAG_STRING_REF:
+				{
+					std::string value;
+					if (!readString(tag, value))
+					{
+						return false;
+					}
+					result = std::move(value);
+					return true;
+				}
+				case TAG_ARRAY:
+				{
+					result = nlohmann::json::array();
+					uint8_t itemTag;
+					while (readTag(itemTag))
+					{
+						if (itemTag == TAG_END)
+						{
+							return true;
+						}
+						nlohmann::json item;
+						if (!readValue(itemTag, item, depth + 1))
+						{
+							return false;
+						}
+						result.push_back(std::move(item));
+					}
+					return false;
+				}
+				case TAG_OBJECT:
+				{
+					result = nlohmann::json::object();
+					uint8_t keyTag;
+					std::string key;
+					while (readTag(keyTag))
+					{
+						if (keyTag == TAG_END)
+						{
+							return true;
+						}
+						if ((keyTag != TAG_STRING_NEW && keyTag != TAG_STRING_REF) || !readString(keyTag, key))
+						{
+							return false;
+						}
+						if (!readValue(result[key], depth + 1))
+						{
+							return false;
+						}
+					}
+					return false;
+				}
+				default:
+					return false;
+			}
+		}
+
+		const uint8_t *pos;
+		const uint8_t *endPos;
+		std::vector<std::string> strings;
+	};
+}
+
+bool readScriptStateBlocks(const uint8_t *data, size_t size, std::vector<nlohmann::json> &blocks)
+{
+	ScriptStateReader reader(data, size);
+	if (!reader.readHeader())
+	{
+		debug(LOG_ERROR, "Not a script state file, or an unsupported version");
+		return false;
+	}
+	blocks.clear();
+	while (!reader.atEnd())
+	{
+		nlohmann::json block;
+		if (!reader.readValue(block))
+		{
+			debug(LOG_ERROR, "Corrupt script state data (after %zu values)", blocks.size());
+			return false;
+		}
+		blocks.push_back(std::move(block));
+	}
+	return true;
+}
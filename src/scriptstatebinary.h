@@ -0,0 +1,108 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2025  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef __INCLUDED_SRC_SCRIPTSTATEBINARY_H__
+#define __INCLUDED_SRC_SCRIPTSTATEBINARY_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+/// Writes json-like values (as script globals are saved in) to a compact binary buffer, without building a json document.
+/// Every distinct string (values and object keys) is stored once, later uses refer back to it.
+/// The buffer holds a sequence of values ("blocks"), see readScriptStateBlocks().
+class ScriptStateWriter
+{
+public:
+	ScriptStateWriter();
+
+	void writeNull();
+	void writeBool(bool value);
+	void writeInt(int64_t value);
+	void writeUnsigned(uint64_t value);
+	void writeDouble(double value);
+	void writeString(const char *str, size_t length);
+	void writeString(const std::string &str) { writeString(str.data(), str.size()); }
+
+	/// Start an array; write its values, then call end()
+	void beginArray();
+	/// Start an object; write key and value for each property, then call end()
+	void beginObject();
+	void writeKey(const char *str, size_t length) { writeString(str, length); }
+	void writeKey(const std::string &str) { writeString(str.data(), str.size()); }
+	void end();
+
+	void writeJson(const nlohmann::json &value);
+
+	/// Allows discarding everything written after a point (such as a value that turned out not to be convertible)
+	struct Checkpoint
+	{
+		size_t size;
+		uint32_t numStrings;
+	};
+	Checkpoint checkpoint() const;
+	void rollback(const Checkpoint &point);
+
+	const std::vector<uint8_t>& data() const { return buffer; }
+
+private:
+	void writeTag(uint8_t tag) { buffer.push_back(tag); }
+	void writeVarint(uint64_t value);
+
+	std::vector<uint8_t> buffer;
+	std::unordered_map<std::string, uint32_t> strings;
+};
+
+/// Builds the json value for the same calls a ScriptStateWriter takes, so a traversal that emits values one at a time
+/// can target either of them (and produce the same values).
+class ScriptStateJsonBuilder
+{
+public:
+	void writeNull();
+	void writeBool(bool value);
+	void writeInt(int64_t value);
+	void writeUnsigned(uint64_t value);
+	void writeDouble(double value);
+	void writeString(const char *str, size_t length);
+	void writeString(const std::string &str) { writeString(str.data(), str.size()); }
+
+	void beginArray();
+	void beginObject();
+	void writeKey(const char *str, size_t length);
+	void writeKey(const std::string &str) { writeKey(str.data(), str.size()); }
+	void end();
+
+	/// The last top-level value written
+	nlohmann::json &result() { return value; }
+
+private:
+	nlohmann::json &put(nlohmann::json &&item);
+
+	nlohmann::json value;
+	std::vector<nlohmann::json *> containers; ///< The arrays and objects not yet ended, innermost last
+	std::string key;
+};
+
+/// Decode all values written by a ScriptStateWriter. Returns false if the data is not valid.
+bool readScriptStateBlocks(const uint8_t *data, size_t size, std::vector<nlohmann::json> &blocks);
+
+#endif // __INCLUDED_SRC_SCRIPTSTATEBINARY_H__
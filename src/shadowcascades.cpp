@@ -58,6 +58,9 @@
 
 float cascadeSplitLambda = 0.3f;
 
+// A cascade only moves once the camera moved its size / CASCADE_SNAP_DIVISIONS, so its shadow map can often be reused
+#define CASCADE_SNAP_DIVISIONS 16.f
+
 void calculateShadowCascades(const iView *player, float terrainDistance, const glm::mat4& baseViewMatrix, const glm::vec3& lightInvDir, size_t SHADOW_MAP_CASCADE_COUNT, std::vector<Cascade>& output)
 {
 	WZ_PROFILE_SCOPE(calculateShadowCascades);
@@ -133,12 +136,24 @@ void calculateShadowCascades(const iView *player, float terrainDistance, const g
 			float distance2 = glm::length(frustumCorners[i] - frustumCenter);
 			radius = glm::max(radius, distance2);
 		}
-		radius = std::ceil(radius * 16.0f) / 16.0f;
+		// Round the radius up to one of CASCADE_SNAP_DIVISIONS steps per power of 2, and snap the centre (in light space) to a
+		// grid of snapStep, growing the extents by one step so the split still fits
+		const float radiusStep = std::exp2(std::floor(std::log2(std::max(radius, 1.f)))) / CASCADE_SNAP_DIVISIONS;
+		radius = std::ceil(radius / radiusStep) * radiusStep;
+		const float snapStep = radius / CASCADE_SNAP_DIVISIONS;
 
-		glm::vec3 maxExtents = glm::vec3(radius);
+		glm::vec3 maxExtents = glm::vec3(radius + snapStep);
 		glm::vec3 minExtents = -maxExtents;
 
 		glm::vec3 lightDir = normalize(lightInvDir); //normalize(-lightPos);
+		const glm::mat4 lightRotation = glm::lookAt(lightDir, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(frustumCenter, 1.0f));
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			lightSpaceCenter[axis] = std::floor(lightSpaceCenter[axis] / snapStep + 0.5f) * snapStep;
+		}
+		frustumCenter = glm::vec3(glm::inverse(lightRotation) * glm::vec4(lightSpaceCenter, 1.0f));
+
 		glm::mat4 lightViewMatrix = glm::lookAt(frustumCenter + lightDir, frustumCenter, glm::vec3(0.0f, 1.0f, 0.0f));
 		glm::mat4 lightProjectionMatrix = glm::ortho(minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, minExtents.z, maxExtents.z) * glm::scale(glm::vec3(1.f, 1.f, -1.f));
 
@@ -150,3 +165,27 @@ void calculateShadowCascades(const iView *player, float terrainDistance, const g
 		lastSplitDist = cascadeSplits[iSplit];
 	}
 }
+
+bool ShadowCascadeCache::needsUpdate(size_t idx, const Cascade& cascade, uint64_t contentSignature)
+{
+	if (idx >= entries.size())
+	{
+		entries.resize(idx + 1);
+	}
+	Entry &entry = entries[idx];
+	if (entry.valid && entry.contentSignature == contentSignature
+		&& entry.viewMatrix == cascade.viewMatrix && entry.projectionMatrix == cascade.projectionMatrix)
+	{
+		return false;
+	}
+	entry.valid = true;
+	entry.contentSignature = contentSignature;
+	entry.viewMatrix = cascade.viewMatrix;
+	entry.projectionMatrix = cascade.projectionMatrix;
+	return true;
+}
+
+void ShadowCascadeCache::clear()
+{
+	entries.clear();
+}
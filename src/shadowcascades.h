@@ -33,5 +33,26 @@ struct Cascade
 	glm::mat4 projectionMatrix;
 };
 
+// Remembers what was last rendered into the shadow map of each cascade, so cascades that did not change need not be
+// rendered again
+class ShadowCascadeCache
+{
+public:
+	// Whether cascade idx needs to be rendered, given a signature of everything that would be drawn into it.
+	// If so, it is assumed to be rendered right after.
+	bool needsUpdate(size_t idx, const Cascade& cascade, uint64_t contentSignature);
+	void clear();
+
+private:
+	struct Entry
+	{
+		bool valid = false;
+		uint64_t contentSignature = 0;
+		glm::mat4 viewMatrix;
+		glm::mat4 projectionMatrix;
+	};
+	std::vector<Entry> entries;
+};
+
 void calculateShadowCascades(const iView *player, float terrainDistance, const glm::mat4& baseViewMatrix, const glm::vec3& lightInvDir, size_t SHADOW_MAP_CASCADE_COUNT, std::vector<Cascade>& output);
 
@@ -31,6 +31,7 @@
 #include "main.h"
 #include "multivote.h"
 #include "hci/teamstrategy.h"
+#include "qtscript.h"
 
 #include <string>
 #include <atomic>
@@ -1233,6 +1234,44 @@ int cmdInputThreadFunc(void *)
 				});
 			}
 		}
+		else if(!strncmpl(line, "profile scripts "))
+		{
+			char action[16] = {};
+			int r = sscanf(line, "profile scripts %15s", action);
+			if (r != 1)
+			{
+				wz_command_interface_output_onmainthread("WZCMD error: Failed to get profile scripts action!\n");
+				continue;
+			}
+			std::string actionStr = action;
+			if (actionStr != "start" && actionStr != "stop" && actionStr != "reset" && actionStr != "save")
+			{
+				wz_command_interface_output_onmainthread("WZCMD error: Unsupported profile scripts action!\n");
+				continue;
+			}
+			wzAsyncExecOnMainThread([actionStr] {
+				if (actionStr == "start" || actionStr == "stop")
+				{
+					jsSetProfiling(actionStr == "start");
+					wz_command_interface_output("WZCMD info: Script profiling %s\n", (jsProfilingEnabled()) ? "started" : "stopped");
+				}
+				else if (actionStr == "reset")
+				{
+					jsResetProfile();
+					wz_command_interface_output("WZCMD info: Script profile reset\n");
+				}
+				else
+				{
+					std::string filename = jsSaveProfile();
+					if (filename.empty())
+					{
+						wz_command_interface_output("WZCMD error: Failed to save script profile\n");
+						return;
+					}
+					wz_command_interface_output("WZCMD info: Script profile saved to: %s\n", filename.c_str());
+				}
+			});
+		}
 		else if(!strncmpl(line, "shutdown now"))
 		{
 			inexit = true;
@@ -84,6 +84,8 @@
 #include "random.h"
 #include <functional>
 #include <unordered_map>
+#include <array>
+#include <vector>
 
 //Maximium slope of the terrain for building a structure
 #define MAX_INCLINE		50//80//40
@@ -1636,6 +1638,7 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 				// We now know the previous loop didn't return early, so it is safe to save references to `stableBuilding` now.
 				MAPTILE *psTile = mapTile(tileX, tileY);
 				psTile->psObject = psBuilding;
+				invalidateBuildableTile(tileX, tileY);
 
 				// if it's a tall structure then flag it in the map.
 				if (psBuilding->sDisplay.imd && psBuilding->sDisplay.imd->max.y > TALLOBJECT_YMAX)
@@ -4271,6 +4274,211 @@ bool isBlueprintTooClose(STRUCTURE_STATS const *stats1, Vector2i pos1, uint16_t
 	return dist < minDist;
 }
 
+// Summed-area table of the gateway tiles, rebuilt on demand once the gateways have changed
+struct BuildableAreaTable
+{
+	uint32_t generation = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<uint32_t> sums; ///< (width + 1) * (height + 1) entries; sums[y * (width + 1) + x] counts the tiles in (0, 0) - (x, y), exclusive
+
+	template <typename Predicate>
+	void update(uint32_t newGeneration, Predicate blocked)
+	{
+		if (generation == newGeneration && width == mapWidth && height == mapHeight)
+		{
+			return;
+		}
+		generation = newGeneration;
+		width = mapWidth;
+		height = mapHeight;
+		sums.assign((width + 1) * (height + 1), 0);
+		for (int y = 0; y < height; ++y)
+		{
+			uint32_t rowSum = 0;
+			for (int x = 0; x < width; ++x)
+			{
+				rowSum += blocked(mapTile(x, y)) ? 1 : 0;
+				sums[(y + 1) * (width + 1) + x + 1] = sums[y * (width + 1) + x + 1] + rowSum;
+			}
+		}
+	}
+
+	void reset()
+	{
+		generation = 0;
+		width = 0;
+		height = 0;
+		sums.clear();
+	}
+
+	/// Number of blocked tiles in (x1, y1) - (x2, y2), exclusive, clipped to the map
+	uint32_t count(int x1, int y1, int x2, int y2) const
+	{
+		x1 = clip(x1, 0, width);
+		y1 = clip(y1, 0, height);
+		x2 = clip(x2, x1, width);
+		y2 = clip(y2, y1, height);
+		return sums[y2 * (width + 1) + x2] - sums[y1 * (width + 1) + x2] - sums[y2 * (width + 1) + x1] + sums[y1 * (width + 1) + x1];
+	}
+};
+
+static uint32_t blockedRowsGeneration = 0;
+static std::vector<uint32_t> blockedRowChanged; ///< Value of blockedRowsGeneration when each map row last changed
+
+// Per row prefix sums of tiles where no structure can be built. Objects come and go all the time, so only the rows
+// that changed since the last query are counted again.
+struct BlockedRowsTable
+{
+	bool valid = false; ///< Cleared by resetBuildableAreas() whenever the map is replaced
+	uint32_t generation = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<uint32_t> sums; ///< height * (width + 1) entries; sums[y * (width + 1) + x] counts the tiles in row y left of x
+
+	template <typename Predicate>
+	void update(Predicate blocked)
+	{
+		const bool rebuildAll = !valid || width != mapWidth || height != mapHeight;
+		if (!rebuildAll && generation == blockedRowsGeneration)
+		{
+			return;
+		}
+		if (rebuildAll)
+		{
+			valid = true;
+			width = mapWidth;
+			height = mapHeight;
+			sums.assign(height * (width + 1), 0);
+		}
+		for (int y = 0; y < height; ++y)
+		{
+			if (!rebuildAll && (y >= static_cast<int>(blockedRowChanged.size()) || blockedRowChanged[y] <= generation))
+			{
+				continue;
+			}
+			uint32_t *row = &sums[y * (width + 1)];
+			for (int x = 0; x < width; ++x)
+			{
+				row[x + 1] = row[x] + (blocked(mapTile(x, y)) ? 1 : 0);
+			}
+		}
+		generation = blockedRowsGeneration;
+	}
+
+	void reset()
+	{
+		valid = false;
+		generation = 0;
+		width = 0;
+		height = 0;
+		sums.clear();
+	}
+
+	/// Number of blocked tiles in (x1, y1) - (x2, y2), exclusive, clipped to the map
+	uint32_t count(int x1, int y1, int x2, int y2) const
+	{
+		x1 = clip(x1, 0, width);
+		y1 = clip(y1, 0, height);
+		x2 = clip(x2, x1, width);
+		y2 = clip(y2, y1, height);
+		uint32_t total = 0;
+		for (int y = y1; y < y2; ++y)
+		{
+			total += sums[y * (width + 1) + x2] - sums[y * (width + 1) + x1];
+		}
+		return total;
+	}
+};
+
+static uint32_t gatewayAreaGeneration = 1;
+static BuildableAreaTable gatewayArea;
+static std::array<BlockedRowsTable, MAX_PLAYERS> blockedArea;
+
+void invalidateBuildableTile(int x, int y)
+{
+	if (y < 0 || y >= mapHeight)
+	{
+		return;
+	}
+	if (blockedRowChanged.size() < static_cast<size_t>(mapHeight))
+	{
+		blockedRowChanged.resize(mapHeight, 0);
+	}
+	blockedRowChanged[y] = ++blockedRowsGeneration;
+}
+
+void invalidateBuildableGateways()
+{
+	++gatewayAreaGeneration;
+}
+
+void resetBuildableAreas()
+{
+	gatewayArea.reset();
+	for (BlockedRowsTable &table : blockedArea)
+	{
+		table.reset();
+	}
+	blockedRowChanged.clear();
+	blockedRowsGeneration = 0;
+}
+
+bool buildableAreaHasGateway(int x1, int y1, int x2, int y2)
+{
+	gatewayArea.update(gatewayAreaGeneration, [](const MAPTILE *psTile) {
+		return (psTile->tileInfoBits & BITS_GATEWAY) != 0;
+	});
+	return gatewayArea.count(x1, y1, x2 + 1, y2 + 1) > 0;
+}
+
+bool buildableAreaMayFit(const STRUCTURE_STATS *psStats, int x, int y, unsigned player)
+{
+	ASSERT_OR_RETURN(false, player < MAX_PLAYERS, "player (%u) >= MAX_PLAYERS", player);
+
+	switch (psStats->type)
+	{
+	case REF_HQ:
+	case REF_FACTORY:
+	case REF_LAB:
+	case REF_RESEARCH:
+	case REF_POWER_GEN:
+	case REF_WALL:
+	case REF_WALLCORNER:
+	case REF_GATE:
+	case REF_DEFENSE:
+	case REF_REPAIR_FACILITY:
+	case REF_COMMAND_CONTROL:
+	case REF_CYBORG_FACTORY:
+	case REF_VTOL_FACTORY:
+	case REF_GENERIC:
+	case REF_REARM_PAD:
+	case REF_MISSILE_SILO:
+	case REF_SAT_UPLINK:
+	case REF_LASSAT:
+	case REF_FORTRESS:
+		break;
+	default:
+		return true; // modules and derricks go on top of something, so are left to validLocation()
+	}
+
+	if (x < 0 || y < 0 || x + psStats->baseWidth > mapWidth || y + psStats->baseBreadth > mapHeight)
+	{
+		return false;
+	}
+
+	// The tiles validLocation() rejects regardless of visibility and alliances: water, cliffs, features, and our own non-wall structures
+	BlockedRowsTable &table = blockedArea[player];
+	table.update([player](const MAPTILE *psTile) {
+		if (terrainType(psTile) == TER_WATER || terrainType(psTile) == TER_CLIFFFACE || TileHasFeature(psTile))
+		{
+			return true;
+		}
+		return TileHasStructure(psTile) && ((STRUCTURE *)psTile->psObject)->player == player && !TileHasWall(psTile);
+	});
+	return table.count(x, y, x + psStats->baseWidth, y + psStats->baseBreadth) == 0;
+}
+
 bool validLocation(BASE_STATS *psStats, Vector2i pos, uint16_t direction, unsigned player, bool bCheckBuildQueue)
 {
 	ASSERT_OR_RETURN(false, player < MAX_PLAYERS, "player (%u) >= MAX_PLAYERS", player);
@@ -4553,6 +4761,7 @@ static void removeStructFromMap(STRUCTURE *psStruct)
 			if (psTile->psObject == psStruct)
 			{
 				psTile->psObject = nullptr;
+				invalidateBuildableTile(b.map.x + i, b.map.y + j);
 				auxClearBlocking(b.map.x + i, b.map.y + j, AIR_BLOCKED);
 			}
 		}
@@ -7224,7 +7433,7 @@ bool writeFavoriteStructsFile(const char* path)
 	}
 	root["favoriteStructures"] = std::move(structsArray);
 
-	return saveJSONToFile(root, path);
+	return saveJSONToFile(std::move(root), path);
 }
 
 static void parseFavoriteStructs()
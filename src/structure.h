@@ -133,6 +133,19 @@ bool isBlueprintTooClose(STRUCTURE_STATS const *stats1, Vector2i pos1, uint16_t
 /// pos in world coords
 bool validLocation(BASE_STATS *psStats, Vector2i pos, uint16_t direction, unsigned player, bool bCheckBuildQueue);
 
+/// Quick pre-check for validLocation() and the like, using cached summed-area tables of the map:
+/// returns false if a structure of psStats placed (unrotated) with its top left corner at tile (x, y) certainly
+/// can't be built by player, because of the terrain or the known objects under it. true means "maybe".
+bool buildableAreaMayFit(const STRUCTURE_STATS *psStats, int x, int y, unsigned player);
+/// Whether any tile in (x1, y1) - (x2, y2), inclusive, is part of a gateway
+bool buildableAreaHasGateway(int x1, int y1, int x2, int y2);
+/// Must be called whenever the terrain of a tile or the object recorded on it changes
+void invalidateBuildableTile(int x, int y);
+/// Must be called whenever gateways are added or removed
+void invalidateBuildableGateways();
+/// Must be called whenever the map is loaded, released or swapped with the mission map
+void resetBuildableAreas();
+
 bool isWall(STRUCTURE_TYPE type);                                    ///< Structure is a wall. Not completely sure it handles all cases.
 bool isBuildableOnWalls(STRUCTURE_TYPE type);                        ///< Structure can be built on walls. Not completely sure it handles all cases.
 
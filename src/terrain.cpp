@@ -133,6 +133,19 @@ struct LightmapCalculatedValues
 static LightmapCalculatedValues lightmapValues;
 /// Ticks per lightmap refresh
 static const unsigned int LIGHTMAP_REFRESH = 80;
+/// The lightmap is updated in blocks of (1 << LIGHTMAP_BLOCK_SHIFT)^2 tiles, only where something changed
+#define LIGHTMAP_BLOCK_SHIFT 4
+static int lightmapBlocksX = 0, lightmapBlocksY = 0;
+static std::vector<uint8_t> lightmapDirtyBlocks;
+/// Changes whenever the terrain geometry that gets drawn changes
+static uint64_t terrainGeometryGeneration = 0;
+/// Blocks with marked tiles, which pulse, so need updating every refresh
+static std::vector<uint8_t> lightmapMarkedBlocks;
+/// Things that change the whole lightmap
+static bool lightmapLastFogStatus = false;
+static bool lightmapLastShowGateways = false;
+/// Last area the edge fade was applied around, when fog is off
+static int lightmapFadeX1 = 0, lightmapFadeY1 = 0, lightmapFadeX2 = -1, lightmapFadeY2 = -1;
 
 /// VBOs
 static gfx_api::buffer *geometryVBO = nullptr, *geometryIndexVBO = nullptr;
@@ -927,6 +940,8 @@ bool initTerrain()
 	int maxSectorSizeIndices, maxSectorSizeVertices;
 	bool decreasedSize = false;
 
+	++terrainGeometryGeneration;
+
 	// this information is useful to prevent crashes with buggy opengl implementations
 	GLmaxElementsVertices = gfx_api::context::get().get_context_value(gfx_api::context::context_value::MAX_ELEMENTS_VERTICES);
 	GLmaxElementsIndices = gfx_api::context::get().get_context_value(gfx_api::context::context_value::MAX_ELEMENTS_INDICES);
@@ -1172,6 +1187,15 @@ bool initTerrain()
 	lightmap_texture = gfx_api::context::get().create_texture(1, lightmapPixmap->width(), lightmapPixmap->height(), lightmapPixmap->pixel_format(), "mem::lightmap");
 
 	lightmap_texture->upload(0, *(lightmapPixmap.get()));
+
+	lightmapBlocksX = (mapWidth + (1 << LIGHTMAP_BLOCK_SHIFT) - 1) >> LIGHTMAP_BLOCK_SHIFT;
+	lightmapBlocksY = (mapHeight + (1 << LIGHTMAP_BLOCK_SHIFT) - 1) >> LIGHTMAP_BLOCK_SHIFT;
+	lightmapDirtyBlocks.assign(static_cast<size_t>(lightmapBlocksX) * lightmapBlocksY, 1);
+	lightmapMarkedBlocks.assign(static_cast<size_t>(lightmapBlocksX) * lightmapBlocksY, 0);
+	lightmapLastFogStatus = pie_GetFogStatus();
+	lightmapLastShowGateways = showGateways;
+	lightmapFadeX1 = lightmapFadeY1 = 0;
+	lightmapFadeX2 = lightmapFadeY2 = -1;
 	terrainInitialised = true;
 
 	return true;
@@ -1196,6 +1220,9 @@ void shutdownTerrain()
 	delete lightmap_texture;
 	lightmap_texture = nullptr;
 	lightmapPixmap = nullptr;
+	lightmapDirtyBlocks.clear();
+	lightmapMarkedBlocks.clear();
+	lightmapBlocksX = lightmapBlocksY = 0;
 
 	delete groundTexArr; groundTexArr = nullptr;
 	delete groundNormalArr; groundNormalArr = nullptr;
@@ -1214,13 +1241,42 @@ void shutdownTerrain()
 	terrainInitialised = false;
 }
 
-static void updateLightMap(const LightMap& lightmap)
+void markLightmapDirty(int x1, int y1, int x2, int y2)
+{
+	if (lightmapDirtyBlocks.empty())
+	{
+		return; // will be updated anyway
+	}
+	x1 = std::max(x1, 0) >> LIGHTMAP_BLOCK_SHIFT;
+	y1 = std::max(y1, 0) >> LIGHTMAP_BLOCK_SHIFT;
+	x2 = std::min(x2 >> LIGHTMAP_BLOCK_SHIFT, lightmapBlocksX - 1);
+	y2 = std::min(y2 >> LIGHTMAP_BLOCK_SHIFT, lightmapBlocksY - 1);
+	for (int y = y1; y <= y2; ++y)
+	{
+		for (int x = x1; x <= x2; ++x)
+		{
+			lightmapDirtyBlocks[x + y * lightmapBlocksX] = 1;
+		}
+	}
+}
+
+void dirtyAllLightmap()
+{
+	std::fill(lightmapDirtyBlocks.begin(), lightmapDirtyBlocks.end(), 1);
+}
+
+/// Write the lightmap texels of the tiles x1 <= i < x2, y1 <= j < y2. Returns whether any of them are marked.
+static bool updateLightMapArea(const LightMap& lightmap, int x1, int y1, int x2, int y2)
 {
 	size_t lightmapChannels = lightmapPixmap->channels(); // should always be 4 now...
 	unsigned char* lightMapWritePtr = lightmapPixmap->bmp_w();
-	for (int j = 0; j < mapHeight; ++j)
+	const bool fadeEdges = !pie_GetFogStatus();
+	const float playerX = map_coordf(playerPos.p.x);
+	const float playerY = map_coordf(playerPos.p.z);
+	bool anyMarked = false;
+	for (int j = y1; j < y2; ++j)
 	{
-		for (int i = 0; i < mapWidth; ++i)
+		for (int i = x1; i < x2; ++i)
 		{
 			MAPTILE *psTile = mapTile(i, j);
 			PIELIGHT colour = lightmap(i, j);
@@ -1235,6 +1291,7 @@ static void updateLightMap(const LightMap& lightmap)
 				int m = getModularScaledGraphicsTime(2048, 255);
 				colour.byte.r = MAX(m, 255 - m);
 				level = std::max<UBYTE>(level, colour.byte.r / 2);
+				anyMarked = true;
 			}
 
 			lightMapWritePtr[(i + j * lightmapWidth) * lightmapChannels + 0] = colour.byte.r;
@@ -1245,12 +1302,9 @@ static void updateLightMap(const LightMap& lightmap)
 			// (For more, see avUpdateTiles() and getTileIllumination())
 			lightMapWritePtr[(i + j * lightmapWidth) * lightmapChannels + 3] = level;
 
-			if (!pie_GetFogStatus())
+			if (fadeEdges)
 			{
 				// fade to black at the edges of the visible terrain area
-				const float playerX = map_coordf(playerPos.p.x);
-				const float playerY = map_coordf(playerPos.p.z);
-
 				const float distA = i - (playerX - visibleTiles.x / 2);
 				const float distB = (playerX + visibleTiles.x / 2) - i;
 				const float distC = j - (playerY - visibleTiles.y / 2);
@@ -1291,10 +1345,88 @@ static void updateLightMap(const LightMap& lightmap)
 			}
 		}
 	}
+	return anyMarked;
+}
+
+/// Mark what changed since the last refresh, other than what the rest of the game marks itself
+static void markLightmapChanges()
+{
+	const bool fogStatus = pie_GetFogStatus();
+	if (fogStatus != lightmapLastFogStatus || showGateways != lightmapLastShowGateways)
+	{
+		lightmapLastFogStatus = fogStatus;
+		lightmapLastShowGateways = showGateways;
+		dirtyAllLightmap();
+	}
+	if (!fogStatus)
+	{
+		// The edge fade moves with the camera, so update both where it was and where it is now
+		const float playerX = map_coordf(playerPos.p.x);
+		const float playerY = map_coordf(playerPos.p.z);
+		const int fadeX1 = static_cast<int>(floorf(playerX - visibleTiles.x / 2)) - 1;
+		const int fadeY1 = static_cast<int>(floorf(playerY - visibleTiles.y / 2)) - 1;
+		const int fadeX2 = static_cast<int>(ceilf(playerX + visibleTiles.x / 2)) + 1;
+		const int fadeY2 = static_cast<int>(ceilf(playerY + visibleTiles.y / 2)) + 1;
+		markLightmapDirty(fadeX1, fadeY1, fadeX2, fadeY2);
+		markLightmapDirty(lightmapFadeX1, lightmapFadeY1, lightmapFadeX2, lightmapFadeY2);
+		lightmapFadeX1 = fadeX1;
+		lightmapFadeY1 = fadeY1;
+		lightmapFadeX2 = fadeX2;
+		lightmapFadeY2 = fadeY2;
+	}
+	for (size_t i = 0; i < lightmapMarkedBlocks.size(); ++i)
+	{
+		lightmapDirtyBlocks[i] |= lightmapMarkedBlocks[i];
+	}
+}
+
+/// Rewrite and upload the dirty blocks of the lightmap, in runs of consecutive blocks per row of blocks
+static void updateLightMap(const LightMap& lightmap)
+{
+	markLightmapChanges();
+
+	const size_t lightmapChannels = lightmapPixmap->channels();
+	const int blockSize = 1 << LIGHTMAP_BLOCK_SHIFT;
+	static iV_Image subImage;
+	for (int by = 0; by < lightmapBlocksY; ++by)
+	{
+		for (int bx = 0; bx < lightmapBlocksX;)
+		{
+			if (!lightmapDirtyBlocks[bx + by * lightmapBlocksX])
+			{
+				++bx;
+				continue;
+			}
+			const int runStart = bx;
+			for (; bx < lightmapBlocksX && lightmapDirtyBlocks[bx + by * lightmapBlocksX]; ++bx)
+			{
+				const int x1 = bx * blockSize, y1 = by * blockSize;
+				const bool marked = updateLightMapArea(lightmap, x1, y1, std::min(x1 + blockSize, mapWidth), std::min(y1 + blockSize, mapHeight));
+				lightmapMarkedBlocks[bx + by * lightmapBlocksX] = marked;
+				lightmapDirtyBlocks[bx + by * lightmapBlocksX] = 0;
+			}
+
+			const int x1 = runStart * blockSize, y1 = by * blockSize;
+			const int width = std::min(bx * blockSize, mapWidth) - x1, height = std::min(y1 + blockSize, mapHeight) - y1;
+			if (!subImage.allocate(width, height, lightmapChannels))
+			{
+				debug(LOG_ERROR, "Failed to allocate lightmap update of %dx%d", width, height);
+				continue;
+			}
+			const unsigned char *src = lightmapPixmap->bmp();
+			unsigned char *dst = subImage.bmp_w();
+			for (int row = 0; row < height; ++row)
+			{
+				memcpy(dst + row * width * lightmapChannels, src + ((y1 + row) * lightmapWidth + x1) * lightmapChannels, width * lightmapChannels);
+			}
+			lightmap_texture->upload_sub(0, x1, y1, subImage);
+		}
+	}
 }
 
 static void cullTerrain()
 {
+	bool changed = false;
 	for (int x = 0; x < xSectors; x++)
 	{
 		for (int y = 0; y < ySectors; y++)
@@ -1302,22 +1434,27 @@ static void cullTerrain()
 			float xPos = world_coord(x * sectorSize + sectorSize / 2);
 			float yPos = world_coord(y * sectorSize + sectorSize / 2);
 			float distance = pow(playerPos.p.x - xPos, 2) + pow(playerPos.p.z - yPos, 2);
+			const bool draw = distance <= pow((double)world_coord(terrainDistance), 2);
 
-			if (distance > pow((double)world_coord(terrainDistance), 2))
+			changed |= (sectors[x * ySectors + y].draw != draw);
+			sectors[x * ySectors + y].draw = draw;
+			if (draw && sectors[x * ySectors + y].dirty)
 			{
-				sectors[x * ySectors + y].draw = false;
-			}
-			else
-			{
-				sectors[x * ySectors + y].draw = true;
-				if (sectors[x * ySectors + y].dirty)
-				{
-					updateSectorGeometry(x, y);
-					sectors[x * ySectors + y].dirty = false;
-				}
+				updateSectorGeometry(x, y);
+				sectors[x * ySectors + y].dirty = false;
+				changed = true;
 			}
 		}
 	}
+	if (changed)
+	{
+		++terrainGeometryGeneration;
+	}
+}
+
+uint64_t getTerrainGeometryGeneration()
+{
+	return terrainGeometryGeneration;
 }
 
 static void drawDepthOnly(const glm::mat4 &ModelViewProjection, const glm::vec4 &paramsXLight, const glm::vec4 &paramsYLight, bool withOffset)
@@ -1497,8 +1634,6 @@ void perFrameTerrainUpdates(const LightMap& lightMap)
 	{
 		lightmapLastUpdate = realTime;
 		updateLightMap(lightMap);
-
-		lightmap_texture->upload(0, *(lightmapPixmap.get()));
 	}
 
 	///////////////////////////////////
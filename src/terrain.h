@@ -49,6 +49,12 @@ const glm::mat4& getModelUVLightmapMatrix();
 
 void markTileDirty(int i, int j);
 void dirtyAllSectors();
+/// Changes whenever the geometry of the drawn terrain sectors changes, or other sectors get drawn
+uint64_t getTerrainGeometryGeneration();
+
+/// Mark the lightmap of tiles x1 <= i <= x2, y1 <= j <= y2 to be updated on the next refresh
+void markLightmapDirty(int x1, int y1, int x2, int y2);
+void dirtyAllLightmap();
 
 enum TerrainShaderType
 {
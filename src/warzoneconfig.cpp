@@ -79,6 +79,7 @@ struct WARZONE_GLOBALS
 	int autoDesyncKickSeconds = 10;
 	int autoNotReadyKickSeconds = 0;
 	bool disableReplayRecording = false;
+	bool binarySaveGames = true;
 	int maxReplaysSaved = MAX_REPLAY_FILES;
 	int oldLogsLimit = MAX_OLD_LOGS;
 	uint32_t MPinactivityMinutes = 5;
@@ -101,6 +102,7 @@ struct WARZONE_GLOBALS
 	uint32_t shadowFilteringMode = 1;
 	uint32_t shadowFilterSize = 5;
 	uint32_t shadowMapResolution = 0; // this defaults to 0, which causes the gfx backend to figure out a recommended default based on the system properties
+	uint32_t textureStreamingBudget = 0; // MiB; 0 loads all model textures at full resolution
 	bool pointLightLighting = false;
 	// UI config
 	bool groupsMenuEnabled = true;
@@ -551,6 +553,16 @@ void war_setDisableReplayRecording(bool disable)
 	warGlobs.disableReplayRecording = disable;
 }
 
+bool war_getBinarySaveGames()
+{
+	return warGlobs.binarySaveGames;
+}
+
+void war_setBinarySaveGames(bool enabled)
+{
+	warGlobs.binarySaveGames = enabled;
+}
+
 int war_getMaxReplaysSaved()
 {
 	return warGlobs.maxReplaysSaved;
@@ -732,6 +744,16 @@ void war_setShadowMapResolution(uint32_t resolution)
 	warGlobs.shadowMapResolution = resolution;
 }
 
+uint32_t war_getTextureStreamingBudget()
+{
+	return warGlobs.textureStreamingBudget;
+}
+
+void war_setTextureStreamingBudget(uint32_t budgetMiB)
+{
+	warGlobs.textureStreamingBudget = budgetMiB;
+}
+
 bool war_getPointLightPerPixelLighting()
 {
 	return warGlobs.pointLightLighting;
@@ -152,6 +152,8 @@ int war_getAutoNotReadyKickSeconds();
 void war_setAutoNotReadyKickSeconds(int seconds);
 bool war_getDisableReplayRecording();
 void war_setDisableReplayRecording(bool disable);
+bool war_getBinarySaveGames();
+void war_setBinarySaveGames(bool enabled);
 int war_getMaxReplaysSaved();
 void war_setMaxReplaysSaved(int maxReplaysSaved);
 int war_getOldLogsLimit();
@@ -179,6 +181,8 @@ uint32_t war_getShadowFilterSize();
 void war_setShadowFilterSize(uint32_t filterSize);
 uint32_t war_getShadowMapResolution();
 void war_setShadowMapResolution(uint32_t resolution);
+uint32_t war_getTextureStreamingBudget();
+void war_setTextureStreamingBudget(uint32_t budgetMiB);
 
 bool war_getPointLightPerPixelLighting();
 void war_setPointLightPerPixelLighting(bool perPixelEnabled);
@@ -82,6 +82,8 @@
 #include "gamehistorylogger.h"
 #include "hci/quickchat.h"
 #include "screens/guidescreen.h"
+#include "scriptstatebinary.h"
+#include "fpathregion.h"
 
 #include <list>
 #include <cmath>
@@ -199,6 +201,17 @@ bool wzapi::scripting_instance::loadFileForInclude(const std::string& filePath,
 	return true;
 }
 
+bool wzapi::scripting_instance::saveScriptGlobalsBinary(ScriptStateWriter &writer)
+{
+	nlohmann::json result = nlohmann::json::object();
+	if (!saveScriptGlobals(result))
+	{
+		return false;
+	}
+	writer.writeJson(result);
+	return true;
+}
+
 std::unordered_map<std::string, wzapi::scripting_instance::DebugSpecialStringType> wzapi::scripting_instance::debugGetScriptGlobalSpecialStringValues()
 {
 	return {};
@@ -1040,16 +1053,31 @@ std::vector<const STRUCTURE *> _enumStruct_fromList(WZAPI_PARAMS(optional<int> _
 
 	SCRIPT_ASSERT_PLAYER({}, context, player);
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS, "Player filter index out of range: %d", playerFilter);
-	for (STRUCTURE *psStruct : psStructLists[player])
+	auto addMatches = [&matches, playerFilter](const auto &candidates) {
+		for (STRUCTURE *psStruct : candidates)
+		{
+			if ((playerFilter == ALL_PLAYERS || psStruct->visible[playerFilter]) && !psStruct->died)
+			{
+				matches.push_back(psStruct);
+			}
+		}
+	};
+	if (!statsName.isEmpty())
 	{
-		if ((playerFilter == ALL_PLAYERS || psStruct->visible[playerFilter])
-		    && !psStruct->died
-		    && (type == NUM_DIFF_BUILDINGS || type == psStruct->pStructureType->type)
-		    && (statsName.isEmpty() || statsName.compare(psStruct->pStructureType->id) == 0))
+		const STRUCTURE_STATS *psStats = getStructStatsFromName(statsName);
+		if (psStats)
 		{
-			matches.push_back(psStruct);
+			addMatches(objmemStructuresOfStats(psStructLists, player, psStats));
 		}
 	}
+	else if (type != NUM_DIFF_BUILDINGS)
+	{
+		addMatches(objmemStructuresOfType(psStructLists, player, type));
+	}
+	else
+	{
+		addMatches(psStructLists[player]);
+	}
 
 	return matches;
 }
@@ -1115,14 +1143,22 @@ std::vector<const DROID *> wzapi::enumDroid(WZAPI_PARAMS(optional<int> _player,
 	}
 	SCRIPT_ASSERT_PLAYER({}, context, player);
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS, "Player filter index out of range: %d", playerFilter);
-	for (DROID *psDroid : apsDroidLists[player])
-	{
-		if ((playerFilter == ALL_PLAYERS || psDroid->visible[playerFilter])
-		    && !psDroid->died
-		    && (droidType == DROID_ANY || droidType == psDroid->droidType || droidType2 == psDroid->droidType))
+	auto addMatches = [&matches, playerFilter](const auto &candidates) {
+		for (DROID *psDroid : candidates)
 		{
-			matches.push_back(psDroid);
+			if ((playerFilter == ALL_PLAYERS || psDroid->visible[playerFilter]) && !psDroid->died)
+			{
+				matches.push_back(psDroid);
+			}
 		}
+	};
+	if (droidType == DROID_ANY)
+	{
+		addMatches(apsDroidLists[player]);
+	}
+	else
+	{
+		addMatches(objmemDroidsOfType(apsDroidLists, player, droidType, droidType2));
 	}
 	return matches;
 }
@@ -1143,14 +1179,22 @@ std::vector<const FEATURE *> wzapi::enumFeature(WZAPI_PARAMS(int playerFilter, o
 	}
 
 	std::vector<const FEATURE *> matches;
-	for (const FEATURE *psFeat : apsFeatureLists[0])
-	{
-		if ((playerFilter == ALL_PLAYERS || psFeat->visible[playerFilter])
-		    && !psFeat->died
-		    && (featureName.isEmpty() || featureName.compare(psFeat->psStats->id) == 0))
+	auto addMatches = [&matches, playerFilter](const auto &candidates) {
+		for (const FEATURE *psFeat : candidates)
 		{
-			matches.push_back(psFeat);
+			if ((playerFilter == ALL_PLAYERS || psFeat->visible[playerFilter]) && !psFeat->died)
+			{
+				matches.push_back(psFeat);
+			}
 		}
+	};
+	if (featureName.isEmpty())
+	{
+		addMatches(apsFeatureLists[0]);
+	}
+	else if (const FEATURE_STATS *psStats = getFeatureStatsFromName(featureName))
+	{
+		addMatches(objmemFeaturesOfStats(apsFeatureLists, psStats));
 	}
 	return matches;
 }
@@ -1272,9 +1316,9 @@ std::vector<const BASE_OBJECT *> wzapi::enumRange(WZAPI_PARAMS(int _x, int _y, i
 
 	SCRIPT_ASSERT({}, context, (playerFilter >= 0 && playerFilter < MAX_PLAYERS) || playerFilter == ALL_PLAYERS || playerFilter == ALLIES || playerFilter == ENEMIES, "Filter player index out of range: %d", playerFilter);
 
-	static GridList gridList;  // static to avoid allocations. // WARNING: THREAD-SAFETY
-	gridList = gridStartIterate(x, y, range);
+	GridList const &gridList = gridStartIterate(x, y, range); // only valid until the next grid query
 	std::vector<const BASE_OBJECT *> list;
+	list.reserve(gridList.size());
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		const BASE_OBJECT *psObj = *gi;
@@ -1515,18 +1559,9 @@ static bool structDoubleCheck(BASE_STATS *psStat, UDWORD xx, UDWORD yy, SDWORD m
 	yBR = (yy + psBuilding->baseBreadth);
 
 	// check against building in a gateway, as this can seriously block AI passages
-	for (auto psGate : gwGetGateways())
+	if (buildableAreaHasGateway(xx, yy, xBR, yBR))
 	{
-		for (x = xx; x <= xBR; x++)
-		{
-			for (y = yy; y <= yBR; y++)
-			{
-				if (x >= psGate->x1 && x <= psGate->x2 && y >= psGate->y1 && y <= psGate->y2)
-				{
-					return false;
-				}
-			}
-		}
+		return false;
 	}
 
 	// can you get past it?
@@ -1608,7 +1643,8 @@ optional<scr_position> wzapi::pickStructLocation(WZAPI_PARAMS(const DROID *psDro
 	PROPULSION_TYPE propType = (psDroid) ? psDroid->getPropulsionStats()->propulsionType : PROPULSION_TYPE_WHEELED;
 
 	// save a lot of typing... checks whether a position is valid
-#define LOC_OK(_x, _y) (tileOnMap(_x, _y) && \
+	// (buildableAreaMayFit() quickly rules out most positions in a crowded base, before the full checks scan the area)
+#define LOC_OK(_x, _y) (tileOnMap(_x, _y) && buildableAreaMayFit(psStat, _x, _y, player) && \
                         (!psDroid || fpathCheck(psDroid->pos, Vector3i(world_coord(_x), world_coord(_y), 0), propType)) \
                         && validLocation(psStat, world_coord(Vector2i(_x, _y)) + offset, 0, player, false) && structDoubleCheck(psStat, _x, _y, maxBlockingTiles, propType))
 
@@ -1694,31 +1730,59 @@ bool wzapi::structureCanFit(WZAPI_PARAMS(std::string structureName, int x, int y
 			&& validLocation(psStat, world_coord(Vector2i(x, y)), direction, player, false));
 }
 
-//-- ## droidCanReach(droid, x, y)
+//-- ## droidCanReach(droid, x, y[, aroundStructures])
 //--
 //-- Return whether or not the given droid could possibly drive to the given position. Does
-//-- not take player built blockades into account.
+//-- not take player built blockades into account, unless ```aroundStructures``` is true. Then
+//-- the droid must be able to get there without passing structures, other than gates that open
+//-- for it. (```aroundStructures``` 4.6+ only)
 //--
-bool wzapi::droidCanReach(WZAPI_PARAMS(const DROID *psDroid, int x, int y))
+bool wzapi::droidCanReach(WZAPI_PARAMS(const DROID *psDroid, int x, int y, optional<bool> _aroundStructures))
 {
 	SCRIPT_ASSERT(false, context, psDroid, "No valid droid provided");
 	const PROPULSION_STATS* psPropStats = psDroid->getPropulsionStats();
+	if (_aroundStructures.value_or(false))
+	{
+		return fpathRegionCheck(psDroid->pos, Vector3i(world_coord(x), world_coord(y), 0), psPropStats->propulsionType, psDroid->player);
+	}
 	return fpathCheck(psDroid->pos, Vector3i(world_coord(x), world_coord(y), 0), psPropStats->propulsionType);
 }
 
-//-- ## propulsionCanReach(propulsionName, x1, y1, x2, y2)
+//-- ## propulsionCanReach(propulsionName, x1, y1, x2, y2[, player])
 //--
 //-- Return true if a droid with a given propulsion is able to travel from (x1, y1) to (x2, y2).
-//-- Does not take player built blockades into account. (3.2+ only)
+//-- Does not take player built blockades into account, unless a player is given. Then the droid of
+//-- that player must be able to get there without passing structures, other than gates that open
+//-- for it. (3.2+ only, ```player``` 4.6+ only)
 //--
-bool wzapi::propulsionCanReach(WZAPI_PARAMS(std::string propulsionName, int x1, int y1, int x2, int y2))
+bool wzapi::propulsionCanReach(WZAPI_PARAMS(std::string propulsionName, int x1, int y1, int x2, int y2, optional<int> _player))
 {
 	int propulsionIndex = getCompFromName(COMP_PROPULSION, WzString::fromUtf8(propulsionName));
 	SCRIPT_ASSERT(false, context, propulsionIndex > 0, "No such propulsion: %s", propulsionName.c_str());
 	const PROPULSION_STATS *psPropStats = &asPropulsionStats[propulsionIndex];
+	if (_player.has_value())
+	{
+		SCRIPT_ASSERT_PLAYER(false, context, _player.value());
+		return fpathRegionCheck(Vector3i(world_coord(x1), world_coord(y1), 0), Vector3i(world_coord(x2), world_coord(y2), 0), psPropStats->propulsionType, _player.value());
+	}
 	return fpathCheck(Vector3i(world_coord(x1), world_coord(y1), 0), Vector3i(world_coord(x2), world_coord(y2), 0), psPropStats->propulsionType);
 }
 
+//-- ## droidRouteDistance(droid, x, y)
+//--
+//-- Return an estimate of how far, in tiles, the given droid would have to drive to get to the given
+//-- position, going around structures other than gates that open for it. Returns -1 if it cannot
+//-- get there. This is far cheaper than finding the actual path, but the estimate may be some tiles
+//-- off. (4.6+ only)
+//--
+int wzapi::droidRouteDistance(WZAPI_PARAMS(const DROID *psDroid, int x, int y))
+{
+	SCRIPT_ASSERT(-1, context, psDroid, "No valid droid provided");
+	const PROPULSION_STATS* psPropStats = psDroid->getPropulsionStats();
+	int dist = fpathRegionDistance(psDroid->pos, Vector3i(world_coord(x), world_coord(y), 0), psPropStats->propulsionType, psDroid->player);
+	return (dist < 0) ? -1 : (dist + TILE_UNITS / 2) / TILE_UNITS;
+}
+
 //-- ## terrainType(x, y)
 //--
 //-- Returns tile type of a given map tile, such as ```TER_WATER``` for water tiles or ```TER_CLIFFFACE``` for cliffs.
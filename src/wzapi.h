@@ -67,6 +67,8 @@ using nonstd::nullopt;
 #include <functional>
 
 typedef uint64_t uniqueTimerID;
+class ScriptStateWriter;
+
 class timerAdditionalData
 {
 public:
@@ -632,6 +634,8 @@ namespace wzapi
 		// save / restore state
 		virtual bool saveScriptGlobals(nlohmann::json &result) = 0;
 		virtual bool loadScriptGlobals(const nlohmann::json &result) = 0;
+		// writes the same globals as saveScriptGlobals(), as one (object) value; what it writes is loaded with loadScriptGlobals()
+		virtual bool saveScriptGlobalsBinary(ScriptStateWriter &writer);
 
 		virtual nlohmann::json saveTimerFunction(uniqueTimerID timerID, std::string timerName, const timerAdditionalData* additionalParam) = 0;
 
@@ -648,6 +652,11 @@ namespace wzapi
 
 		virtual bool debugEvaluateCommand(const std::string &text) = 0;
 
+		// sampling profiler: time spent (in microseconds) per call stack, as ';'-separated function names (outermost first)
+		virtual void setProfilingEnabled(bool enabled) { }
+		virtual std::unordered_map<std::string, uint64_t> debugGetProfileSamples() const { return {}; }
+		virtual void debugResetProfileSamples() { }
+
 	public:
 		// output to debug log file
 		void dumpScriptLog(const std::string &info);
@@ -1042,8 +1051,9 @@ namespace wzapi
 	bool isStructureAvailable(WZAPI_PARAMS(std::string structureName, optional<int> _player));
 	optional<scr_position> pickStructLocation(WZAPI_PARAMS(const DROID *psDroid, std::string structureName, int startX, int startY, optional<int> _maxBlockingTiles));
 	bool structureCanFit(WZAPI_PARAMS(std::string structureName, int x, int y, optional<float> _direction));
-	bool droidCanReach(WZAPI_PARAMS(const DROID *psDroid, int x, int y));
-	bool propulsionCanReach(WZAPI_PARAMS(std::string propulsionName, int x1, int y1, int x2, int y2));
+	bool droidCanReach(WZAPI_PARAMS(const DROID *psDroid, int x, int y, optional<bool> _aroundStructures));
+	bool propulsionCanReach(WZAPI_PARAMS(std::string propulsionName, int x1, int y1, int x2, int y2, optional<int> _player));
+	int droidRouteDistance(WZAPI_PARAMS(const DROID *psDroid, int x, int y));
 	int terrainType(WZAPI_PARAMS(int x, int y));
 	bool tileIsBurning(WZAPI_PARAMS(int x, int y));
 	bool orderDroidObj(WZAPI_PARAMS(DROID *psDroid, int _order, BASE_OBJECT *psObj));
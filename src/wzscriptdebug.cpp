@@ -2537,6 +2537,185 @@ public:
 	std::vector<size_t> currentMaxColumnWidths;
 };
 
+// MARK: - WzScriptProfilePanel
+
+class WzScriptProfilePanel : public W_FORM
+{
+public:
+	WzScriptProfilePanel(): W_FORM() {}
+	~WzScriptProfilePanel() {}
+public:
+	virtual void display(int xOffset, int yOffset) override
+	{
+		// no background
+	}
+	virtual void geometryChanged() override
+	{
+		for (auto& button : bottomButtons)
+		{
+			button->callCalcLayout();
+		}
+		statusLabel->callCalcLayout();
+		table->callCalcLayout();
+	}
+public:
+	static std::shared_ptr<WzScriptProfilePanel> make()
+	{
+		auto result = std::make_shared<WzScriptProfilePanel>();
+
+		// Add "Profile:" label
+		auto contextLabel = std::make_shared<W_LABEL>();
+		contextLabel->setFont(font_regular_bold, WZCOL_FORM_TEXT);
+		contextLabel->setString("Profile:");
+		contextLabel->setGeometry(0, 0, contextLabel->getMaxLineWidth() + 10, TAB_BUTTONS_HEIGHT);
+		contextLabel->setCacheNeverExpires(true);
+		result->attach(contextLabel);
+
+		// Add status label (whether profiling, where the profile was saved)
+		result->statusLabel = std::make_shared<W_LABEL>();
+		result->statusLabel->setFont(font_regular, WZCOL_FORM_TEXT);
+		result->statusLabel->setGeometry(contextLabel->width(), 0, 0, TAB_BUTTONS_HEIGHT);
+		result->attach(result->statusLabel);
+		result->statusLabel->setCalcLayout(LAMBDA_CALCLAYOUT_SIMPLE({
+			auto psParent = std::dynamic_pointer_cast<WzScriptProfilePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			psWidget->setGeometry(psWidget->x(), psWidget->y(), psParent->width() - psWidget->x(), psWidget->height());
+		}));
+
+		// Create bottom buttons
+		std::shared_ptr<W_BUTTON> previousRowButton;
+		std::weak_ptr<WzScriptProfilePanel> psWeakParent = result;
+		auto addBottomButton = [&previousRowButton, &result, psWeakParent](const char *text, const std::function<void (WzScriptProfilePanel&)>& onClickFunc){
+			previousRowButton = result->createBottomButton(text, [psWeakParent, onClickFunc]() {
+				if (auto psParent = psWeakParent.lock())
+				{
+					onClickFunc(*psParent);
+				}
+			}, previousRowButton);
+			result->bottomButtons.push_back(previousRowButton);
+		};
+		addBottomButton("Start / Stop", [](WzScriptProfilePanel& panel) {
+			jsSetProfiling(!jsProfilingEnabled());
+			panel.populateProfile();
+		});
+		addBottomButton("Refresh", [](WzScriptProfilePanel& panel) {
+			panel.populateProfile();
+		});
+		addBottomButton("Reset", [](WzScriptProfilePanel& panel) {
+			jsResetProfile();
+			panel.populateProfile();
+		});
+		addBottomButton("Save Folded Stacks", [](WzScriptProfilePanel& panel) {
+			std::string filename = jsSaveProfile();
+			panel.populateProfile();
+			panel.statusLabel->setString(WzString::fromUtf8((!filename.empty()) ? "Saved to: " + filename : std::string("Failed to save profile")));
+		});
+
+		// Create column headers for Profile table
+		std::vector<TableColumn> columns {
+			{createColHeaderLabel("Script"), TableColumn::ResizeBehavior::RESIZABLE},
+			{createColHeaderLabel("Function"), TableColumn::ResizeBehavior::RESIZABLE},
+			{createColHeaderLabel("Self (ms)"), TableColumn::ResizeBehavior::RESIZABLE},
+			{createColHeaderLabel("Total (ms)"), TableColumn::ResizeBehavior::RESIZABLE}
+		};
+		std::vector<size_t> minimumColumnWidths;
+		for (auto& column : columns)
+		{
+			minimumColumnWidths.push_back(static_cast<size_t>(std::max<int>(std::dynamic_pointer_cast<W_LABEL>(column.columnWidget)->getMaxLineWidth(), 0)));
+		}
+
+		// Create + attach "Profile" scrollable table view
+		result->table = ScrollableTableWidget::make(columns);
+		result->attach(result->table);
+		result->table->setMinimumColumnWidths(minimumColumnWidths);
+		result->table->setCalcLayout(LAMBDA_CALCLAYOUT_SIMPLE({
+			auto psParent = std::dynamic_pointer_cast<WzScriptProfilePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			int oldWidth = psWidget->width();
+			int y0 = TAB_BUTTONS_HEIGHT + ACTION_BUTTON_ROW_SPACING;
+			int height = ((!psParent->bottomButtons.empty()) ? psParent->bottomButtons[0]->y() - ACTION_BUTTON_ROW_SPACING : psParent->height()) - y0;
+			psWidget->setGeometry(0, y0, psParent->width(), height);
+
+			if (oldWidth != psWidget->width())
+			{
+				psParent->resizeTableColumnWidths();
+			}
+		}));
+
+		result->currentMaxColumnWidths = minimumColumnWidths;
+		result->populateProfile();
+
+		return result;
+	}
+public:
+	void populateProfile()
+	{
+		statusLabel->setString((jsProfilingEnabled()) ? "Sampling script functions" : "Not sampling");
+		RowDataModel model(4);
+		for (const auto &entry : jsProfileSummary())
+		{
+			std::vector<WzString> columnTexts = {
+				WzString::fromUtf8(entry.script),
+				WzString::fromUtf8(entry.function),
+				WzString::format("%.1f", entry.selfTime / 1000.0),
+				WzString::format("%.1f", entry.totalTime / 1000.0)
+			};
+			model.newRow(columnTexts, SCRIPTDEBUG_ROW_HEIGHT);
+		}
+		auto oldScrollPosition = table->getScrollPosition();
+		table->clearRows();
+		if (!model.rows().empty())
+		{
+			for (auto& row : model.rows())
+			{
+				table->addRow(row);
+			}
+			currentMaxColumnWidths = model.currentMaxColumnWidths();
+			table->changeColumnWidths(model.currentMaxColumnWidths());
+			table->setScrollPosition(oldScrollPosition);
+		}
+	}
+private:
+	static std::shared_ptr<W_LABEL> createColHeaderLabel(const char* text)
+	{
+		auto label = std::make_shared<W_LABEL>();
+		label->setString(text);
+		label->setGeometry(0, 0, label->getMaxLineWidth(), 0);
+		label->setCacheNeverExpires(true);
+		return label;
+	}
+	void resizeTableColumnWidths()
+	{
+		table->changeColumnWidths(currentMaxColumnWidths);
+	}
+	std::shared_ptr<W_BUTTON> createBottomButton(const std::string &text, const std::function<void ()>& onClickFunc, const std::shared_ptr<W_BUTTON>& previousButton = nullptr)
+	{
+		auto button = makeDebugButton(text.c_str());
+		button->setGeometry(button->x(), button->y(), button->width() + 10, button->height());
+		attach(button);
+		button->addOnClickHandler([onClickFunc](W_BUTTON& button) {
+			widgScheduleTask([onClickFunc](){
+				onClickFunc();
+			});
+		});
+		int previousButtonRight = (previousButton) ? previousButton->x() + previousButton->width() : 0;
+		button->move((previousButtonRight > 0) ? previousButtonRight + ACTION_BUTTON_SPACING : 0, height() - button->height());
+		button->setCalcLayout([](WIDGET *psWidget) {
+			auto psParent = std::dynamic_pointer_cast<WzScriptProfilePanel>(psWidget->parent());
+			ASSERT_OR_RETURN(, psParent != nullptr, "No parent");
+			psWidget->move(psWidget->x(), psParent->height() - psWidget->height());
+		});
+
+		return button;
+	}
+
+public:
+	std::shared_ptr<W_LABEL> statusLabel;
+	std::vector<std::shared_ptr<W_BUTTON>> bottomButtons;
+	std::shared_ptr<ScrollableTableWidget> table;
+	std::vector<size_t> currentMaxColumnWidths;
+};
+
 // MARK: - WZScriptDebugger
 
 std::shared_ptr<W_BUTTON> WZScriptDebugger::createButton(int row, const std::string &text, const std::function<void ()>& onClickFunc, const std::shared_ptr<WIDGET>& parent, const std::shared_ptr<W_BUTTON>& previousButton /*= nullptr*/)
@@ -2600,6 +2779,9 @@ void WZScriptDebugger::switchPanel(WZScriptDebugger::ScriptDebuggerPanel newPane
 		case ScriptDebuggerPanel::Labels:
 			psPanel = createLabelsPanel();
 			break;
+		case ScriptDebuggerPanel::Profile:
+			psPanel = createProfilePanel();
+			break;
 		case ScriptDebuggerPanel::Graphics:
 			psPanel = createGraphicsPanel();
 			break;
@@ -2711,6 +2893,11 @@ std::shared_ptr<WIDGET> WZScriptDebugger::createLabelsPanel()
 	return WzScriptLabelsPanel::make(std::dynamic_pointer_cast<WZScriptDebugger>(shared_from_this()));
 }
 
+std::shared_ptr<WIDGET> WZScriptDebugger::createProfilePanel()
+{
+	return WzScriptProfilePanel::make();
+}
+
 std::shared_ptr<WZScriptDebugger> WZScriptDebugger::make(const std::shared_ptr<scripting_engine::DebugInterface>& debugInterface, bool readOnly)
 {
 	auto result = std::make_shared<WZScriptDebugger>(debugInterface, readOnly);
@@ -2776,6 +2963,7 @@ std::shared_ptr<WZScriptDebugger> WZScriptDebugger::make(const std::shared_ptr<s
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Triggers, "Triggers");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Messages, "Messages");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Labels, "Labels");
+	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Profile, "Profile");
 	addTextTabButton(result->pageTabs, ScriptDebuggerPanel::Graphics, "Graphics");
 	result->pageTabs->addOnChooseHandler([](MultibuttonWidget& widget, int newValue){
 		// Switch actively-displayed "tab"
@@ -82,6 +82,7 @@ private:
 	std::shared_ptr<WIDGET> createTriggersPanel();
 	std::shared_ptr<WIDGET> createMessagesPanel();
 	std::shared_ptr<WIDGET> createLabelsPanel();
+	std::shared_ptr<WIDGET> createProfilePanel();
 	std::shared_ptr<W_FORM> createGraphicsPanel();
 
 private:
@@ -93,6 +94,7 @@ private:
 		Triggers,
 		Messages,
 		Labels,
+		Profile,
 		Graphics
 	};
 	static void addTextTabButton(const std::shared_ptr<MultibuttonWidget>& mbw, ScriptDebuggerPanel value, const char* text);
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <limits>
+#include <vector>
+#include "src/scriptstatebinary.h"
+
+// Round trip of the saved script globals: the values are emitted to a ScriptStateWriter and to a
+// ScriptStateJsonBuilder, as the script backend does when saving, and the decoded binary must match the json.
+
+static int failures = 0;
+
+template <typename Sink>
+static void emitGlobals(Sink &sink)
+{
+	sink.beginObject();
+	sink.writeKey("name");
+	sink.writeString("Commander");
+	sink.writeKey("empty");
+	sink.writeString("");
+	sink.writeKey("unicode");
+	sink.writeString("\xc3\xa9t\xc3\xa9 \xe2\x9c\x93");
+	sink.writeKey("flag");
+	sink.writeBool(true);
+	sink.writeKey("other");
+	sink.writeBool(false);
+	sink.writeKey("nothing");
+	sink.writeNull();
+	sink.writeKey("small");
+	sink.writeInt(-1);
+	sink.writeKey("min");
+	sink.writeInt(std::numeric_limits<int32_t>::min());
+	sink.writeKey("max");
+	sink.writeInt(std::numeric_limits<int32_t>::max());
+	sink.writeKey("huge");
+	sink.writeUnsigned(std::numeric_limits<uint64_t>::max());
+	sink.writeKey("fraction");
+	sink.writeDouble(0.1);
+	sink.writeKey("large");
+	sink.writeDouble(-1.5e300);
+	sink.writeKey("list");
+	sink.beginArray();
+	for (int i = 0; i < 3; ++i)
+	{
+		sink.beginObject();
+		sink.writeKey("name"); // same key and value strings again, written as references
+		sink.writeString("Commander");
+		sink.writeKey("index");
+		sink.writeInt(i);
+		sink.end();
+	}
+	sink.beginArray();
+	sink.end();
+	sink.beginObject();
+	sink.end();
+	sink.end();
+	sink.end();
+}
+
+template <typename Sink>
+static void emitScalar(Sink &sink)
+{
+	sink.writeString("name"); // a top level string, referring to a key of the previous block
+}
+
+static void check(bool condition, const char *what)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "scriptstatetest: %s\n", what);
+		++failures;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	ScriptStateWriter writer;
+	std::vector<nlohmann::json> expected;
+
+	ScriptStateJsonBuilder globals;
+	emitGlobals(globals);
+	expected.push_back(globals.result());
+	emitGlobals(writer);
+
+	// a value that turns out not to be convertible is dropped, including the strings it introduced
+	ScriptStateWriter::Checkpoint point = writer.checkpoint();
+	writer.beginArray();
+	writer.writeString("dropped");
+	writer.writeString("Commander");
+	writer.rollback(point);
+
+	ScriptStateJsonBuilder scalar;
+	emitScalar(scalar);
+	expected.push_back(scalar.result());
+	emitScalar(writer);
+
+	writer.writeJson(expected[0]);
+	expected.push_back(expected[0]);
+
+	std::vector<nlohmann::json> blocks;
+	const std::vector<uint8_t> &data = writer.data();
+	check(readScriptStateBlocks(data.data(), data.size(), blocks), "failed to read the written data");
+	check(blocks.size() == expected.size(), "wrong number of blocks");
+	for (size_t i = 0; i < blocks.size() && i < expected.size(); ++i)
+	{
+		if (blocks[i] != expected[i])
+		{
+			fprintf(stderr, "scriptstatetest: block %zu differs:\n%s\n%s\n", i, blocks[i].dump().c_str(), expected[i].dump().c_str());
+			++failures;
+		}
+	}
+
+	// truncated data must be rejected, not read past
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		std::vector<uint8_t> truncated(data.begin(), data.begin() + size);
+		std::vector<nlohmann::json> partial;
+		if (readScriptStateBlocks(truncated.data(), truncated.size(), partial))
+		{
+			check(partial.size() < expected.size(), "truncated data read as complete");
+		}
+	}
+
+	if (failures == 0)
+	{
+		printf("scriptstatetest: passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Crunch a batch of replays through headless Warzone 2100 instances in parallel.
+#
+# Each replay is run in its own process with --replay-crunch, which simulates the
+# replay as fast as possible and quits once it ends. The game history reports
+# (__REPORT__ frames and the final __REPORTextended__) are written to
+# <output-dir>/<replay name>.log, and the simulation throughput is printed.
+
+import argparse
+import concurrent.futures
+import os
+import re
+import subprocess
+import sys
+
+FINISHED_RE = re.compile(r'WZEVENT: replayCrunchFinished: (\d+) (\d+) ([0-9.]+) ([0-9.]+)')
+
+
+def crunch_replay(binary, replay, output_dir, frame_interval, extra_args):
+    name = os.path.splitext(os.path.basename(replay))[0]
+    cmd = [binary, '--headless', '--replay-crunch', '--loadreplay=' + replay,
+           '--enablecmdinterface=stdin', '--gamelog-output=cmdinterface',
+           '--gamelog-frameinterval=' + str(frame_interval)] + extra_args
+    proc = subprocess.run(cmd, stdin=subprocess.PIPE, stdout=subprocess.DEVNULL,
+                          stderr=subprocess.PIPE, universal_newlines=True, errors='replace')
+    result = {'replay': replay, 'returncode': proc.returncode, 'ticks': 0, 'seconds': 0.0, 'ticksPerSecond': 0.0}
+    with open(os.path.join(output_dir, name + '.log'), 'w') as log:
+        for line in proc.stderr.splitlines():
+            if '__REPORT' in line:
+                log.write(line + '\n')
+            match = FINISHED_RE.search(line)
+            if match:
+                result['ticks'] = int(match.group(2))
+                result['seconds'] = float(match.group(3))
+                result['ticksPerSecond'] = float(match.group(4))
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Crunch Warzone 2100 replays (.wzrp) in parallel headless processes.',
+                                     epilog='Arguments after -- are passed to every warzone2100 process.')
+    parser.add_argument('replays', nargs='+', help='replay files (paths as accepted by --loadreplay)')
+    parser.add_argument('--binary', default='warzone2100', help='path to the warzone2100 executable')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count() or 1, help='number of parallel worker processes')
+    parser.add_argument('--output-dir', default='.', help='directory for the per-replay report logs')
+    parser.add_argument('--frame-interval', type=int, default=15, help='game history frame interval (in game seconds)')
+
+    # Split the pass-through arguments off by hand: argparse would otherwise hand them to the replays list,
+    # and parse intermixed so options may appear between replay files
+    argv = sys.argv[1:]
+    extra_args = []
+    if '--' in argv:
+        split = argv.index('--')
+        argv, extra_args = argv[:split], argv[split + 1:]
+    args = parser.parse_intermixed_args(argv)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+
+    total_ticks = 0
+    failed = 0
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = [pool.submit(crunch_replay, args.binary, r, args.output_dir, args.frame_interval, extra_args) for r in args.replays]
+        for future in concurrent.futures.as_completed(futures):
+            res = future.result()
+            if res['returncode'] != 0 or res['ticks'] == 0:
+                failed += 1
+                print('FAILED  %s (exit code %d)' % (res['replay'], res['returncode']))
+                continue
+            total_ticks += res['ticks']
+            print('%-60s %8d ticks %8.2f s %10.1f ticks/s' % (res['replay'], res['ticks'], res['seconds'], res['ticksPerSecond']))
+
+    print('Total: %d ticks simulated, %d replay(s) failed' % (total_ticks, failed))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())